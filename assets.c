@@ -0,0 +1,513 @@
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "raylib.h"
+#include "assets.h"
+#include "profiler.h"
+
+#define ASSET_MAX_DECODED (ASSET_MAX_SOURCES + ASSET_MAX_FONTS + 1)
+
+// Sprites, sounds and fonts by name; in a bundle the sounds and glyph rectangles point into the mapping
+typedef struct AssetStore {
+    char spriteNames[ASSET_MAX_SOURCES][ASSET_NAME_LENGTH];
+    Sprite sprites[ASSET_MAX_SOURCES];
+    int spriteCount;
+    char soundNames[ASSET_MAX_SOURCES][ASSET_NAME_LENGTH];
+    Wave sounds[ASSET_MAX_SOURCES];
+    int soundCount;
+    char fontNames[ASSET_MAX_FONTS][ASSET_NAME_LENGTH];
+    Font fonts[ASSET_MAX_FONTS];
+    int fontCount;
+    Texture2D atlas;
+} AssetStore;
+
+// CPU-side result of the loader thread, waiting for the main thread to upload it
+typedef struct DecodedAsset {
+    AssetKind kind;
+    char name[ASSET_NAME_LENGTH];
+    Image image; // sprite or font atlas pixels
+    const BundleSprite *sprites; // the atlas table, or NULL for a single loose sprite
+    int spriteCount;
+    Wave wave;
+    Font font; // everything but the texture
+} DecodedAsset;
+
+// The loader thread fills decoded[] in order and publishes it through decodedCount
+typedef struct AssetLoader {
+    pthread_t thread;
+    bool started;
+    bool resident;
+    char bundlePath[ASSET_PATH_LENGTH];
+    char manifestPath[ASSET_PATH_LENGTH];
+    const char *source;
+    DecodedAsset decoded[ASSET_MAX_DECODED];
+    atomic_int decodedCount;
+    atomic_int expectedCount;
+    atomic_bool finished;
+    int uploadedCount;
+    double startTime;
+    unsigned char *mapping; // NULL when the loose files were loaded
+    size_t mappingSize;
+} AssetLoader;
+
+static AssetStore store;
+static AssetLoader loader;
+
+int ReadAssetManifest(const char *path, AssetSource *sources, int maxSources) {
+    FILE *file = fopen(path, "r");
+
+    if (file == NULL) {
+        TraceLog(LOG_WARNING, "ASSETS: [%s] Failed to open manifest", path);
+        return -1;
+    }
+
+    char directory[ASSET_PATH_LENGTH / 2];
+    char line[ASSET_PATH_LENGTH];
+    int count = 0;
+
+    snprintf(directory, sizeof(directory), "%s", GetDirectoryPath(path));
+
+    while (fgets(line, sizeof(line), file) != NULL && count < maxSources) {
+        AssetSource *source = &sources[count];
+        char kind[16];
+        char relative[ASSET_PATH_LENGTH / 2 - 1];
+
+        source->fontSize = 0;
+
+        if (line[0] == '#' || sscanf(line, "%15s %31s %126s %d", kind, source->name, relative, &source->fontSize) < 3) {
+            continue;
+        }
+
+        if (strcmp(kind, "sprite") == 0) {
+            source->kind = ASSET_SPRITE;
+        } else if (strcmp(kind, "sound") == 0) {
+            source->kind = ASSET_SOUND;
+        } else if (strcmp(kind, "font") == 0 && source->fontSize > 0) {
+            source->kind = ASSET_FONT;
+        } else {
+            TraceLog(LOG_WARNING, "ASSETS: [%s] Skipping manifest line: %s", path, line);
+            continue;
+        }
+
+        snprintf(source->path, sizeof(source->path), "%s/%s", directory, relative);
+        count++;
+    }
+
+    fclose(file);
+
+    return count;
+}
+
+static void AddSprite(const char *name, Sprite sprite) {
+    if (store.spriteCount < ASSET_MAX_SOURCES) {
+        snprintf(store.spriteNames[store.spriteCount], ASSET_NAME_LENGTH, "%s", name);
+        store.sprites[store.spriteCount++] = sprite;
+    }
+}
+
+static void AddSound(const char *name, Wave wave) {
+    if (store.soundCount < ASSET_MAX_SOURCES) {
+        snprintf(store.soundNames[store.soundCount], ASSET_NAME_LENGTH, "%s", name);
+        store.sounds[store.soundCount++] = wave;
+    }
+}
+
+static void AddFont(const char *name, Font font) {
+    if (store.fontCount < ASSET_MAX_FONTS) {
+        snprintf(store.fontNames[store.fontCount], ASSET_NAME_LENGTH, "%s", name);
+        store.fonts[store.fontCount++] = font;
+    }
+}
+
+
+static DecodedAsset *NextDecoded(AssetKind kind, const char *name) {
+    int count = atomic_load_explicit(&loader.decodedCount, memory_order_relaxed);
+
+    if (count == ASSET_MAX_DECODED) {
+        return NULL;
+    }
+
+    DecodedAsset *asset = &loader.decoded[count];
+    memset(asset, 0, sizeof(DecodedAsset));
+    asset->kind = kind;
+    snprintf(asset->name, ASSET_NAME_LENGTH, "%s", name);
+
+    return asset;
+}
+
+static void PublishDecoded(void) {
+    atomic_fetch_add_explicit(&loader.decodedCount, 1, memory_order_release);
+}
+
+static const BundleEntry *FindBundleEntry(const BundleHeader *header, unsigned int type, const char *name) {
+    const BundleEntry *toc = (const BundleEntry *)(loader.mapping + header->tocOffset);
+
+    for (unsigned int i = 0; i < header->entryCount; i++) {
+        if (toc[i].type == type && strncmp(toc[i].name, name, ASSET_NAME_LENGTH) == 0 &&
+            (size_t)toc[i].offset + toc[i].size <= loader.mappingSize) {
+            return &toc[i];
+        }
+    }
+
+    return NULL;
+}
+
+// Images are found by the name of the sprite or glyph table that uses them; the pixels stay in the mapping
+static bool FindBundleImage(const BundleHeader *header, const char *name, Image *image) {
+    const BundleEntry *entry = FindBundleEntry(header, BUNDLE_IMAGE, name);
+
+    if (entry == NULL) {
+        return false;
+    }
+
+    *image = (Image){ loader.mapping + entry->offset, entry->params[0], entry->params[1], 1, entry->params[2] };
+
+    return entry->size >= (unsigned int)GetPixelDataSize(image->width, image->height, image->format);
+}
+
+static void DecodeBundleEntry(const BundleHeader *header, const BundleEntry *entry) {
+    const unsigned char *data = loader.mapping + entry->offset;
+
+    if (entry->type == BUNDLE_SPRITES) {
+        DecodedAsset *asset = NextDecoded(ASSET_SPRITE, entry->name);
+
+        if (asset != NULL && entry->size >= entry->params[0] * sizeof(BundleSprite) && FindBundleImage(header, entry->name, &asset->image)) {
+            asset->sprites = (const BundleSprite *)data;
+            asset->spriteCount = entry->params[0];
+            PublishDecoded();
+        }
+    } else if (entry->type == BUNDLE_GLYPHS) {
+        DecodedAsset *asset = NextDecoded(ASSET_FONT, entry->name);
+        const BundleGlyph *glyphs = (const BundleGlyph *)data;
+        int count = entry->params[0];
+
+        if (asset != NULL && entry->size >= count * (sizeof(BundleGlyph) + sizeof(Rectangle)) && FindBundleImage(header, entry->name, &asset->image)) {
+            asset->font.baseSize = entry->params[1];
+            asset->font.glyphCount = count;
+            asset->font.glyphPadding = entry->params[2];
+            asset->font.recs = (Rectangle *)(glyphs + count);
+            asset->font.glyphs = MemAlloc(count * sizeof(GlyphInfo));
+
+            // raylib's GlyphInfo embeds an Image, so the metrics cannot be used in place
+            for (int i = 0; i < count; i++) {
+                asset->font.glyphs[i].value = glyphs[i].value;
+                asset->font.glyphs[i].offsetX = glyphs[i].offsetX;
+                asset->font.glyphs[i].offsetY = glyphs[i].offsetY;
+                asset->font.glyphs[i].advanceX = glyphs[i].advanceX;
+            }
+
+            PublishDecoded();
+        }
+    } else if (entry->type == BUNDLE_WAVE) {
+        DecodedAsset *asset = NextDecoded(ASSET_SOUND, entry->name);
+        Wave wave = { entry->params[0], entry->params[1], entry->params[2], entry->params[3], (void *)data };
+
+        if (asset != NULL && (size_t)wave.frameCount * wave.channels * (wave.sampleSize / 8) <= entry->size) {
+            asset->wave = wave;
+            PublishDecoded();
+        }
+    }
+}
+
+// Nothing in a bundle needs decoding; the loader maps it and faults the pages in so uploads never wait on the disk
+static bool DecodeBundle(const char *path) {
+    struct stat info;
+    int fd = open(path, O_RDONLY);
+
+    if (fd < 0 || fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(BundleHeader)) {
+        TraceLog(LOG_WARNING, "ASSETS: [%s] Failed to open bundle", path);
+
+        if (fd >= 0) {
+            close(fd);
+        }
+
+        return false;
+    }
+
+    void *mapping = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+    close(fd);
+
+    if (mapping == MAP_FAILED) {
+        TraceLog(LOG_WARNING, "ASSETS: [%s] Failed to map bundle", path);
+        return false;
+    }
+
+    const BundleHeader *header = mapping;
+    size_t tocEnd = header->tocOffset + (size_t)header->entryCount * sizeof(BundleEntry);
+
+    if (header->magic != ASSET_BUNDLE_MAGIC || header->version != ASSET_BUNDLE_VERSION || tocEnd > (size_t)info.st_size) {
+        TraceLog(LOG_WARNING, "ASSETS: [%s] Not a version %d bundle", path, ASSET_BUNDLE_VERSION);
+        munmap(mapping, info.st_size);
+        return false;
+    }
+
+    loader.mapping = mapping;
+    loader.mappingSize = info.st_size;
+    loader.source = loader.bundlePath;
+
+    const BundleEntry *toc = (const BundleEntry *)(loader.mapping + header->tocOffset);
+    int expected = 0;
+
+    for (unsigned int i = 0; i < header->entryCount; i++) {
+        expected += toc[i].type != BUNDLE_IMAGE;
+    }
+
+    atomic_store_explicit(&loader.expectedCount, expected, memory_order_relaxed);
+
+    for (unsigned int i = 0; i < header->entryCount; i++) {
+        if ((size_t)toc[i].offset + toc[i].size > loader.mappingSize) {
+            TraceLog(LOG_WARNING, "ASSETS: [%s] Entry %.*s runs past the end of the bundle", path, ASSET_NAME_LENGTH, toc[i].name);
+            continue;
+        }
+
+        DecodeBundleEntry(header, &toc[i]);
+    }
+
+    return true;
+}
+
+// Reads each file and decodes it from memory; only GPU uploads are left for the main thread
+static void DecodeLooseFiles(const char *manifestPath) {
+    static AssetSource sources[ASSET_MAX_SOURCES];
+    int count = ReadAssetManifest(manifestPath, sources, ASSET_MAX_SOURCES);
+
+    loader.source = loader.manifestPath;
+    atomic_store_explicit(&loader.expectedCount, count > 0 ? count : 0, memory_order_relaxed);
+
+    for (int i = 0; i < count; i++) {
+        const AssetSource *source = &sources[i];
+        DecodedAsset *asset = NextDecoded(source->kind, source->name);
+        int dataSize = 0;
+        unsigned char *data = LoadFileData(source->path, &dataSize);
+
+        if (asset == NULL || data == NULL) {
+            UnloadFileData(data);
+            continue;
+        }
+
+        if (source->kind == ASSET_SPRITE) {
+            asset->image = LoadImageFromMemory(GetFileExtension(source->path), data, dataSize);
+
+            if (asset->image.data != NULL) {
+                ImageFormat(&asset->image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+                PublishDecoded();
+            }
+        } else if (source->kind == ASSET_SOUND) {
+            asset->wave = LoadWaveFromMemory(GetFileExtension(source->path), data, dataSize);
+
+            if (asset->wave.data != NULL) {
+                PublishDecoded();
+            }
+        } else if (source->kind == ASSET_FONT) {
+            Font *font = &asset->font;
+            font->baseSize = source->fontSize;
+            font->glyphCount = ASSET_FONT_GLYPHS;
+            font->glyphPadding = ASSET_FONT_PADDING;
+            font->glyphs = LoadFontData(data, dataSize, source->fontSize, NULL, ASSET_FONT_GLYPHS, FONT_DEFAULT);
+
+            if (font->glyphs != NULL) {
+                asset->image = GenImageFontAtlas(font->glyphs, &font->recs, ASSET_FONT_GLYPHS, source->fontSize, ASSET_FONT_PADDING, 0);
+                PublishDecoded();
+            }
+        }
+
+        UnloadFileData(data);
+    }
+}
+
+static void *RunAssetLoader(void *arg) {
+    if (loader.bundlePath[0] == '\0' || !DecodeBundle(loader.bundlePath)) {
+        DecodeLooseFiles(loader.manifestPath);
+    }
+
+    atomic_store_explicit(&loader.finished, true, memory_order_release);
+
+    return NULL;
+}
+
+// Starts decoding on a thread of its own, so it can overlap InitWindow; bundlePath may be NULL to load the loose files
+bool StartAssetLoader(const char *bundlePath, const char *manifestPath) {
+    memset(&store, 0, sizeof(store));
+    memset(&loader, 0, sizeof(loader));
+    snprintf(loader.bundlePath, sizeof(loader.bundlePath), "%s", bundlePath != NULL ? bundlePath : "");
+    snprintf(loader.manifestPath, sizeof(loader.manifestPath), "%s", manifestPath);
+    atomic_init(&loader.decodedCount, 0);
+    atomic_init(&loader.expectedCount, 0);
+    atomic_init(&loader.finished, false);
+    loader.startTime = GetMonotonicTime();
+
+    if (pthread_create(&loader.thread, NULL, RunAssetLoader, NULL) != 0) {
+        TraceLog(LOG_WARNING, "ASSETS: Failed to start the loader thread, loading in place");
+        RunAssetLoader(NULL);
+        return false;
+    }
+
+    loader.started = true;
+
+    return true;
+}
+
+// Returns true when the asset used a texture upload
+static bool UploadDecoded(DecodedAsset *asset) {
+    if (asset->kind == ASSET_SOUND) {
+        AddSound(asset->name, asset->wave);
+        return false;
+    }
+
+    Texture2D texture = LoadTextureFromImage(asset->image);
+
+    if (loader.mapping == NULL) {
+        UnloadImage(asset->image);
+    }
+
+    if (asset->kind == ASSET_FONT) {
+        asset->font.texture = texture;
+        AddFont(asset->name, asset->font);
+        return true;
+    }
+
+    SetTextureFilter(texture, TEXTURE_FILTER_POINT);
+
+    if (asset->sprites == NULL) {
+        AddSprite(asset->name, (Sprite){ texture, { 0, 0, texture.width, texture.height } });
+        return true;
+    }
+
+    store.atlas = texture;
+
+    for (int i = 0; i < asset->spriteCount; i++) {
+        AddSprite(asset->sprites[i].name, (Sprite){ texture, asset->sprites[i].source });
+    }
+
+    return true;
+}
+
+// Turns up to maxUploads decoded images into textures; call once per frame before BeginDrawing.
+// Returns true once everything the loader produced is resident
+bool UploadAssets(int maxUploads) {
+    if (loader.resident) {
+        return true;
+    }
+
+    // Finished is read first: once it is set, decodedCount is final
+    bool finished = atomic_load_explicit(&loader.finished, memory_order_acquire);
+    int decoded = atomic_load_explicit(&loader.decodedCount, memory_order_acquire);
+    int uploads = 0;
+
+    while (loader.uploadedCount < decoded && uploads < maxUploads) {
+        uploads += UploadDecoded(&loader.decoded[loader.uploadedCount++]);
+    }
+
+    if (!finished || loader.uploadedCount < decoded) {
+        return false;
+    }
+
+    if (loader.started) {
+        pthread_join(loader.thread, NULL);
+        loader.started = false;
+    }
+
+    loader.resident = true;
+    TraceLog(LOG_INFO, "ASSETS: Loaded %d sprites, %d sounds and %d fonts from %s in %.2f ms",
+        store.spriteCount, store.soundCount, store.fontCount, loader.source, (GetMonotonicTime() - loader.startTime) * 1000);
+
+    return true;
+}
+
+void GetAssetProgress(int *resident, int *total) {
+    *resident = loader.uploadedCount;
+    *total = atomic_load_explicit(&loader.expectedCount, memory_order_relaxed);
+}
+
+// Frees what was never uploaded, which only happens when the game closes mid-load
+static void UnloadDecoded(DecodedAsset *asset) {
+    bool mapped = loader.mapping != NULL;
+
+    if (asset->kind == ASSET_SOUND && !mapped) {
+        UnloadWave(asset->wave);
+    } else if (asset->kind == ASSET_SPRITE && !mapped) {
+        UnloadImage(asset->image);
+    } else if (asset->kind == ASSET_FONT && mapped) {
+        MemFree(asset->font.glyphs);
+    } else if (asset->kind == ASSET_FONT) {
+        UnloadImage(asset->image);
+        UnloadFontData(asset->font.glyphs, asset->font.glyphCount);
+        MemFree(asset->font.recs);
+    }
+}
+
+void UnloadAssets(void) {
+    if (loader.started) {
+        pthread_join(loader.thread, NULL);
+        loader.started = false;
+    }
+
+    int decoded = atomic_load_explicit(&loader.decodedCount, memory_order_acquire);
+
+    for (int i = loader.uploadedCount; i < decoded; i++) {
+        UnloadDecoded(&loader.decoded[i]);
+    }
+
+    if (loader.mapping != NULL) {
+        UnloadTexture(store.atlas);
+
+        for (int i = 0; i < store.fontCount; i++) {
+            UnloadTexture(store.fonts[i].texture);
+            MemFree(store.fonts[i].glyphs);
+        }
+
+        munmap(loader.mapping, loader.mappingSize);
+    } else {
+        for (int i = 0; i < store.spriteCount; i++) {
+            UnloadTexture(store.sprites[i].texture);
+        }
+
+        for (int i = 0; i < store.soundCount; i++) {
+            UnloadWave(store.sounds[i]);
+        }
+
+        for (int i = 0; i < store.fontCount; i++) {
+            UnloadFont(store.fonts[i]);
+        }
+    }
+
+    memset(&store, 0, sizeof(store));
+    memset(&loader, 0, sizeof(loader));
+}
+
+Sprite GetSprite(const char *name) {
+    for (int i = 0; i < store.spriteCount; i++) {
+        if (strcmp(store.spriteNames[i], name) == 0) {
+            return store.sprites[i];
+        }
+    }
+
+    return (Sprite){ 0 };
+}
+
+// Bundle sounds point into read-only pages; convert a copy (WaveCopy) before changing one
+Wave GetSound(const char *name) {
+    for (int i = 0; i < store.soundCount; i++) {
+        if (strcmp(store.soundNames[i], name) == 0) {
+            return store.sounds[i];
+        }
+    }
+
+    return (Wave){ 0 };
+}
+
+// Falls back to raylib's built-in font until the named one is resident
+Font GetAssetFont(const char *name) {
+    for (int i = 0; i < store.fontCount; i++) {
+        if (strcmp(store.fontNames[i], name) == 0) {
+            return store.fonts[i];
+        }
+    }
+
+    return GetFontDefault();
+}
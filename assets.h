@@ -0,0 +1,82 @@
+#ifndef ASSETS_H
+#define ASSETS_H
+
+#include <stdbool.h>
+#include "raylib.h"
+
+#define ASSET_BUNDLE_MAGIC 0x42414953 // "SIAB"
+#define ASSET_BUNDLE_VERSION 1
+#define ASSET_BUNDLE_ALIGNMENT 4096 // entries start on page boundaries so uploads read straight from the mapping
+#define ASSET_NAME_LENGTH 32
+#define ASSET_PATH_LENGTH 256
+#define ASSET_MAX_SOURCES 64
+#define ASSET_MAX_FONTS 4
+#define ASSET_ATLAS_NAME "atlas"
+#define ASSET_FONT_GLYPHS 95 // printable ASCII, what LoadFontEx loads by default
+#define ASSET_FONT_PADDING 4 // same as LoadFontEx
+
+typedef enum AssetKind {
+    ASSET_SPRITE,
+    ASSET_SOUND,
+    ASSET_FONT,
+} AssetKind;
+
+// One line of the manifest; paths are resolved against the manifest's directory
+typedef struct AssetSource {
+    AssetKind kind;
+    char name[ASSET_NAME_LENGTH];
+    char path[ASSET_PATH_LENGTH];
+    int fontSize;
+} AssetSource;
+
+typedef enum BundleEntryType {
+    BUNDLE_IMAGE,   // pixels; params: width, height, format
+    BUNDLE_SPRITES, // BundleSprite[params[0]] inside the image of the same name
+    BUNDLE_WAVE,    // PCM samples; params: frame count, sample rate, sample size, channels
+    BUNDLE_GLYPHS,  // BundleGlyph[n] then Rectangle[n] into the image of the same name; params: n, base size, padding
+} BundleEntryType;
+
+typedef struct BundleHeader {
+    unsigned int magic;
+    unsigned int version;
+    unsigned int entryCount;
+    unsigned int tocOffset;
+} BundleHeader;
+
+// Table of contents record, written after the data
+typedef struct BundleEntry {
+    char name[ASSET_NAME_LENGTH];
+    unsigned int type;
+    unsigned int offset;
+    unsigned int size;
+    int params[4];
+} BundleEntry;
+
+typedef struct BundleSprite {
+    char name[ASSET_NAME_LENGTH];
+    Rectangle source; // pixels
+    float u0, v0, u1, v1;
+} BundleSprite;
+
+typedef struct BundleGlyph {
+    int value;
+    int offsetX;
+    int offsetY;
+    int advanceX;
+} BundleGlyph;
+
+typedef struct Sprite {
+    Texture2D texture;
+    Rectangle source;
+} Sprite;
+
+int ReadAssetManifest(const char *path, AssetSource *sources, int maxSources);
+bool StartAssetLoader(const char *bundlePath, const char *manifestPath);
+bool UploadAssets(int maxUploads);
+void GetAssetProgress(int *resident, int *total);
+void UnloadAssets(void);
+Sprite GetSprite(const char *name);
+Wave GetSound(const char *name);
+Font GetAssetFont(const char *name);
+
+#endif
@@ -0,0 +1,358 @@
+#include <stdlib.h>
+#include <string.h>
+#include "raylib.h"
+#include "ecs.h"
+
+static void *GrowBuffer(void *buffer, size_t size) {
+    void *grown = realloc(buffer, size);
+
+    if (grown == NULL) {
+        TraceLog(LOG_FATAL, "ECS: Failed to grow buffer to %zu bytes", size);
+    }
+
+    return grown;
+}
+
+static void ReserveArchetype(World *world, Archetype *archetype, int capacity) {
+    if (capacity <= archetype->capacity) {
+        return;
+    }
+
+    archetype->entities = GrowBuffer(archetype->entities, capacity * sizeof(Entity));
+
+    for (int c = 0; c < world->componentCount; c++) {
+        if (archetype->mask & COMPONENT_BIT(c)) {
+            archetype->columns[c] = GrowBuffer(archetype->columns[c], (size_t)capacity * world->componentSizes[c]);
+        }
+    }
+
+    archetype->capacity = capacity;
+}
+
+void InitWorld(World *world, const int *componentSizes, int componentCount) {
+    memset(world, 0, sizeof(World));
+    memcpy(world->componentSizes, componentSizes, componentCount * sizeof(int));
+    world->componentCount = componentCount;
+}
+
+void UnloadWorld(World *world) {
+    for (int a = 0; a < world->archetypeCount; a++) {
+        Archetype *archetype = &world->archetypes[a];
+        free(archetype->entities);
+
+        for (int c = 0; c < world->componentCount; c++) {
+            free(archetype->columns[c]);
+        }
+    }
+
+    free(world->locations);
+    free(world->freeIndices);
+    memset(world, 0, sizeof(World));
+}
+
+int AddArchetype(World *world, ComponentMask mask, int capacity) {
+    if (world->archetypeCount >= ECS_MAX_ARCHETYPES) {
+        TraceLog(LOG_FATAL, "ECS: Too many archetypes (max %d)", ECS_MAX_ARCHETYPES);
+    }
+
+    int index = world->archetypeCount++;
+    Archetype *archetype = &world->archetypes[index];
+    memset(archetype, 0, sizeof(Archetype));
+    archetype->mask = mask;
+    ReserveArchetype(world, archetype, capacity < ECS_MIN_CAPACITY ? ECS_MIN_CAPACITY : capacity);
+
+    return index;
+}
+
+Entity CreateEntity(World *world, int archetypeIndex) {
+    Archetype *archetype = &world->archetypes[archetypeIndex];
+
+    if (archetype->count == archetype->capacity) {
+        ReserveArchetype(world, archetype, archetype->capacity * 2);
+    }
+
+    int index;
+
+    if (world->freeCount > 0) {
+        index = world->freeIndices[--world->freeCount];
+    } else {
+        if (world->locationCount == world->locationCapacity) {
+            int capacity = world->locationCapacity ? world->locationCapacity * 2 : 64;
+            world->locations = GrowBuffer(world->locations, capacity * sizeof(EntityLocation));
+            world->freeIndices = GrowBuffer(world->freeIndices, capacity * sizeof(int));
+            world->locationCapacity = capacity;
+        }
+
+        index = world->locationCount++;
+        world->locations[index].generation = 0;
+    }
+
+    int row = archetype->count++;
+    EntityLocation *location = &world->locations[index];
+    location->archetype = archetypeIndex;
+    location->row = row;
+
+    Entity entity = (location->generation << 24) | (unsigned int)index;
+    archetype->entities[row] = entity;
+
+    for (int c = 0; c < world->componentCount; c++) {
+        if (archetype->mask & COMPONENT_BIT(c)) {
+            memset((char *)archetype->columns[c] + (size_t)row * world->componentSizes[c], 0, world->componentSizes[c]);
+        }
+    }
+
+    return entity;
+}
+
+// Removes the entity by moving the archetype's last row into its slot
+void DestroyEntity(World *world, Entity entity) {
+    if (!IsEntityAlive(world, entity)) {
+        return;
+    }
+
+    EntityLocation *location = &world->locations[ENTITY_INDEX(entity)];
+    Archetype *archetype = &world->archetypes[location->archetype];
+    int row = location->row;
+    int last = --archetype->count;
+
+    if (row != last) {
+        for (int c = 0; c < world->componentCount; c++) {
+            if (archetype->mask & COMPONENT_BIT(c)) {
+                int size = world->componentSizes[c];
+                memcpy((char *)archetype->columns[c] + (size_t)row * size, (char *)archetype->columns[c] + (size_t)last * size, size);
+            }
+        }
+
+        Entity moved = archetype->entities[last];
+        archetype->entities[row] = moved;
+        world->locations[ENTITY_INDEX(moved)].row = row;
+    }
+
+    location->archetype = -1;
+    location->generation = (location->generation + 1) & 0xFF;
+    world->freeIndices[world->freeCount++] = ENTITY_INDEX(entity);
+}
+
+void ClearArchetype(World *world, int archetypeIndex) {
+    Archetype *archetype = &world->archetypes[archetypeIndex];
+
+    while (archetype->count > 0) {
+        DestroyEntity(world, archetype->entities[archetype->count - 1]);
+    }
+}
+
+bool IsEntityAlive(const World *world, Entity entity) {
+    if (entity == ENTITY_NONE || (int)ENTITY_INDEX(entity) >= world->locationCount) {
+        return false;
+    }
+
+    const EntityLocation *location = &world->locations[ENTITY_INDEX(entity)];
+
+    return location->archetype >= 0 && location->generation == ENTITY_GENERATION(entity);
+}
+
+void *GetComponent(const World *world, Entity entity, int component) {
+    if (!IsEntityAlive(world, entity)) {
+        return NULL;
+    }
+
+    const EntityLocation *location = &world->locations[ENTITY_INDEX(entity)];
+    const Archetype *archetype = &world->archetypes[location->archetype];
+
+    if (!(archetype->mask & COMPONENT_BIT(component))) {
+        return NULL;
+    }
+
+    return (char *)archetype->columns[component] + (size_t)location->row * world->componentSizes[component];
+}
+
+// Calls the system once per non-empty archetype that has all the required components
+void RunSystem(World *world, ComponentMask required, SystemFunc system, void *context) {
+    for (int a = 0; a < world->archetypeCount; a++) {
+        Archetype *archetype = &world->archetypes[a];
+
+        if ((archetype->mask & required) == required && archetype->count > 0) {
+            system(context, archetype);
+        }
+    }
+}
+
+void WriteState(StateWriter *writer, const void *data, size_t size) {
+    if (writer->data != NULL && writer->size + size <= writer->capacity) {
+        memcpy(writer->data + writer->size, data, size);
+    }
+
+    writer->size += size;
+}
+
+bool ReadState(StateReader *reader, void *data, size_t size) {
+    if (reader->failed || reader->offset + size > reader->size) {
+        reader->failed = true;
+        return false;
+    }
+
+    memcpy(data, reader->data + reader->offset, size);
+    reader->offset += size;
+
+    return true;
+}
+
+// Rows, entity handles and the location table go out as they are, so handles held elsewhere stay valid after a load
+void SaveWorld(const World *world, StateWriter *writer) {
+    WriteState(writer, &world->archetypeCount, sizeof(int));
+
+    for (int a = 0; a < world->archetypeCount; a++) {
+        const Archetype *archetype = &world->archetypes[a];
+        WriteState(writer, &archetype->mask, sizeof(ComponentMask));
+        WriteState(writer, &archetype->count, sizeof(int));
+        WriteState(writer, archetype->entities, archetype->count * sizeof(Entity));
+
+        for (int c = 0; c < world->componentCount; c++) {
+            if (archetype->mask & COMPONENT_BIT(c)) {
+                WriteState(writer, archetype->columns[c], (size_t)archetype->count * world->componentSizes[c]);
+            }
+        }
+    }
+
+    WriteState(writer, &world->locationCount, sizeof(int));
+    WriteState(writer, world->locations, world->locationCount * sizeof(EntityLocation));
+    WriteState(writer, &world->freeCount, sizeof(int));
+    WriteState(writer, world->freeIndices, world->freeCount * sizeof(int));
+}
+
+// A load that fails part way leaves an empty world rather than rows and locations that disagree
+static bool FailLoad(World *world) {
+    for (int a = 0; a < world->archetypeCount; a++) {
+        world->archetypes[a].count = 0;
+    }
+
+    world->locationCount = 0;
+    world->freeCount = 0;
+
+    return false;
+}
+
+// Locations and rows must name each other one to one, and each dead location may be free at most once;
+// DestroyEntity and ClearArchetype trust all of it
+static bool ValidateLocations(World *world) {
+    int live = 0;
+    int rows = 0;
+
+    for (int i = 0; i < world->locationCount; i++) {
+        const EntityLocation *location = &world->locations[i];
+
+        if (location->archetype < 0) {
+            continue;
+        }
+
+        live++;
+
+        if (location->archetype >= world->archetypeCount || location->row < 0 ||
+            location->row >= world->archetypes[location->archetype].count) {
+            return false;
+        }
+
+        Entity entity = world->archetypes[location->archetype].entities[location->row];
+
+        if ((int)ENTITY_INDEX(entity) != i || ENTITY_GENERATION(entity) != location->generation) {
+            return false;
+        }
+    }
+
+    for (int a = 0; a < world->archetypeCount; a++) {
+        const Archetype *archetype = &world->archetypes[a];
+
+        for (int row = 0; row < archetype->count; row++) {
+            Entity entity = archetype->entities[row];
+
+            if (!IsEntityAlive(world, entity) || world->locations[ENTITY_INDEX(entity)].archetype != a ||
+                world->locations[ENTITY_INDEX(entity)].row != row) {
+                return false;
+            }
+        }
+
+        rows += archetype->count;
+    }
+
+    if (live != rows) {
+        return false;
+    }
+
+    // Free locations are marked while scanning so a repeated index shows up; all are dead again after
+    bool valid = true;
+    int marked = 0;
+
+    for (; marked < world->freeCount; marked++) {
+        int index = world->freeIndices[marked];
+
+        if (index < 0 || index >= world->locationCount || world->locations[index].archetype != -1) {
+            valid = false;
+            break;
+        }
+
+        world->locations[index].archetype = -2;
+    }
+
+    for (int i = 0; i < marked; i++) {
+        world->locations[world->freeIndices[i]].archetype = -1;
+    }
+
+    return valid;
+}
+
+// The world must already have the saved archetypes, in the same order, as InitGame sets them up. The state
+// may come from a damaged file, so nothing in it is trusted until checked
+bool LoadWorld(World *world, StateReader *reader) {
+    int archetypeCount = 0;
+
+    if (!ReadState(reader, &archetypeCount, sizeof(int)) || archetypeCount != world->archetypeCount) {
+        return false;
+    }
+
+    for (int a = 0; a < world->archetypeCount; a++) {
+        Archetype *archetype = &world->archetypes[a];
+        ComponentMask mask = 0;
+        int count = 0;
+
+        if (!ReadState(reader, &mask, sizeof(ComponentMask)) || mask != archetype->mask ||
+            !ReadState(reader, &count, sizeof(int)) || count < 0 || count > ECS_MAX_ENTITIES) {
+            return FailLoad(world);
+        }
+
+        ReserveArchetype(world, archetype, count);
+        archetype->count = count;
+
+        if (!ReadState(reader, archetype->entities, count * sizeof(Entity))) {
+            return FailLoad(world);
+        }
+
+        for (int c = 0; c < world->componentCount; c++) {
+            if ((archetype->mask & COMPONENT_BIT(c)) && !ReadState(reader, archetype->columns[c], (size_t)count * world->componentSizes[c])) {
+                return FailLoad(world);
+            }
+        }
+    }
+
+    int locationCount = 0;
+
+    if (!ReadState(reader, &locationCount, sizeof(int)) || locationCount < 0 || locationCount > ECS_MAX_ENTITIES) {
+        return FailLoad(world);
+    }
+
+    // Free indices can never outnumber locations, so both tables share one capacity
+    if (locationCount > world->locationCapacity) {
+        world->locations = GrowBuffer(world->locations, locationCount * sizeof(EntityLocation));
+        world->freeIndices = GrowBuffer(world->freeIndices, locationCount * sizeof(int));
+        world->locationCapacity = locationCount;
+    }
+
+    world->locationCount = locationCount;
+
+    if (!ReadState(reader, world->locations, locationCount * sizeof(EntityLocation)) ||
+        !ReadState(reader, &world->freeCount, sizeof(int)) || world->freeCount < 0 || world->freeCount > locationCount ||
+        !ReadState(reader, world->freeIndices, world->freeCount * sizeof(int)) || !ValidateLocations(world)) {
+        return FailLoad(world);
+    }
+
+    return true;
+}
@@ -0,0 +1,81 @@
+#ifndef ECS_H
+#define ECS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define ECS_MAX_COMPONENTS 16
+#define ECS_MAX_ARCHETYPES 16
+#define ECS_MAX_ENTITIES 65536 // per archetype and in the location table; a loaded state holding more is corrupt
+#define ECS_MIN_CAPACITY 16
+
+// Entity handle: low 24 bits index into the location table, high 8 bits generation
+typedef unsigned int Entity;
+typedef unsigned int ComponentMask;
+
+#define ENTITY_NONE 0xFFFFFFFFu
+#define ENTITY_INDEX(entity) ((entity) & 0x00FFFFFFu)
+#define ENTITY_GENERATION(entity) ((entity) >> 24)
+#define COMPONENT_BIT(component) (1u << (component))
+
+// Entities sharing the same set of components, stored as one contiguous column per component
+typedef struct Archetype {
+    ComponentMask mask;
+    int count;
+    int capacity;
+    Entity *entities;
+    void *columns[ECS_MAX_COMPONENTS];
+} Archetype;
+
+typedef struct EntityLocation {
+    int archetype;
+    int row;
+    unsigned int generation;
+} EntityLocation;
+
+typedef struct World {
+    int componentSizes[ECS_MAX_COMPONENTS];
+    int componentCount;
+    Archetype archetypes[ECS_MAX_ARCHETYPES];
+    int archetypeCount;
+    EntityLocation *locations;
+    int locationCount;
+    int locationCapacity;
+    int *freeIndices;
+    int freeCount;
+} World;
+
+// Cursor over a caller-owned buffer; writes past capacity are counted but dropped, so a NULL buffer measures
+typedef struct StateWriter {
+    unsigned char *data;
+    size_t capacity;
+    size_t size;
+} StateWriter;
+
+typedef struct StateReader {
+    const unsigned char *data;
+    size_t size;
+    size_t offset;
+    bool failed;
+} StateReader;
+
+typedef void (*SystemFunc)(void *context, Archetype *archetype);
+
+void InitWorld(World *world, const int *componentSizes, int componentCount);
+void UnloadWorld(World *world);
+int AddArchetype(World *world, ComponentMask mask, int capacity);
+Entity CreateEntity(World *world, int archetype);
+void DestroyEntity(World *world, Entity entity);
+void ClearArchetype(World *world, int archetype);
+bool IsEntityAlive(const World *world, Entity entity);
+void *GetComponent(const World *world, Entity entity, int component);
+void RunSystem(World *world, ComponentMask required, SystemFunc system, void *context);
+void WriteState(StateWriter *writer, const void *data, size_t size);
+bool ReadState(StateReader *reader, void *data, size_t size);
+void SaveWorld(const World *world, StateWriter *writer);
+bool LoadWorld(World *world, StateReader *reader);
+
+// Typed access to a component column of an archetype
+#define COLUMN(archetype, type, component) ((type *)(archetype)->columns[(component)])
+
+#endif
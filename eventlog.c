@@ -0,0 +1,300 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include "raylib.h"
+#include "eventlog.h"
+#include "game.h"
+#include "pacing.h"
+#include "profiler.h"
+
+static const char *eventNames[GAME_EVENT_TYPE_COUNT] = {
+    [GAME_EVENT_SESSION] = "session",
+    [GAME_EVENT_SHOT] = "shot",
+    [GAME_EVENT_KILL] = "kill",
+    [GAME_EVENT_WAVE_STARTED] = "wave-started",
+    [GAME_EVENT_WAVE_CLEARED] = "wave-cleared",
+    [GAME_EVENT_PLAYER_JOINED] = "player-joined",
+    [GAME_EVENT_PLAYER_LEFT] = "player-left",
+};
+
+static atomic_uint nextLogId = 1;
+
+// The ring this thread emits into, found without a lock after its first event
+static _Thread_local EventRing *localRing = NULL;
+static _Thread_local unsigned int localLogId = 0;
+
+static bool WriteAll(int fd, const void *data, size_t size) {
+    const unsigned char *bytes = data;
+
+    while (size > 0) {
+        ssize_t written = write(fd, bytes, size);
+
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+
+        if (written <= 0) {
+            return false;
+        }
+
+        bytes += written;
+        size -= written;
+    }
+
+    return true;
+}
+
+static void WriteBatch(EventLog *log, int count) {
+    if (count == 0 || log->failed) {
+        return;
+    }
+
+    if (!WriteAll(log->fd, log->batch, count * sizeof(GameEvent))) {
+        TraceLog(LOG_WARNING, "EVENTS: Failed to write, logging stopped");
+        log->failed = true;
+        return;
+    }
+
+    log->written += count;
+}
+
+// Copies every ring's pending records out in batches; each ring is released as soon as it is copied
+static void DrainEventRings(EventLog *log) {
+    int ringCount = atomic_load_explicit(&log->ringCount, memory_order_acquire);
+    int count = 0;
+
+    for (int r = 0; r < ringCount; r++) {
+        EventRing *ring = log->rings[r];
+        unsigned int head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        unsigned int tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+        while (tail != head) {
+            unsigned int start = tail % EVENT_RING_CAPACITY;
+            unsigned int run = head - tail;
+
+            run = run < EVENT_RING_CAPACITY - start ? run : EVENT_RING_CAPACITY - start;
+            run = run < (unsigned int)(EVENT_LOG_BATCH - count) ? run : (unsigned int)(EVENT_LOG_BATCH - count);
+            memcpy(&log->batch[count], &ring->records[start], run * sizeof(GameEvent));
+            count += run;
+            tail += run;
+
+            if (count == EVENT_LOG_BATCH) {
+                atomic_store_explicit(&ring->tail, tail, memory_order_release);
+                WriteBatch(log, count);
+                count = 0;
+            }
+        }
+
+        atomic_store_explicit(&ring->tail, tail, memory_order_release);
+    }
+
+    WriteBatch(log, count);
+}
+
+static void *EventWriterMain(void *data) {
+    EventLog *log = data;
+    double lastSync = GetMonotonicTime();
+
+    while (!atomic_load(&log->quit)) {
+        SleepUntil(GetMonotonicTime() + EVENT_LOG_FLUSH_INTERVAL);
+        DrainEventRings(log);
+
+        double now = GetMonotonicTime();
+
+        if (now - lastSync >= EVENT_LOG_SYNC_INTERVAL) {
+            fdatasync(log->fd);
+            lastSync = now;
+        }
+    }
+
+    DrainEventRings(log);
+    fdatasync(log->fd);
+
+    return NULL;
+}
+
+// A new file gets a header; an existing one must carry a matching header and is appended to
+static bool PrepareEventFile(int fd) {
+    EventLogHeader expected = { EVENT_LOG_MAGIC, EVENT_LOG_VERSION, sizeof(GameEvent), TICK_RATE };
+    EventLogHeader header;
+    struct stat info;
+
+    if (fstat(fd, &info) != 0) {
+        return false;
+    }
+
+    if (info.st_size == 0) {
+        return WriteAll(fd, &expected, sizeof(expected));
+    }
+
+    if (pread(fd, &header, sizeof(header), 0) != sizeof(header) || memcmp(&header, &expected, sizeof(header)) != 0) {
+        return false;
+    }
+
+    // A crash can leave a torn record at the end; cut it so the records stay aligned
+    off_t records = (info.st_size - sizeof(header)) / sizeof(GameEvent);
+
+    return ftruncate(fd, sizeof(header) + records * sizeof(GameEvent)) == 0;
+}
+
+bool StartEventLog(EventLog *log, const char *path) {
+    memset(log, 0, sizeof(EventLog));
+    log->fd = open(path, O_RDWR | O_CREAT | O_APPEND, 0644);
+
+    if (log->fd < 0 || !PrepareEventFile(log->fd)) {
+        TraceLog(LOG_WARNING, "EVENTS: [%s] Failed to open event log", path);
+
+        if (log->fd >= 0) {
+            close(log->fd);
+        }
+
+        log->fd = -1;
+        return false;
+    }
+
+    log->id = atomic_fetch_add(&nextLogId, 1);
+    atomic_init(&log->quit, false);
+    atomic_init(&log->ringCount, 0);
+    atomic_init(&log->unregistered, 0);
+    pthread_mutex_init(&log->registerLock, NULL);
+
+    if (pthread_create(&log->thread, NULL, EventWriterMain, log) != 0) {
+        TraceLog(LOG_WARNING, "EVENTS: [%s] Failed to start writer thread", path);
+        pthread_mutex_destroy(&log->registerLock);
+        close(log->fd);
+        log->fd = -1;
+        return false;
+    }
+
+    GameEvent session = { .type = GAME_EVENT_SESSION, .seat = GAME_EVENT_NO_SEAT, .entity = ENTITY_NONE, .value = (int)time(NULL) };
+    EmitGameEvent(log, &session);
+    TraceLog(LOG_INFO, "EVENTS: [%s] Logging gameplay events", path);
+
+    return true;
+}
+
+void StopEventLog(EventLog *log) {
+    if (log->fd < 0 || log->id == 0) {
+        return;
+    }
+
+    atomic_store(&log->quit, true);
+    pthread_join(log->thread, NULL);
+    close(log->fd);
+
+    unsigned long long dropped = atomic_load(&log->unregistered);
+    int ringCount = atomic_load(&log->ringCount);
+
+    for (int r = 0; r < ringCount; r++) {
+        dropped += atomic_load(&log->rings[r]->dropped);
+        free(log->rings[r]);
+    }
+
+    TraceLog(LOG_INFO, "EVENTS: Wrote %llu events from %d threads, dropped %llu", log->written, ringCount, dropped);
+
+    pthread_mutex_destroy(&log->registerLock);
+    log->fd = -1;
+    log->id = 0;
+}
+
+// First event from a thread: the only time emitting takes a lock or allocates
+static EventRing *RegisterEventRing(EventLog *log) {
+    EventRing *ring = NULL;
+
+    pthread_mutex_lock(&log->registerLock);
+    int ringCount = atomic_load_explicit(&log->ringCount, memory_order_relaxed);
+
+    if (ringCount < EVENT_LOG_MAX_THREADS) {
+        ring = aligned_alloc(EVENT_LOG_LINE, sizeof(EventRing));
+    }
+
+    if (ring != NULL) {
+        memset(ring, 0, sizeof(EventRing));
+        log->rings[ringCount] = ring;
+        atomic_store_explicit(&log->ringCount, ringCount + 1, memory_order_release);
+    }
+
+    pthread_mutex_unlock(&log->registerLock);
+
+    localRing = ring;
+    localLogId = log->id;
+
+    return ring;
+}
+
+// Never blocks the tick: when the writer has fallen a whole ring behind, the event is counted and dropped
+void EmitGameEvent(EventLog *log, const GameEvent *event) {
+    EventRing *ring = localLogId == log->id ? localRing : RegisterEventRing(log);
+
+    if (ring == NULL) {
+        atomic_fetch_add_explicit(&log->unregistered, 1, memory_order_relaxed);
+        return;
+    }
+
+    unsigned int head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+
+    if (head - ring->cachedTail == EVENT_RING_CAPACITY) {
+        ring->cachedTail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+        if (head - ring->cachedTail == EVENT_RING_CAPACITY) {
+            atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+            return;
+        }
+    }
+
+    ring->records[head % EVENT_RING_CAPACITY] = *event;
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+bool OpenEventLog(EventLogReader *reader, const char *path) {
+    memset(reader, 0, sizeof(EventLogReader));
+    reader->file = fopen(path, "rb");
+
+    if (reader->file == NULL) {
+        return false;
+    }
+
+    if (fread(&reader->header, sizeof(EventLogHeader), 1, reader->file) != 1 || reader->header.magic != EVENT_LOG_MAGIC
+        || reader->header.version != EVENT_LOG_VERSION || reader->header.recordSize != sizeof(GameEvent)) {
+        CloseEventLog(reader);
+        return false;
+    }
+
+    reader->offset = sizeof(EventLogHeader);
+
+    return true;
+}
+
+// False at the end of what has been written so far; calling again later picks up records appended since
+bool ReadGameEvent(EventLogReader *reader, GameEvent *event) {
+    if (fread(event, sizeof(GameEvent), 1, reader->file) == 1) {
+        reader->offset += sizeof(GameEvent);
+        return true;
+    }
+
+    // A record the writer is halfway through is read again whole next time
+    clearerr(reader->file);
+    fseek(reader->file, reader->offset, SEEK_SET);
+
+    return false;
+}
+
+void CloseEventLog(EventLogReader *reader) {
+    if (reader->file != NULL) {
+        fclose(reader->file);
+    }
+
+    reader->file = NULL;
+}
+
+const char *GetGameEventName(int type) {
+    if (type <= 0 || type >= GAME_EVENT_TYPE_COUNT) {
+        return "unknown";
+    }
+
+    return eventNames[type];
+}
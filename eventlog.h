@@ -0,0 +1,88 @@
+#ifndef EVENTLOG_H
+#define EVENTLOG_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#define EVENT_LOG_MAGIC 0x56454953 // "SIEV"
+#define EVENT_LOG_VERSION 1
+#define EVENT_RING_CAPACITY 4096 // records per emitting thread; a power of two
+#define EVENT_LOG_MAX_THREADS 32
+#define EVENT_LOG_BATCH 1024 // records per write()
+#define EVENT_LOG_FLUSH_INTERVAL 0.05 // seconds between drains of the rings
+#define EVENT_LOG_SYNC_INTERVAL 1.0 // seconds between fsyncs
+#define EVENT_LOG_LINE 64
+
+typedef enum GameEventType {
+    GAME_EVENT_SESSION = 1, // a game started appending; value is its start in Unix time
+    GAME_EVENT_SHOT,
+    GAME_EVENT_KILL,        // value is the shooter's score after it
+    GAME_EVENT_WAVE_STARTED, // value is the enemies in it
+    GAME_EVENT_WAVE_CLEARED,
+    GAME_EVENT_PLAYER_JOINED,
+    GAME_EVENT_PLAYER_LEFT, // value is the final score
+    GAME_EVENT_TYPE_COUNT,
+} GameEventType;
+
+#define GAME_EVENT_NO_SEAT -2 // seat of events no pilot caused; PILOT_LOCAL is -1
+
+// Fixed size and written to the file as is
+typedef struct GameEvent {
+    unsigned int tick;
+    unsigned char type;
+    signed char seat;
+    unsigned short slot; // flock slot of a killed enemy
+    unsigned int entity;
+    float x;
+    float y;
+    int value;
+} GameEvent;
+
+typedef struct EventLogHeader {
+    unsigned int magic;
+    unsigned int version;
+    unsigned int recordSize;
+    unsigned int tickRate;
+} EventLogHeader;
+
+// Single producer, single consumer: the emitting thread owns head, the writer thread owns tail
+typedef struct EventRing {
+    GameEvent records[EVENT_RING_CAPACITY];
+    _Alignas(EVENT_LOG_LINE) atomic_uint head;
+    unsigned int cachedTail; // the producer's last look at tail, so a push only reads it when the ring seems full
+    atomic_uint dropped;
+    _Alignas(EVENT_LOG_LINE) atomic_uint tail;
+} EventRing;
+
+typedef struct EventLog {
+    int fd;
+    unsigned int id; // tells a thread's cached ring from one of an earlier log
+    pthread_t thread;
+    atomic_bool quit;
+    pthread_mutex_t registerLock;
+    EventRing *rings[EVENT_LOG_MAX_THREADS]; // one per thread that has emitted
+    atomic_int ringCount;
+    atomic_uint unregistered; // events from threads beyond EVENT_LOG_MAX_THREADS
+    GameEvent batch[EVENT_LOG_BATCH];
+    unsigned long long written;
+    bool failed;
+} EventLog;
+
+// Streams a log, including one still being appended to
+typedef struct EventLogReader {
+    FILE *file;
+    EventLogHeader header;
+    long offset; // of the next record
+} EventLogReader;
+
+bool StartEventLog(EventLog *log, const char *path);
+void StopEventLog(EventLog *log);
+void EmitGameEvent(EventLog *log, const GameEvent *event);
+bool OpenEventLog(EventLogReader *reader, const char *path);
+bool ReadGameEvent(EventLogReader *reader, GameEvent *event);
+void CloseEventLog(EventLogReader *reader);
+const char *GetGameEventName(int type);
+
+#endif
@@ -0,0 +1,219 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "raylib.h"
+#include "flightrecorder.h"
+
+#define FLIGHT_RECORDER_SIGNAL_STACK (64 * 1024)
+
+static const int crashSignals[] = { SIGSEGV, SIGABRT, SIGBUS, SIGFPE, SIGILL };
+
+static FlightRecorder *crashRecorder = NULL;
+static volatile sig_atomic_t crashing = 0;
+static _Thread_local void *signalStack = NULL; // a stack overflow leaves the handler no stack of its own
+
+// Everything from here to HandleCrash runs inside a signal handler: no allocation, no stdio, no locks
+static bool WriteAll(int fd, const void *data, size_t size) {
+    const unsigned char *bytes = data;
+
+    while (size > 0) {
+        ssize_t written = write(fd, bytes, size);
+
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+
+        if (written <= 0) {
+            return false;
+        }
+
+        bytes += written;
+        size -= written;
+    }
+
+    return true;
+}
+
+// Same LEB128 as the replay inputs
+static int EncodeVarint(unsigned int value, unsigned char *bytes) {
+    int count = 0;
+
+    do {
+        bytes[count] = value & 0x7F;
+        value >>= 7;
+        bytes[count] |= value ? 0x80 : 0;
+        count++;
+    } while (value);
+
+    return count;
+}
+
+// Oldest chunk first and no index footer, which the replay reader rebuilds. The open chunk's pending run
+// is written without closing it, so the recorder keeps going if this was not a crash
+bool DumpFlightRecorder(const FlightRecorder *recorder, const char *path) {
+    ReplayHeader header = { REPLAY_MAGIC, REPLAY_VERSION, TICK_RATE, recorder->keyframeTicks };
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+    if (fd < 0) {
+        return false;
+    }
+
+    bool ok = WriteAll(fd, &header, sizeof(header));
+
+    for (int i = recorder->count - 1; i >= 0 && ok; i--) {
+        const ReplayChunkEncoder *encoder = &recorder->chunks[(recorder->newest - i + FLIGHT_RECORDER_CHUNKS) % FLIGHT_RECORDER_CHUNKS];
+        unsigned char run[5];
+        int runSize = encoder->repeat > 0 ? EncodeVarint(encoder->repeat, run) : 0;
+        ReplayChunk chunk = encoder->chunk;
+
+        if (chunk.tickCount == 0) {
+            continue;
+        }
+
+        chunk.inputSize = encoder->size - chunk.stateSize + runSize;
+        chunk.hashSize = encoder->hashSize;
+        ok = WriteAll(fd, &chunk, sizeof(chunk)) && WriteAll(fd, encoder->buffer, encoder->size) && WriteAll(fd, run, runSize) &&
+            WriteAll(fd, encoder->hashes, encoder->hashSize);
+    }
+
+    return close(fd) == 0 && ok;
+}
+
+static void HandleCrash(int signal) {
+    static const char dumping[] = "FLIGHT: Fatal signal, writing the flight recorder\n";
+    static const char failed[] = "FLIGHT: Failed to write the flight recorder\n";
+
+    if (!crashing && crashRecorder != NULL) {
+        crashing = 1;
+        write(STDERR_FILENO, dumping, sizeof(dumping) - 1);
+
+        if (DumpFlightRecorder(crashRecorder, crashRecorder->path)) {
+            write(STDERR_FILENO, crashRecorder->path, strlen(crashRecorder->path));
+            write(STDERR_FILENO, "\n", 1);
+        } else {
+            write(STDERR_FILENO, failed, sizeof(failed) - 1);
+        }
+    }
+
+    // The handler was reset on entry, so this ends the process the way the signal would have
+    raise(signal);
+}
+
+// The alternate stack is per thread, so every thread that runs game code installs one before it starts
+void InstallCrashStack(void) {
+    if (signalStack != NULL) {
+        return;
+    }
+
+    signalStack = malloc(FLIGHT_RECORDER_SIGNAL_STACK);
+    stack_t stack = { .ss_sp = signalStack, .ss_size = FLIGHT_RECORDER_SIGNAL_STACK };
+
+    if (signalStack != NULL && sigaltstack(&stack, NULL) != 0) {
+        free(signalStack);
+        signalStack = NULL;
+    }
+}
+
+void RemoveCrashStack(void) {
+    if (signalStack == NULL) {
+        return;
+    }
+
+    stack_t stack = { .ss_flags = SS_DISABLE };
+    sigaltstack(&stack, NULL);
+    free(signalStack);
+    signalStack = NULL;
+}
+
+// Everything the recorder needs is allocated here; ticks only write into it
+bool StartFlightRecorder(FlightRecorder *recorder, const char *path) {
+    memset(recorder, 0, sizeof(FlightRecorder));
+    recorder->keyframeTicks = FLIGHT_RECORDER_KEYFRAME_SECONDS * TICK_RATE;
+
+    if (path != NULL) {
+        snprintf(recorder->path, sizeof(recorder->path), "%s", path);
+    } else {
+        snprintf(recorder->path, sizeof(recorder->path), FLIGHT_RECORDER_PATH, (long)time(NULL));
+    }
+
+    for (int i = 0; i < FLIGHT_RECORDER_CHUNKS; i++) {
+        ReplayChunkEncoder *encoder = &recorder->chunks[i];
+
+        encoder->fixed = true;
+        encoder->capacity = FLIGHT_RECORDER_STATE_BYTES + recorder->keyframeTicks * FLIGHT_RECORDER_TICK_BYTES;
+        encoder->buffer = malloc(encoder->capacity);
+        encoder->hashCapacity = recorder->keyframeTicks * FLIGHT_RECORDER_HASH_BYTES;
+        encoder->hashes = malloc(encoder->hashCapacity);
+
+        if (encoder->buffer == NULL || encoder->hashes == NULL) {
+            TraceLog(LOG_WARNING, "FLIGHT: Failed to allocate the recorder");
+            StopFlightRecorder(recorder);
+            return false;
+        }
+
+        // Touched now, so the first pass through the ring takes no page faults mid-tick
+        memset(encoder->buffer, 0, encoder->capacity);
+        memset(encoder->hashes, 0, encoder->hashCapacity);
+    }
+
+    struct sigaction action = { .sa_handler = HandleCrash, .sa_flags = SA_RESETHAND | SA_ONSTACK };
+
+    sigemptyset(&action.sa_mask);
+    InstallCrashStack();
+    crashRecorder = recorder;
+
+    for (int i = 0; i < (int)(sizeof(crashSignals) / sizeof(crashSignals[0])); i++) {
+        sigaction(crashSignals[i], &action, NULL);
+    }
+
+    TraceLog(LOG_INFO, "FLIGHT: Keeping the last %d s, %d KB, crash dump to %s", FLIGHT_RECORDER_SECONDS,
+        (int)(FLIGHT_RECORDER_CHUNKS * (recorder->chunks[0].capacity + recorder->chunks[0].hashCapacity) / 1024), recorder->path);
+
+    return true;
+}
+
+void StopFlightRecorder(FlightRecorder *recorder) {
+    if (crashRecorder == recorder) {
+        for (int i = 0; i < (int)(sizeof(crashSignals) / sizeof(crashSignals[0])); i++) {
+            signal(crashSignals[i], SIG_DFL);
+        }
+
+        crashRecorder = NULL;
+    }
+
+    for (int i = 0; i < FLIGHT_RECORDER_CHUNKS; i++) {
+        free(recorder->chunks[i].buffer);
+        free(recorder->chunks[i].hashes);
+    }
+
+    memset(recorder, 0, sizeof(FlightRecorder));
+}
+
+// Called with the state the input is about to be applied to, like RecordReplayTick
+void RecordFlightTick(FlightRecorder *recorder, const Game *game, const GameInput *input) {
+    ReplayChunkEncoder *encoder = &recorder->chunks[recorder->newest];
+
+    // Rewinding or loading a state breaks the history: what was recorded no longer leads to this tick
+    if (recorder->count > 0 && game->tick != encoder->chunk.firstTick + encoder->chunk.tickCount) {
+        recorder->count = 0;
+    }
+
+    if (recorder->count == 0 || encoder->chunk.tickCount == recorder->keyframeTicks) {
+        recorder->newest = (recorder->newest + 1) % FLIGHT_RECORDER_CHUNKS;
+        encoder = &recorder->chunks[recorder->newest];
+        OpenReplayChunk(encoder, game);
+        recorder->count = recorder->count < FLIGHT_RECORDER_CHUNKS ? recorder->count + 1 : FLIGHT_RECORDER_CHUNKS;
+    }
+
+    AppendReplayTick(encoder, game, input);
+
+    // A keyframe too big for its slot loses the history; the next tick starts over
+    if (encoder->failed) {
+        recorder->count = 0;
+    }
+}
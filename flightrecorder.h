@@ -0,0 +1,33 @@
+#ifndef FLIGHTRECORDER_H
+#define FLIGHTRECORDER_H
+
+#include <stdbool.h>
+#include "replay.h"
+
+#define FLIGHT_RECORDER_SECONDS 10 // history a crash dump holds at least
+#define FLIGHT_RECORDER_KEYFRAME_SECONDS 2
+#define FLIGHT_RECORDER_CHUNKS (FLIGHT_RECORDER_SECONDS / FLIGHT_RECORDER_KEYFRAME_SECONDS + 1) // the newest is partly filled
+#define FLIGHT_RECORDER_STATE_BYTES (64 * 1024) // keyframe room; a full 64 seat game saves under 10 KB
+// Worst case a tick can encode to: run, changed buttons, event count, spawn position, events
+#define FLIGHT_RECORDER_TICK_BYTES (5 + 5 + 5 + sizeof(Vector2) + GAME_INPUT_MAX_EVENTS * (sizeof(float) + 5 + 1))
+#define FLIGHT_RECORDER_HASH_BYTES (1 + HASH_PART_COUNT * sizeof(unsigned int))
+#define FLIGHT_RECORDER_PATH "crash-%ld.replay" // formatted with the start time
+
+// Always-on replay of the last few seconds, encoded as the ticks run into preallocated chunks. A fatal
+// signal writes them out as a recording that --replay loads
+typedef struct FlightRecorder {
+    ReplayChunkEncoder chunks[FLIGHT_RECORDER_CHUNKS];
+    int newest;
+    int count; // chunks holding unbroken history up to and including the newest
+    unsigned int keyframeTicks;
+    char path[256];
+} FlightRecorder;
+
+bool StartFlightRecorder(FlightRecorder *recorder, const char *path);
+void StopFlightRecorder(FlightRecorder *recorder);
+void RecordFlightTick(FlightRecorder *recorder, const Game *game, const GameInput *input);
+bool DumpFlightRecorder(const FlightRecorder *recorder, const char *path);
+void InstallCrashStack(void);
+void RemoveCrashStack(void);
+
+#endif
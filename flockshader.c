@@ -0,0 +1,181 @@
+#include <math.h>
+#include <string.h>
+#include "raylib.h"
+#include "rlgl.h"
+#include "flockshader.h"
+#include "profiler.h"
+
+#define STRINGIFY(x) #x
+#define TO_STRING(x) STRINGIFY(x)
+
+// Walks the slots back to front so overlaps resolve like the per-enemy loop: lower slots on top,
+// each enemy's marker over its own body
+static const char *fragmentSource =
+    "#version 330\n"
+    "in vec2 fragTexCoord;\n"
+    "in vec4 fragColor;\n"
+    "out vec4 finalColor;\n"
+    "uniform sampler2D aliveMask;\n"
+    "uniform sampler2D enemies;\n"
+    "uniform vec4 rowColors[" TO_STRING(ENEMIES_ROWS) "];\n"
+    "uniform vec4 markerColor;\n"
+    "uniform float screenHeight;\n"
+    "uniform int slotCount;\n"
+    "uniform int columns;\n"
+    "uniform float markerRadius;\n"
+    "void main() {\n"
+    "    vec2 p = vec2(gl_FragCoord.x, screenHeight - gl_FragCoord.y);\n"
+    "    vec4 color = vec4(0.0);\n"
+    "    for (int slot = slotCount - 1; slot >= 0; slot--) {\n"
+    "        if (texelFetch(aliveMask, ivec2(slot, 0), 0).r < 0.5) continue;\n"
+    "        vec4 body = texelFetch(enemies, ivec2(slot, 0), 0);\n"
+    "        vec2 centre = texelFetch(enemies, ivec2(slot, 1), 0).xy;\n"
+    "        if (distance(p, centre) <= markerRadius) {\n"
+    "            color = markerColor;\n"
+    "        } else if (all(greaterThanEqual(p, body.xy)) && all(lessThan(p, body.xy + body.zw))) {\n"
+    "            color = rowColors[slot / columns];\n"
+    "        }\n"
+    "    }\n"
+    "    if (color.a == 0.0) discard;\n"
+    "    finalColor = color;\n"
+    "}\n";
+
+static Shader shader;
+static Texture2D maskTexture;
+static Texture2D enemyTexture;
+static int maskLoc;
+static int enemiesLoc;
+static int screenHeightLoc;
+static unsigned long long uploadedMask = 0;
+static int maskUploads = 0;
+static bool ready = false;
+static bool enabled = false;
+
+static Texture2D LoadDataTexture(int height, int format, void *pixels) {
+    Image image = { pixels, FLOCK_SHADER_SLOTS, height, 1, format };
+    Texture2D texture = LoadTextureFromImage(image);
+    SetTextureFilter(texture, TEXTURE_FILTER_POINT);
+
+    return texture;
+}
+
+// Returns false when the shader does not compile, in which case the per-enemy loop stays in use
+bool InitFlockShader(const Color rowColors[ENEMIES_ROWS]) {
+    shader = LoadShaderFromMemory(NULL, fragmentSource);
+
+    if (!IsShaderReady(shader) || shader.id == rlGetShaderIdDefault()) {
+        TraceLog(LOG_WARNING, "FLOCK: Formation shader unavailable, drawing enemies one by one");
+        return false;
+    }
+
+    static unsigned char mask[FLOCK_SHADER_SLOTS];
+    static float enemies[FLOCK_SHADER_SLOTS * 2 * 4];
+    memset(mask, 0, sizeof(mask));
+    memset(enemies, 0, sizeof(enemies));
+    maskTexture = LoadDataTexture(1, PIXELFORMAT_UNCOMPRESSED_GRAYSCALE, mask);
+    enemyTexture = LoadDataTexture(2, PIXELFORMAT_UNCOMPRESSED_R32G32B32A32, enemies);
+    uploadedMask = 0;
+
+    maskLoc = GetShaderLocation(shader, "aliveMask");
+    enemiesLoc = GetShaderLocation(shader, "enemies");
+    screenHeightLoc = GetShaderLocation(shader, "screenHeight");
+
+    Vector4 colors[ENEMIES_ROWS];
+    for (int i = 0; i < ENEMIES_ROWS; i++) {
+        colors[i] = ColorNormalize(rowColors[i]);
+    }
+
+    Vector4 marker = ColorNormalize(YELLOW);
+    int slotCount = MAX_NUM_OF_ENEMIES;
+    int columns = ENEMIES_COLS;
+    float markerRadius = FLOCK_MARKER_RADIUS;
+
+    SetShaderValueV(shader, GetShaderLocation(shader, "rowColors"), colors, SHADER_UNIFORM_VEC4, ENEMIES_ROWS);
+    SetShaderValue(shader, GetShaderLocation(shader, "markerColor"), &marker, SHADER_UNIFORM_VEC4);
+    SetShaderValue(shader, GetShaderLocation(shader, "slotCount"), &slotCount, SHADER_UNIFORM_INT);
+    SetShaderValue(shader, GetShaderLocation(shader, "columns"), &columns, SHADER_UNIFORM_INT);
+    SetShaderValue(shader, GetShaderLocation(shader, "markerRadius"), &markerRadius, SHADER_UNIFORM_FLOAT);
+
+    ready = true;
+
+    return true;
+}
+
+void UnloadFlockShader(void) {
+    if (!ready) {
+        return;
+    }
+
+    UnloadTexture(enemyTexture);
+    UnloadTexture(maskTexture);
+    UnloadShader(shader);
+    ready = false;
+}
+
+void ToggleFlockShader(void) {
+    enabled = !enabled;
+    TraceLog(LOG_INFO, "FLOCK: %s", enabled && ready ? "Formation shader" : "Per-enemy draws");
+}
+
+// Draws the whole flock as one quad over its bounding box; returns false when the caller should draw it
+bool DrawFlockShader(const RenderSnapshot *snapshot) {
+    if (!ready || !enabled || snapshot->enemyCount == 0) {
+        return ready && enabled;
+    }
+
+    static float enemies[FLOCK_SHADER_SLOTS * 2 * 4];
+    unsigned long long mask = 0;
+    Rectangle bounds = { INFINITY, INFINITY, -INFINITY, -INFINITY }; // min and max corners until the end
+
+    for (int i = 0; i < snapshot->enemyCount; i++) {
+        const EnemySnapshot *enemy = &snapshot->enemies[i];
+        float *body = &enemies[enemy->slot * 4];
+        float *centre = &enemies[(FLOCK_SHADER_SLOTS + enemy->slot) * 4];
+
+        // DrawRectangle takes ints, so truncate the same way to keep the two paths pixel-identical
+        body[0] = (int)enemy->body.x;
+        body[1] = (int)enemy->body.y;
+        body[2] = (int)enemy->body.width;
+        body[3] = (int)enemy->body.height;
+        centre[0] = enemy->position.x;
+        centre[1] = enemy->position.y;
+        mask |= 1ull << enemy->slot;
+
+        bounds.x = fminf(bounds.x, fminf(body[0], centre[0] - FLOCK_MARKER_RADIUS));
+        bounds.y = fminf(bounds.y, fminf(body[1], centre[1] - FLOCK_MARKER_RADIUS));
+        bounds.width = fmaxf(bounds.width, fmaxf(body[0] + body[2], centre[0] + FLOCK_MARKER_RADIUS));
+        bounds.height = fmaxf(bounds.height, fmaxf(body[1] + body[3], centre[1] + FLOCK_MARKER_RADIUS));
+    }
+
+    bounds.x = floorf(bounds.x);
+    bounds.y = floorf(bounds.y);
+    bounds.width = ceilf(bounds.width) - bounds.x;
+    bounds.height = ceilf(bounds.height) - bounds.y;
+
+    // Membership only changes on spawns and kills; positions move every tick since each enemy steers itself
+    if (mask != uploadedMask) {
+        unsigned char pixels[FLOCK_SHADER_SLOTS];
+
+        for (int i = 0; i < FLOCK_SHADER_SLOTS; i++) {
+            pixels[i] = (mask >> i) & 1 ? 255 : 0;
+        }
+
+        UpdateTexture(maskTexture, pixels);
+        uploadedMask = mask;
+        maskUploads++;
+        ProfilerSetCounter("flock mask uploads", "%.0f", maskUploads);
+    }
+
+    UpdateTexture(enemyTexture, enemies);
+
+    float screenHeight = GetScreenHeight();
+    SetShaderValue(shader, screenHeightLoc, &screenHeight, SHADER_UNIFORM_FLOAT);
+
+    BeginShaderMode(shader);
+    SetShaderValueTexture(shader, maskLoc, maskTexture);
+    SetShaderValueTexture(shader, enemiesLoc, enemyTexture);
+    DrawRectangleRec(bounds, WHITE);
+    EndShaderMode();
+
+    return true;
+}
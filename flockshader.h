@@ -0,0 +1,15 @@
+#ifndef FLOCKSHADER_H
+#define FLOCKSHADER_H
+
+#include <stdbool.h>
+#include "game.h"
+
+#define FLOCK_SHADER_SLOTS 64 // texels per row; must cover MAX_NUM_OF_ENEMIES
+#define FLOCK_MARKER_RADIUS 5
+
+bool InitFlockShader(const Color rowColors[ENEMIES_ROWS]);
+void UnloadFlockShader(void);
+void ToggleFlockShader(void);
+bool DrawFlockShader(const RenderSnapshot *snapshot);
+
+#endif
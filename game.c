@@ -0,0 +1,888 @@
+#include <string.h>
+#include "raylib.h"
+#include "raymath.h"
+#include "eventlog.h"
+#include "flightrecorder.h"
+#include "game.h"
+#include "profiler.h"
+#include "replay.h"
+#include "rewind.h"
+#include "spectator.h"
+
+void UpdateEnemyDistanceTraveled(March *march, ScalarVector2 position);
+void UpdateStateTimers(void *context, Archetype *archetype);
+void UpdatePilots(void *context, Archetype *archetype);
+void UpdateProjectiles(void *context, Archetype *archetype);
+void MarchEnemies(void *context, Archetype *archetype);
+void CollideProjectilesWithEnemies(void *context, Archetype *archetype);
+void ExpireEnemies(void *context, Archetype *archetype);
+void ApplyTuningInput(Tuning *tuning, unsigned int buttons);
+void InputStage(void *context);
+void PlayerMoveStage(void *context);
+void ProjectileStage(void *context);
+void FlockMarchStage(void *context);
+void CollisionStage(void *context);
+void StateExpiryStage(void *context);
+void HudPrepStage(void *context);
+void FireProjectile(Game *game, Entity owner, ScalarRectangle ownerBody, Scalar tickOffset);
+void DestroyProjectile(Game *game, Entity projectile);
+unsigned long long EntityHashKey(Entity entity);
+unsigned long long FieldHashKey(int field);
+unsigned int ReadWord(const void *data, int word);
+void HashWord(Game *game, HashPart part, unsigned long long key, int field, unsigned long long before, unsigned long long after);
+void HashChange(Game *game, HashPart part, Entity entity, int component, const void *before, const void *after, int size);
+unsigned long long HashRow(const World *world, const Archetype *archetype, int row);
+unsigned long long HashGameFields(const Game *game);
+void AddHashedRow(Game *game, HashPart part, Entity entity);
+void DestroyHashedEntity(Game *game, HashPart part, Entity entity);
+void SetHashedState(Game *game, HashPart part, Entity entity, EntityState *state, int value);
+void LogGameEvent(Game *game, GameEventType type, int seat, Entity entity, ScalarRectangle body, int value);
+bool ValidateGameComponents(const Game *game);
+
+// Field keys: components take 16 words each; tuning and the other game-wide fields act as two more components
+#define HASH_FIELD(component, word) ((component) * 16 + (word))
+#define HASH_TUNING COMPONENT_COUNT
+#define HASH_GAME_FIELD(word) HASH_FIELD(COMPONENT_COUNT + 1, (word))
+#define HASH_GAME_KEY EntityHashKey(ENTITY_NONE)
+#define HASH_STATE_START_TIME HASH_FIELD(COMPONENT_STATE, 1) // the start time is hashed as one 64 bit word
+
+static const char *hashPartNames[HASH_PART_COUNT] = {
+    [HASH_GAME] = "game",
+    [HASH_PLAYERS] = "players",
+    [HASH_PROJECTILES] = "projectiles",
+    [HASH_ENEMIES] = "enemies",
+};
+
+void InitGame(Game *game) {
+    int screenLeftMargin = 10;
+    int screenRightMargin = 10;
+    int screenTopMargin = 10;
+    int screenBottomMargin = 50;
+
+    int componentSizes[COMPONENT_COUNT] = {
+        [COMPONENT_BODY] = sizeof(ScalarRectangle),
+        [COMPONENT_STATE] = sizeof(EntityState),
+        [COMPONENT_POSITION] = sizeof(ScalarVector2),
+        [COMPONENT_MARCH] = sizeof(March),
+        [COMPONENT_PILOT] = sizeof(Pilot),
+        [COMPONENT_OWNER] = sizeof(Entity),
+        [COMPONENT_SLOT] = sizeof(int),
+    };
+
+    InitWorld(&game->world, componentSizes, COMPONENT_COUNT);
+    AddArchetype(&game->world, COMPONENT_BIT(COMPONENT_BODY) | COMPONENT_BIT(COMPONENT_STATE) | COMPONENT_BIT(COMPONENT_PILOT), 1);
+    AddArchetype(&game->world, COMPONENT_BIT(COMPONENT_BODY) | COMPONENT_BIT(COMPONENT_STATE) | COMPONENT_BIT(COMPONENT_OWNER), 1);
+    AddArchetype(&game->world, COMPONENT_BIT(COMPONENT_BODY) | COMPONENT_BIT(COMPONENT_STATE) | COMPONENT_BIT(COMPONENT_POSITION) | COMPONENT_BIT(COMPONENT_MARCH) | COMPONENT_BIT(COMPONENT_SLOT), MAX_NUM_OF_ENEMIES);
+
+    game->tick = 0;
+    game->time = 0;
+    game->pool = NULL;
+    game->profiled = true;
+    game->recorder = NULL;
+    game->rewind = NULL;
+    game->spectators = NULL;
+    game->flightRecorder = NULL;
+    game->events = NULL;
+    game->input.buttons = 0;
+    game->input.sequence = 0;
+    game->input.eventCount = 0;
+    game->hud.lives = 0;
+    game->hud.score = 0;
+
+    game->tuning.maxForce = 0.01;
+    game->tuning.maxHSpeed = 100;
+    game->tuning.maxVSpeed = 100;
+    game->tuning.enemyDistance = 10;
+    game->tuning.flockAwarenessDistance = 200;
+    game->hud.tuning = game->tuning;
+
+    game->boundaries.x = SCALAR(screenLeftMargin);
+    game->boundaries.y = SCALAR(screenTopMargin);
+    game->boundaries.width = SCALAR(SCREEN_WIDTH - screenLeftMargin - screenRightMargin);
+    game->boundaries.height = SCALAR(SCREEN_HEIGHT - screenTopMargin - screenBottomMargin);
+
+    memset(game->seatButtons, 0, sizeof(game->seatButtons));
+    game->player = AddPlayer(game, PILOT_LOCAL);
+
+    game->playerUIRect.width = SCREEN_WIDTH - screenLeftMargin - screenRightMargin;
+    game->playerUIRect.height = screenBottomMargin;
+    game->playerUIRect.x = screenLeftMargin;
+    game->playerUIRect.y = SCALAR_TO_FLOAT(game->boundaries.y + game->boundaries.height);
+
+    Vector2 startPosition = {SCALAR_TO_FLOAT(game->boundaries.x), SCALAR_TO_FLOAT(game->boundaries.y)};
+    InitFlock(game, startPosition);
+    RehashGame(game);
+}
+
+void UnloadGame(Game *game) {
+    UnloadWorld(&game->world);
+}
+
+// Advances the simulation by one fixed tick
+void UpdateGame(Game *game, GameInput input) {
+    FrameGraph *graph = &game->frameGraph;
+
+    // While the key is held, ticks step back through history instead of simulating
+    if (game->rewind != NULL && (input.buttons & INPUT_REWIND)) {
+        RewindGame(game->rewind, game);
+        game->input = input;
+
+        if (game->spectators != NULL) {
+            PublishSpectatorTick(game->spectators, game);
+        }
+
+        return;
+    }
+
+    // Recorded before the tick so a keyframe holds the state the input is applied to
+    if (game->recorder != NULL) {
+        RecordReplayTick(game->recorder, game, &input);
+    }
+
+    if (game->flightRecorder != NULL) {
+        RecordFlightTick(game->flightRecorder, game, &input);
+    }
+
+    HashWord(game, HASH_GAME, HASH_GAME_KEY, HASH_GAME_FIELD(0), game->tick, game->tick + 1);
+    game->tick++;
+    game->time = game->tick * TICK_TIME;
+    game->input = input;
+
+    BeginFrameGraph(graph, game);
+    AddFrameStage(graph, "input", RESOURCE_INPUT, RESOURCE_TUNING | RESOURCE_ENEMIES | RESOURCE_ENTITIES, InputStage);
+    AddFrameStage(graph, "player move", RESOURCE_INPUT, RESOURCE_PLAYERS | RESOURCE_PROJECTILES | RESOURCE_ENTITIES, PlayerMoveStage);
+    AddFrameStage(graph, "projectile", 0, RESOURCE_PROJECTILES | RESOURCE_PLAYERS | RESOURCE_ENTITIES, ProjectileStage);
+    AddFrameStage(graph, "flock march", RESOURCE_TUNING, RESOURCE_ENEMIES, FlockMarchStage);
+    AddFrameStage(graph, "collision", RESOURCE_ENTITIES, RESOURCE_PROJECTILES | RESOURCE_ENEMIES | RESOURCE_PLAYERS, CollisionStage);
+    AddFrameStage(graph, "state expiry", 0, RESOURCE_ENEMIES | RESOURCE_ENTITIES, StateExpiryStage);
+    AddFrameStage(graph, "hud prep", RESOURCE_PLAYERS | RESOURCE_TUNING, RESOURCE_HUD, HudPrepStage);
+
+    RunFrameGraph(graph, game->pool);
+
+    if (game->profiled) {
+        ProfileFrameGraph(graph);
+    }
+
+    if (game->rewind != NULL) {
+        RecordRewindTick(game->rewind, game);
+    }
+
+    if (game->spectators != NULL) {
+        PublishSpectatorTick(game->spectators, game);
+    }
+}
+
+void ApplyTuningInput(Tuning *tuning, unsigned int buttons) {
+    if (buttons & INPUT_FORCE_UP) {
+        tuning->maxForce += 5;
+    }
+
+    if (buttons & INPUT_FORCE_DOWN) {
+        tuning->maxForce -= 5;
+        if (tuning->maxForce < 1) {
+            tuning->maxForce = 1;
+        }
+    }
+
+    if (buttons & INPUT_VSPEED_UP) {
+        tuning->maxVSpeed += 5;
+    }
+
+    if (buttons & INPUT_VSPEED_DOWN) {
+        tuning->maxVSpeed -= 5;
+        if (tuning->maxVSpeed < 5) {
+            tuning->maxVSpeed = 5;
+        }
+    }
+
+    if (buttons & INPUT_HSPEED_UP) {
+        tuning->maxHSpeed += 5;
+    }
+
+    if (buttons & INPUT_HSPEED_DOWN) {
+        tuning->maxHSpeed -= 5;
+        if (tuning->maxHSpeed < 5) {
+            tuning->maxHSpeed = 5;
+        }
+    }
+
+    if (buttons & INPUT_AWARENESS_UP) {
+        tuning->flockAwarenessDistance += 5;
+    }
+
+    if (buttons & INPUT_AWARENESS_DOWN) {
+        tuning->flockAwarenessDistance -= 5;
+        if (tuning->flockAwarenessDistance < 5) {
+            tuning->flockAwarenessDistance = 5;
+        }
+    }
+}
+
+void InputStage(void *context) {
+    Game *game = context;
+    Tuning before = game->tuning;
+
+    ApplyTuningInput(&game->tuning, game->input.buttons);
+    HashChange(game, HASH_GAME, ENTITY_NONE, HASH_TUNING, &before, &game->tuning, sizeof(Tuning));
+
+    if (game->input.buttons & INPUT_SPAWN_FLOCK) {
+        InitFlock(game, game->input.spawnPosition);
+    }
+}
+
+void PlayerMoveStage(void *context) {
+    Game *game = context;
+
+    UpdateStateTimers(game, &game->world.archetypes[ARCHETYPE_PLAYER]);
+    RunSystem(&game->world, COMPONENT_BIT(COMPONENT_BODY) | COMPONENT_BIT(COMPONENT_STATE) | COMPONENT_BIT(COMPONENT_PILOT), UpdatePilots, game);
+}
+
+void ProjectileStage(void *context) {
+    Game *game = context;
+
+    UpdateStateTimers(game, &game->world.archetypes[ARCHETYPE_PROJECTILE]);
+    RunSystem(&game->world, COMPONENT_BIT(COMPONENT_BODY) | COMPONENT_BIT(COMPONENT_STATE) | COMPONENT_BIT(COMPONENT_OWNER), UpdateProjectiles, game);
+}
+
+void FlockMarchStage(void *context) {
+    Game *game = context;
+
+    RunSystem(&game->world, COMPONENT_BIT(COMPONENT_BODY) | COMPONENT_BIT(COMPONENT_STATE) | COMPONENT_BIT(COMPONENT_POSITION) | COMPONENT_BIT(COMPONENT_MARCH), MarchEnemies, game);
+}
+
+void CollisionStage(void *context) {
+    Game *game = context;
+
+    RunSystem(&game->world, COMPONENT_BIT(COMPONENT_BODY) | COMPONENT_BIT(COMPONENT_STATE) | COMPONENT_BIT(COMPONENT_MARCH), CollideProjectilesWithEnemies, game);
+}
+
+void StateExpiryStage(void *context) {
+    Game *game = context;
+
+    UpdateStateTimers(game, &game->world.archetypes[ARCHETYPE_ENEMY]);
+    RunSystem(&game->world, COMPONENT_BIT(COMPONENT_STATE) | COMPONENT_BIT(COMPONENT_MARCH), ExpireEnemies, game);
+}
+
+void HudPrepStage(void *context) {
+    Game *game = context;
+    Archetype *players = &game->world.archetypes[ARCHETYPE_PLAYER];
+    Pilot *pilots = COLUMN(players, Pilot, COMPONENT_PILOT);
+
+    // Scan the rows rather than GetComponent so this stage stays off the entity table
+    for (int i = 0; i < players->count; i++) {
+        if (players->entities[i] == game->player) {
+            game->hud.lives = pilots[i].lives;
+            game->hud.score = pilots[i].score;
+            game->hud.tuning = game->tuning;
+        }
+    }
+}
+
+void UpdateStateTimers(void *context, Archetype *archetype) {
+    Game *game = context;
+    EntityState *states = COLUMN(archetype, EntityState, COMPONENT_STATE);
+
+    for (int i = 0; i < archetype->count; i++) {
+        UpdateEntityState(&states[i], game->time);
+    }
+}
+
+void UpdatePilots(void *context, Archetype *archetype) {
+    Game *game = context;
+    const GameInput *input = &game->input;
+    ScalarRectangle *bodies = COLUMN(archetype, ScalarRectangle, COMPONENT_BODY);
+    EntityState *states = COLUMN(archetype, EntityState, COMPONENT_STATE);
+    Pilot *pilots = COLUMN(archetype, Pilot, COMPONENT_PILOT);
+
+    for (int i = 0; i < archetype->count; i++) {
+        ScalarRectangle *body = &bodies[i];
+        ScalarVector2 startPosition = { body->x, body->y };
+        bool local = pilots[i].seat == PILOT_LOCAL;
+        unsigned int buttons = local ? input->buttons : game->seatButtons[pilots[i].seat];
+        int eventCount = local ? input->eventCount : 0;
+        Scalar offset = 0;
+
+        // Held buttons only change at event offsets, so the tick is played as spans between them
+        for (int e = 0; e <= eventCount; e++) {
+            Scalar end = e < eventCount ? SCALAR_FROM_FLOAT(input->events[e].offset) : SCALAR(1);
+
+            if ((buttons & INPUT_FIRE) && !IsEntityAlive(&game->world, pilots[i].projectile)) {
+                FireProjectile(game, archetype->entities[i], *body, offset);
+            }
+
+            MovePilotBody(body, game->boundaries, buttons, end - offset);
+
+            if (e < eventCount) {
+                if (input->events[e].down) {
+                    buttons |= input->events[e].button;
+                } else {
+                    buttons &= ~input->events[e].button;
+                }
+            }
+
+            offset = end;
+        }
+
+        if (body->x != startPosition.x || body->y != startPosition.y) {
+            HashWord(game, HASH_PLAYERS, EntityHashKey(archetype->entities[i]), HASH_FIELD(COMPONENT_BODY, 0), ReadWord(&startPosition.x, 0), ReadWord(&body->x, 0));
+            SetHashedState(game, HASH_PLAYERS, archetype->entities[i], &states[i], PLAYER_STATE_MOVING);
+        } else {
+            SetHashedState(game, HASH_PLAYERS, archetype->entities[i], &states[i], PLAYER_STATE_IDLE);
+        }
+    }
+}
+
+// One span of a tick; clients predict their own ship with it, so it must stay the server's exact arithmetic
+void MovePilotBody(ScalarRectangle *body, ScalarRectangle boundaries, unsigned int buttons, Scalar fraction) {
+    Scalar step = SCALAR_PER_TICK(SCALAR(PLAYER_SPEED));
+
+    if (buttons & INPUT_LEFT) {
+        body->x -= SCALAR_MUL(step, fraction);
+    }
+
+    if (buttons & INPUT_RIGHT) {
+        body->x += SCALAR_MUL(step, fraction);
+    }
+
+    if (body->x < boundaries.x) {
+        body->x = boundaries.x;
+    } else if (body->x + body->width >= boundaries.x + boundaries.width) {
+        body->x = boundaries.x + boundaries.width - body->width;
+    }
+}
+
+// Network seats start spread along the bottom edge; the local pilot starts at the left
+Entity AddPlayer(Game *game, int seat) {
+    Entity player = CreateEntity(&game->world, ARCHETYPE_PLAYER);
+
+    ScalarRectangle *body = GetComponent(&game->world, player, COMPONENT_BODY);
+    body->width = SCALAR(PLAYER_SIZE);
+    body->height = SCALAR(PLAYER_SIZE);
+    body->x = game->boundaries.x + (seat == PILOT_LOCAL ? 0 : seat * ((game->boundaries.width - body->width) / (MAX_PLAYERS - 1)));
+    body->y = game->boundaries.y + game->boundaries.height - body->height;
+
+    Pilot *pilot = GetComponent(&game->world, player, COMPONENT_PILOT);
+    pilot->projectile = ENTITY_NONE;
+    pilot->lives = PLAYER_MAX_LIVES;
+    pilot->score = 0;
+    pilot->seat = seat;
+
+    EntityState *state = GetComponent(&game->world, player, COMPONENT_STATE);
+    state->value = PLAYER_STATE_IDLE;
+    state->startTime = game->time;
+
+    AddHashedRow(game, HASH_PLAYERS, player);
+    LogGameEvent(game, GAME_EVENT_PLAYER_JOINED, seat, player, *body, 0);
+
+    return player;
+}
+
+void RemovePlayer(Game *game, Entity player) {
+    Pilot *pilot = GetComponent(&game->world, player, COMPONENT_PILOT);
+
+    if (pilot == NULL) {
+        return;
+    }
+
+    if (IsEntityAlive(&game->world, pilot->projectile)) {
+        DestroyProjectile(game, pilot->projectile);
+    }
+
+    LogGameEvent(game, GAME_EVENT_PLAYER_LEFT, pilot->seat, player, *(ScalarRectangle *)GetComponent(&game->world, player, COMPONENT_BODY), pilot->score);
+
+    if (game->player == player) {
+        HashWord(game, HASH_GAME, HASH_GAME_KEY, HASH_GAME_FIELD(1), game->player, ENTITY_NONE);
+        game->player = ENTITY_NONE;
+    }
+
+    DestroyHashedEntity(game, HASH_PLAYERS, player);
+}
+
+void FireProjectile(Game *game, Entity owner, ScalarRectangle ownerBody, Scalar tickOffset) {
+    Entity projectile = CreateEntity(&game->world, ARCHETYPE_PROJECTILE);
+
+    ScalarRectangle *body = GetComponent(&game->world, projectile, COMPONENT_BODY);
+    body->width = SCALAR(PROJECTILE_WIDTH);
+    body->height = SCALAR(PROJECTILE_HEIGHT);
+    body->x = ownerBody.x + ownerBody.width / 2 - body->width / 2;
+    body->y = ownerBody.y - body->height - SCALAR(PROJECTILE_OFFSET_FROM_PLAYER);
+
+    // The projectile stage moves it a whole tick, but it only existed for the rest of this one
+    body->y += SCALAR_MUL(SCALAR_PER_TICK(SCALAR(PROJECTILE_SPEED)), tickOffset);
+
+    EntityState *state = GetComponent(&game->world, projectile, COMPONENT_STATE);
+    state->value = PROJECTILE_STATE_INACTIVE;
+    SetEntityState(state, PROJECTILE_STATE_ACTIVE, game->time);
+
+    *(Entity *)GetComponent(&game->world, projectile, COMPONENT_OWNER) = owner;
+    AddHashedRow(game, HASH_PROJECTILES, projectile);
+
+    Pilot *pilot = GetComponent(&game->world, owner, COMPONENT_PILOT);
+    HashWord(game, HASH_PLAYERS, EntityHashKey(owner), HASH_FIELD(COMPONENT_PILOT, 0), pilot->projectile, projectile);
+    pilot->projectile = projectile;
+    LogGameEvent(game, GAME_EVENT_SHOT, pilot->seat, projectile, *body, 0);
+}
+
+void DestroyProjectile(Game *game, Entity projectile) {
+    Entity owner = *(Entity *)GetComponent(&game->world, projectile, COMPONENT_OWNER);
+    Pilot *pilot = GetComponent(&game->world, owner, COMPONENT_PILOT);
+
+    if (pilot != NULL && pilot->projectile == projectile) {
+        HashWord(game, HASH_PLAYERS, EntityHashKey(owner), HASH_FIELD(COMPONENT_PILOT, 0), projectile, ENTITY_NONE);
+        pilot->projectile = ENTITY_NONE;
+    }
+
+    DestroyHashedEntity(game, HASH_PROJECTILES, projectile);
+}
+
+void UpdateProjectiles(void *context, Archetype *archetype) {
+    Game *game = context;
+    ScalarRectangle *bodies = COLUMN(archetype, ScalarRectangle, COMPONENT_BODY);
+    EntityState *states = COLUMN(archetype, EntityState, COMPONENT_STATE);
+    Scalar step = SCALAR_PER_TICK(SCALAR(PROJECTILE_SPEED));
+
+    // Walk backwards so that swap-back removal only moves rows already visited
+    for (int i = archetype->count - 1; i >= 0; i--) {
+        if (states[i].value == PROJECTILE_STATE_ACTIVE) {
+            Scalar y = bodies[i].y;
+            bodies[i].y -= step;
+            HashWord(game, HASH_PROJECTILES, EntityHashKey(archetype->entities[i]), HASH_FIELD(COMPONENT_BODY, 1), ReadWord(&y, 0), ReadWord(&bodies[i].y, 0));
+
+            // Out of bounds
+            if (bodies[i].y <= game->boundaries.y) {
+                DestroyProjectile(game, archetype->entities[i]);
+            }
+        } else if (states[i].value == PROJECTILE_STATE_EXPLODING) {
+            if (states[i].elapsedTime >= PROJECTILE_EXPLOSION_DURATION) {
+                DestroyProjectile(game, archetype->entities[i]);
+            }
+        }
+    }
+}
+
+void BuildRenderSnapshot(const Game *game, RenderSnapshot *snapshot) {
+    const Archetype *players = &game->world.archetypes[ARCHETYPE_PLAYER];
+    const Archetype *projectiles = &game->world.archetypes[ARCHETYPE_PROJECTILE];
+    const Archetype *enemies = &game->world.archetypes[ARCHETYPE_ENEMY];
+
+    snapshot->tick = game->tick;
+    snapshot->time = game->time;
+    snapshot->inputSequence = game->input.sequence;
+    snapshot->boundaries = ScalarRectangleToFloat(game->boundaries);
+    snapshot->playerUIRect = game->playerUIRect;
+    snapshot->hud = game->hud;
+
+    snapshot->playerCount = players->count < MAX_PLAYERS ? players->count : MAX_PLAYERS;
+    snapshot->localPlayer = 0;
+
+    for (int i = 0; i < snapshot->playerCount; i++) {
+        snapshot->players[i] = ScalarRectangleToFloat(COLUMN(players, ScalarRectangle, COMPONENT_BODY)[i]);
+
+        if (players->entities[i] == game->player) {
+            snapshot->localPlayer = i;
+        }
+    }
+
+    snapshot->projectileCount = projectiles->count < MAX_PLAYERS ? projectiles->count : MAX_PLAYERS;
+
+    for (int i = 0; i < snapshot->projectileCount; i++) {
+        snapshot->projectiles[i].body = ScalarRectangleToFloat(COLUMN(projectiles, ScalarRectangle, COMPONENT_BODY)[i]);
+        snapshot->projectiles[i].state = COLUMN(projectiles, EntityState, COMPONENT_STATE)[i].value;
+        snapshot->projectiles[i].stateStartTime = COLUMN(projectiles, EntityState, COMPONENT_STATE)[i].startTime;
+    }
+
+    snapshot->enemyCount = enemies->count < MAX_NUM_OF_ENEMIES ? enemies->count : MAX_NUM_OF_ENEMIES;
+
+    for (int i = 0; i < snapshot->enemyCount; i++) {
+        EnemySnapshot *enemy = &snapshot->enemies[i];
+        enemy->body = ScalarRectangleToFloat(COLUMN(enemies, ScalarRectangle, COMPONENT_BODY)[i]);
+        enemy->position = ScalarVector2ToFloat(COLUMN(enemies, ScalarVector2, COMPONENT_POSITION)[i]);
+        enemy->state = COLUMN(enemies, EntityState, COMPONENT_STATE)[i].value;
+        enemy->stateStartTime = COLUMN(enemies, EntityState, COMPONENT_STATE)[i].startTime;
+        enemy->slot = COLUMN(enemies, int, COMPONENT_SLOT)[i];
+    }
+}
+
+// Everything a tick reads; input is left out because every tick brings its own
+void SaveGameState(const Game *game, StateWriter *writer) {
+    WriteState(writer, &game->tick, sizeof(game->tick));
+    WriteState(writer, &game->player, sizeof(game->player));
+    WriteState(writer, &game->boundaries, sizeof(game->boundaries));
+    WriteState(writer, &game->playerUIRect, sizeof(game->playerUIRect));
+    WriteState(writer, &game->tuning, sizeof(game->tuning));
+    WriteState(writer, &game->hud, sizeof(game->hud));
+    SaveWorld(&game->world, writer);
+}
+
+// Loads into a game set up by InitGame; on failure the game is left part way and must be reset
+// Seats and slots index arrays and shift masks once loaded, so a damaged keyframe must not reach them
+bool ValidateGameComponents(const Game *game) {
+    const Archetype *players = &game->world.archetypes[ARCHETYPE_PLAYER];
+    const Archetype *enemies = &game->world.archetypes[ARCHETYPE_ENEMY];
+    const Pilot *pilots = COLUMN(players, Pilot, COMPONENT_PILOT);
+    const int *slots = COLUMN(enemies, int, COMPONENT_SLOT);
+
+    for (int i = 0; i < players->count; i++) {
+        if (pilots[i].seat < PILOT_LOCAL || pilots[i].seat >= MAX_PLAYERS) {
+            return false;
+        }
+    }
+
+    for (int i = 0; i < enemies->count; i++) {
+        if (slots[i] < 0 || slots[i] >= MAX_NUM_OF_ENEMIES) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool LoadGameState(Game *game, StateReader *reader) {
+    ReadState(reader, &game->tick, sizeof(game->tick));
+    ReadState(reader, &game->player, sizeof(game->player));
+    ReadState(reader, &game->boundaries, sizeof(game->boundaries));
+    ReadState(reader, &game->playerUIRect, sizeof(game->playerUIRect));
+    ReadState(reader, &game->tuning, sizeof(game->tuning));
+    ReadState(reader, &game->hud, sizeof(game->hud));
+
+    if (reader->failed || !LoadWorld(&game->world, reader)) {
+        return false;
+    }
+
+    if (!ValidateGameComponents(game)) {
+        for (int a = 0; a < game->world.archetypeCount; a++) {
+            ClearArchetype(&game->world, a);
+        }
+
+        return false;
+    }
+
+    game->time = game->tick * TICK_TIME;
+    game->input = (GameInput){ 0 };
+    RehashGame(game);
+
+    return true;
+}
+
+void SetEntityState(EntityState *state, int value, double time) {
+    if (state->value != value) {
+        state->value = value;
+        state->startTime = time;
+    }
+}
+
+void UpdateEntityState(EntityState *state, double time) {
+    state->elapsedTime = time - state->startTime;
+}
+
+void UpdateEnemyDistanceTraveled(March *march, ScalarVector2 position) {
+    march->distanceTraveled = ScalarDistance(march->moveStartPosition, position);
+}
+
+void MarchEnemies(void *context, Archetype *archetype) {
+    Game *game = context;
+    ScalarRectangle *bodies = COLUMN(archetype, ScalarRectangle, COMPONENT_BODY);
+    EntityState *states = COLUMN(archetype, EntityState, COMPONENT_STATE);
+    ScalarVector2 *positions = COLUMN(archetype, ScalarVector2, COMPONENT_POSITION);
+    March *marches = COLUMN(archetype, March, COMPONENT_MARCH);
+    Scalar rightEdge = game->boundaries.x + game->boundaries.width - SCALAR(10);
+    Scalar leftEdge = game->boundaries.x + SCALAR(10);
+    Scalar hStep = SCALAR_PER_TICK(SCALAR_FROM_FLOAT(game->tuning.maxHSpeed));
+    Scalar vStep = SCALAR_PER_TICK(SCALAR_FROM_FLOAT(game->tuning.maxVSpeed));
+    Scalar downDistance = SCALAR_FROM_FLOAT(game->tuning.enemyDistance);
+    unsigned long long xHash = 0;
+    unsigned long long yHash = 0;
+
+    for (int i = 0; i < archetype->count; i++) {
+        ScalarRectangle *body = &bodies[i];
+        ScalarVector2 *position = &positions[i];
+        March *march = &marches[i];
+
+        if (states[i].value == ENEMY_STATE_ACTIVE) {
+            Entity enemy = archetype->entities[i];
+            ScalarVector2 positionBefore = *position;
+            March marchBefore = *march;
+
+            if (march->dir == MOVE_RIGHT) {
+                position->x += hStep;
+
+                if (body->x + body->width >= rightEdge) {
+                    march->previousDir = march->dir;
+                    march->dir = MOVE_DOWN;
+                    march->moveStartPosition = *position;
+                }
+            } else if (march->dir == MOVE_LEFT) {
+                position->x -= hStep;
+
+                if (body->x <= leftEdge) {
+                    march->previousDir = march->dir;
+                    march->dir = MOVE_DOWN;
+                    march->moveStartPosition = *position;
+                }
+            } else if (march->dir == MOVE_DOWN) {
+                // Only the downward leg reads the distance, so skip the sqrt on the others
+                UpdateEnemyDistanceTraveled(march, *position);
+                position->y += vStep;
+
+                if (march->distanceTraveled >= body->height + downDistance) {
+                    if (march->previousDir == MOVE_LEFT) {
+                        march->dir = MOVE_RIGHT;
+                    } else if (march->previousDir == MOVE_RIGHT) {
+                        march->dir = MOVE_LEFT;
+                    }
+                }
+            }
+
+            body->x = position->x - body->width / 2;
+            body->y = position->y - body->height / 2;
+
+            // Every active enemy moves each tick, so position changes are summed here and keyed once below
+            unsigned long long key = EntityHashKey(enemy);
+            xHash += ((unsigned long long)ReadWord(&position->x, 0) - ReadWord(&positionBefore.x, 0)) * key;
+            yHash += ((unsigned long long)ReadWord(&position->y, 0) - ReadWord(&positionBefore.y, 0)) * key;
+
+            if (march->dir == MOVE_DOWN || marchBefore.dir != march->dir) {
+                HashChange(game, HASH_ENEMIES, enemy, COMPONENT_MARCH, &marchBefore, march, sizeof(March));
+            }
+        }
+    }
+
+    game->hash.parts[HASH_ENEMIES] += xHash * FieldHashKey(HASH_FIELD(COMPONENT_POSITION, 0)) + yHash * FieldHashKey(HASH_FIELD(COMPONENT_POSITION, 1));
+}
+
+void CollideProjectilesWithEnemies(void *context, Archetype *archetype) {
+    Game *game = context;
+    Archetype *projectiles = &game->world.archetypes[ARCHETYPE_PROJECTILE];
+    ScalarRectangle *projectileBodies = COLUMN(projectiles, ScalarRectangle, COMPONENT_BODY);
+    EntityState *projectileStates = COLUMN(projectiles, EntityState, COMPONENT_STATE);
+    Entity *projectileOwners = COLUMN(projectiles, Entity, COMPONENT_OWNER);
+    ScalarRectangle *bodies = COLUMN(archetype, ScalarRectangle, COMPONENT_BODY);
+    EntityState *states = COLUMN(archetype, EntityState, COMPONENT_STATE);
+
+    for (int p = 0; p < projectiles->count; p++) {
+        if (projectileStates[p].value != PROJECTILE_STATE_ACTIVE) {
+            continue;
+        }
+
+        // Same test as CheckCollisionRecs, spelled out so the scan over the column stays inlined
+        ScalarRectangle shot = projectileBodies[p];
+
+        for (int i = 0; i < archetype->count; i++) {
+            ScalarRectangle body = bodies[i];
+
+            if (shot.x < body.x + body.width && shot.x + shot.width > body.x &&
+                shot.y < body.y + body.height && shot.y + shot.height > body.y &&
+                states[i].value == ENEMY_STATE_ACTIVE) {
+                SetHashedState(game, HASH_ENEMIES, archetype->entities[i], &states[i], ENEMY_STATE_DYING);
+                SetHashedState(game, HASH_PROJECTILES, projectiles->entities[p], &projectileStates[p], PROJECTILE_STATE_EXPLODING);
+
+                Pilot *pilot = GetComponent(&game->world, projectileOwners[p], COMPONENT_PILOT);
+                if (pilot != NULL) {
+                    HashWord(game, HASH_PLAYERS, EntityHashKey(projectileOwners[p]), HASH_FIELD(COMPONENT_PILOT, 2), pilot->score, pilot->score + 10);
+                    pilot->score += 10;
+                }
+
+                LogGameEvent(game, GAME_EVENT_KILL, pilot != NULL ? pilot->seat : GAME_EVENT_NO_SEAT, archetype->entities[i], body,
+                    pilot != NULL ? pilot->score : 0);
+
+                break;
+            }
+        }
+    }
+}
+
+void ExpireEnemies(void *context, Archetype *archetype) {
+    Game *game = context;
+    EntityState *states = COLUMN(archetype, EntityState, COMPONENT_STATE);
+
+    for (int i = archetype->count - 1; i >= 0; i--) {
+        if (states[i].value == ENEMY_STATE_DYING && states[i].elapsedTime >= ENEMY_DYING_DURATION) {
+            DestroyHashedEntity(game, HASH_ENEMIES, archetype->entities[i]);
+
+            if (archetype->count == 0) {
+                LogGameEvent(game, GAME_EVENT_WAVE_CLEARED, GAME_EVENT_NO_SEAT, ENTITY_NONE, (ScalarRectangle){ 0 }, 0);
+            }
+        }
+    }
+}
+
+void InitFlock(Game *game, Vector2 startPosition) {
+    Scalar enemyDistance = SCALAR_FROM_FLOAT(game->tuning.enemyDistance);
+    Scalar flockWidth = SCALAR(ENEMY_SIZE / 2 + ENEMY_SIZE * ENEMIES_COLS) + enemyDistance * ENEMIES_COLS;
+    ScalarVector2 start = { SCALAR_FROM_FLOAT(startPosition.x), SCALAR_FROM_FLOAT(startPosition.y) };
+    // float flockHeight = ENEMY_SIZE / 2 + ENEMY_SIZE * ENEMIES_ROWS + enemyDistance * ENEMIES_ROWS;
+
+    ClearArchetype(&game->world, ARCHETYPE_ENEMY);
+
+    for (int i = 0; i < MAX_NUM_OF_ENEMIES; i++) {
+        Entity enemy = CreateEntity(&game->world, ARCHETYPE_ENEMY);
+        ScalarRectangle *body = GetComponent(&game->world, enemy, COMPONENT_BODY);
+        ScalarVector2 *position = GetComponent(&game->world, enemy, COMPONENT_POSITION);
+        March *march = GetComponent(&game->world, enemy, COMPONENT_MARCH);
+        EntityState *state = GetComponent(&game->world, enemy, COMPONENT_STATE);
+
+        body->width = SCALAR(ENEMY_SIZE);
+        body->height = SCALAR(ENEMY_SIZE);
+        position->x = start.x + (flockWidth  / 2) + enemyDistance + body->width / 2 + body->width * (i % ENEMIES_COLS) + enemyDistance * (i % ENEMIES_COLS);
+        position->y = start.y + enemyDistance + body->height / 2 + body->height  * (i / ENEMIES_COLS) + enemyDistance * (i / ENEMIES_COLS);
+        body->x = start.x - body->width / 2;
+        body->y = start.y - body->height / 2;
+        state->value = ENEMY_STATE_ACTIVE;
+        state->startTime = game->time;
+        march->dir = MOVE_RIGHT;
+        *(int *)GetComponent(&game->world, enemy, COMPONENT_SLOT) = i;
+    }
+
+    // Rare enough to rehash the whole flock rather than track each removal and creation
+    const Archetype *enemies = &game->world.archetypes[ARCHETYPE_ENEMY];
+    game->hash.parts[HASH_ENEMIES] = 0;
+
+    for (int i = 0; i < enemies->count; i++) {
+        game->hash.parts[HASH_ENEMIES] += HashRow(&game->world, enemies, i);
+    }
+
+    ScalarRectangle origin = { start.x, start.y, 0, 0 };
+    LogGameEvent(game, GAME_EVENT_WAVE_STARTED, GAME_EVENT_NO_SEAT, ENTITY_NONE, origin, enemies->count);
+}
+
+// Costs one branch when events are off; positions are the body's top left
+void LogGameEvent(Game *game, GameEventType type, int seat, Entity entity, ScalarRectangle body, int value) {
+    if (game->events == NULL) {
+        return;
+    }
+
+    GameEvent event = { (unsigned int)game->tick, type, seat, 0, entity, SCALAR_TO_FLOAT(body.x), SCALAR_TO_FLOAT(body.y), value };
+
+    if (type == GAME_EVENT_KILL) {
+        event.slot = *(int *)GetComponent(&game->world, entity, COMPONENT_SLOT);
+    }
+
+    EmitGameEvent(game->events, &event);
+}
+
+unsigned long long EntityHashKey(Entity entity) {
+    unsigned long long key = (entity + 1ull) * 0x9E3779B97F4A7C15ull;
+
+    return (key ^ (key >> 29)) | 1;
+}
+
+// Odd, so no change to a field can be multiplied away
+unsigned long long FieldHashKey(int field) {
+    return (field * 2ull + 1) * 0xD6E8FEB86659FD93ull;
+}
+
+unsigned int ReadWord(const void *data, int word) {
+    unsigned int value;
+    memcpy(&value, (const char *)data + word * sizeof(unsigned int), sizeof(unsigned int));
+
+    return value;
+}
+
+void HashWord(Game *game, HashPart part, unsigned long long key, int field, unsigned long long before, unsigned long long after) {
+    game->hash.parts[part] += (after - before) * key * FieldHashKey(field);
+}
+
+// Component copies taken before and after a write; only the words that differ touch the hash
+void HashChange(Game *game, HashPart part, Entity entity, int component, const void *before, const void *after, int size) {
+    unsigned long long key = EntityHashKey(entity);
+
+    for (int w = 0; w < size / (int)sizeof(unsigned int); w++) {
+        unsigned int from = ReadWord(before, w);
+        unsigned int to = ReadWord(after, w);
+
+        if (from != to) {
+            HashWord(game, part, key, HASH_FIELD(component, w), from, to);
+        }
+    }
+}
+
+// One row's share of its part; the sum is keyed by entity, so swap-back removal leaves other rows' shares alone
+unsigned long long HashRow(const World *world, const Archetype *archetype, int row) {
+    unsigned long long key = EntityHashKey(archetype->entities[row]);
+    unsigned long long hash = 0;
+
+    for (int c = 0; c < world->componentCount; c++) {
+        if (!(archetype->mask & COMPONENT_BIT(c)) || (c == COMPONENT_BODY && (archetype->mask & COMPONENT_BIT(COMPONENT_POSITION)))) {
+            continue;
+        }
+
+        const char *data = (const char *)archetype->columns[c] + (size_t)row * world->componentSizes[c];
+
+        if (c == COMPONENT_STATE) {
+            const EntityState *state = (const EntityState *)data;
+            unsigned long long startTime;
+            memcpy(&startTime, &state->startTime, sizeof(startTime));
+            hash += (unsigned long long)state->value * key * FieldHashKey(HASH_FIELD(COMPONENT_STATE, 0));
+            hash += startTime * key * FieldHashKey(HASH_STATE_START_TIME);
+            continue;
+        }
+
+        for (int w = 0; w < world->componentSizes[c] / (int)sizeof(unsigned int); w++) {
+            hash += ReadWord(data, w) * key * FieldHashKey(HASH_FIELD(c, w));
+        }
+    }
+
+    return hash;
+}
+
+unsigned long long HashGameFields(const Game *game) {
+    unsigned long long key = HASH_GAME_KEY;
+    unsigned long long hash = game->tick * key * FieldHashKey(HASH_GAME_FIELD(0));
+
+    hash += game->player * key * FieldHashKey(HASH_GAME_FIELD(1));
+
+    for (int w = 0; w < (int)(sizeof(Tuning) / sizeof(unsigned int)); w++) {
+        hash += ReadWord(&game->tuning, w) * key * FieldHashKey(HASH_FIELD(HASH_TUNING, w));
+    }
+
+    return hash;
+}
+
+void AddHashedRow(Game *game, HashPart part, Entity entity) {
+    const EntityLocation *location = &game->world.locations[ENTITY_INDEX(entity)];
+    game->hash.parts[part] += HashRow(&game->world, &game->world.archetypes[location->archetype], location->row);
+}
+
+void DestroyHashedEntity(Game *game, HashPart part, Entity entity) {
+    if (!IsEntityAlive(&game->world, entity)) {
+        return;
+    }
+
+    const EntityLocation *location = &game->world.locations[ENTITY_INDEX(entity)];
+    game->hash.parts[part] -= HashRow(&game->world, &game->world.archetypes[location->archetype], location->row);
+    DestroyEntity(&game->world, entity);
+}
+
+void SetHashedState(Game *game, HashPart part, Entity entity, EntityState *state, int value) {
+    if (state->value == value) {
+        return;
+    }
+
+    unsigned long long key = EntityHashKey(entity);
+    unsigned long long startBefore;
+    unsigned long long startAfter;
+
+    memcpy(&startBefore, &state->startTime, sizeof(startBefore));
+    HashWord(game, part, key, HASH_FIELD(COMPONENT_STATE, 0), state->value, value);
+    SetEntityState(state, value, game->time);
+    memcpy(&startAfter, &state->startTime, sizeof(startAfter));
+    HashWord(game, part, key, HASH_STATE_START_TIME, startBefore, startAfter);
+}
+
+// Full recount, the reference the incremental updates must match; needed after any bulk state load
+void RehashGame(Game *game) {
+    memset(&game->hash, 0, sizeof(StateHash));
+    game->hash.parts[HASH_GAME] = HashGameFields(game);
+
+    for (int a = 0; a < game->world.archetypeCount; a++) {
+        const Archetype *archetype = &game->world.archetypes[a];
+
+        for (int i = 0; i < archetype->count; i++) {
+            game->hash.parts[HASH_PLAYERS + a] += HashRow(&game->world, archetype, i);
+        }
+    }
+}
+
+const char *GetHashPartName(int part) {
+    return part >= 0 && part < HASH_PART_COUNT ? hashPartNames[part] : "unknown";
+}
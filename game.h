@@ -0,0 +1,240 @@
+#ifndef GAME_H
+#define GAME_H
+
+#include "raylib.h"
+#include "ecs.h"
+#include "scheduler.h"
+#include "scalar.h"
+
+#define SCREEN_WIDTH 800
+#define SCREEN_HEIGHT 800
+#define PLAYER_SPEED 200
+#define PLAYER_SIZE 50
+#define PLAYER_MAX_LIVES 3
+#define PLAYER_MAX_SCORE 9999
+#define PROJECTILE_SPEED 600
+#define PROJECTILE_WIDTH 5
+#define PROJECTILE_HEIGHT 20
+#define PROJECTILE_OFFSET_FROM_PLAYER 10
+#define PROJECTILE_EXPLOSION_DURATION 0.5 // seconds
+#define ENEMIES_COLS 11
+#define ENEMIES_ROWS 5
+#define MAX_NUM_OF_ENEMIES ENEMIES_ROWS * ENEMIES_COLS
+#define ENEMY_SIZE 50
+#define ENEMY_VERTICAL_MAX_DISTANCE 50
+#define ENEMY_DYING_DURATION 0.5
+#define MAX_PLAYERS 64
+#define PILOT_LOCAL -1 // seat of the pilot played from this machine's input
+#define TICK_RATE 144
+#define TICK_TIME (1.0 / TICK_RATE)
+#define GAME_INPUT_MAX_EVENTS 16
+
+typedef struct ReplayWriter ReplayWriter;
+typedef struct RewindBuffer RewindBuffer;
+typedef struct SpectatorFeed SpectatorFeed;
+typedef struct FlightRecorder FlightRecorder;
+typedef struct EventLog EventLog;
+
+typedef enum EntityStateValue {
+    PLAYER_STATE_IDLE,
+    PLAYER_STATE_MOVING,
+    PLAYER_STATE_FIRING,
+    PROJECTILE_STATE_ACTIVE,
+    PROJECTILE_STATE_EXPLODING,
+    PROJECTILE_STATE_INACTIVE,
+    ENEMY_STATE_ACTIVE,
+    ENEMY_STATE_DYING,
+    ENEMY_STATE_DEAD,
+} EntityStateValue;
+
+typedef enum MoveDirValue {
+    MOVE_NOTSET,
+    MOVE_RIGHT,
+    MOVE_DOWN,
+    MOVE_LEFT,
+} MoveDirValue;
+
+typedef enum ComponentType {
+    COMPONENT_BODY,       // ScalarRectangle
+    COMPONENT_STATE,      // EntityState
+    COMPONENT_POSITION,   // ScalarVector2, centre of the entity
+    COMPONENT_MARCH,      // March
+    COMPONENT_PILOT,      // Pilot
+    COMPONENT_OWNER,      // Entity that fired the projectile
+    COMPONENT_SLOT,       // int, cell of the enemy in the flock grid
+    COMPONENT_COUNT,
+} ComponentType;
+
+typedef enum InputButton {
+    INPUT_LEFT = 1 << 0,
+    INPUT_RIGHT = 1 << 1,
+    INPUT_FIRE = 1 << 2,
+    INPUT_FORCE_UP = 1 << 3,
+    INPUT_FORCE_DOWN = 1 << 4,
+    INPUT_VSPEED_UP = 1 << 5,
+    INPUT_VSPEED_DOWN = 1 << 6,
+    INPUT_HSPEED_UP = 1 << 7,
+    INPUT_HSPEED_DOWN = 1 << 8,
+    INPUT_AWARENESS_UP = 1 << 9,
+    INPUT_AWARENESS_DOWN = 1 << 10,
+    INPUT_SPAWN_FLOCK = 1 << 11,
+    INPUT_REWIND = 1 << 12,
+} InputButton;
+
+// Buttons that report held state; the rest are edges that must reach exactly one tick
+#define INPUT_HELD_MASK (INPUT_LEFT | INPUT_RIGHT | INPUT_FIRE | INPUT_REWIND)
+
+// Parts of Game the update stages declare as read or written, so the scheduler can order them
+typedef enum GameResource {
+    RESOURCE_INPUT = 1 << 0,
+    RESOURCE_TUNING = 1 << 1,
+    RESOURCE_ENTITIES = 1 << 2, // entity table: create, destroy and handle lookups
+    RESOURCE_PLAYERS = 1 << 3,
+    RESOURCE_PROJECTILES = 1 << 4,
+    RESOURCE_ENEMIES = 1 << 5,
+    RESOURCE_HUD = 1 << 6,
+} GameResource;
+
+typedef enum ArchetypeType {
+    ARCHETYPE_PLAYER,
+    ARCHETYPE_PROJECTILE,
+    ARCHETYPE_ENEMY,
+} ArchetypeType;
+
+// Subsystems hashed separately so a desync can be traced; entity parts follow the archetype order
+typedef enum HashPart {
+    HASH_GAME, // tick, tuning and the player handle
+    HASH_PLAYERS, // bodies, states, lives and scores
+    HASH_PROJECTILES, // player bullets
+    HASH_ENEMIES, // the flock: positions, states, march and slots
+    HASH_PART_COUNT,
+} HashPart;
+
+// Sum over every hashed field of value * entity key * field key, so a write updates it in O(1).
+// Derived fields (elapsed state time, the HUD, bodies recomputed from a position) and constants
+// (the boundaries) are left out
+typedef struct StateHash {
+    unsigned long long parts[HASH_PART_COUNT];
+} StateHash;
+
+typedef struct EntityState {
+    EntityStateValue value;
+    double startTime;
+    double elapsedTime;
+} EntityState;
+
+typedef struct March {
+    MoveDirValue dir;
+    MoveDirValue previousDir;
+    ScalarVector2 moveStartPosition;
+    Scalar distanceTraveled;
+} March;
+
+typedef struct Pilot {
+    Entity projectile;
+    int lives;
+    int score;
+    int seat; // PILOT_LOCAL, or the network seat whose buttons it plays
+} Pilot;
+
+// Held button change inside a tick; offset is the fraction of the tick elapsed when it happened
+typedef struct GameInputEvent {
+    float offset;
+    unsigned int button;
+    bool down;
+} GameInputEvent;
+
+typedef struct GameInput {
+    unsigned int buttons; // held state at the start of the tick, plus edges
+    unsigned int sequence; // bumped by the sampler on every change, echoed back in snapshots
+    Vector2 spawnPosition;
+    GameInputEvent events[GAME_INPUT_MAX_EVENTS]; // in offset order; empty when input is polled per frame
+    int eventCount;
+} GameInput;
+
+// Stays float in either build: it only changes by whole steps added or taken away, which round the same
+// on every build, and the simulation converts it to Scalar where it reads it
+typedef struct Tuning {
+    float maxForce;
+    float maxHSpeed;
+    float maxVSpeed;
+    float enemyDistance;
+    float flockAwarenessDistance;
+} Tuning;
+
+typedef struct HudState {
+    int lives;
+    int score;
+    Tuning tuning;
+} HudState;
+
+typedef struct ProjectileSnapshot {
+    Rectangle body;
+    EntityStateValue state;
+    double stateStartTime;
+} ProjectileSnapshot;
+
+typedef struct EnemySnapshot {
+    Rectangle body;
+    Vector2 position;
+    EntityStateValue state;
+    double stateStartTime;
+    int slot;
+} EnemySnapshot;
+
+// Everything RenderGame reads, copied out of the simulation once per tick
+typedef struct RenderSnapshot {
+    unsigned long long tick;
+    double time;
+    double publishTime;
+    unsigned int inputSequence;
+    Rectangle boundaries;
+    Rectangle playerUIRect;
+    Rectangle players[MAX_PLAYERS];
+    int playerCount;
+    int localPlayer;
+    ProjectileSnapshot projectiles[MAX_PLAYERS];
+    int projectileCount;
+    EnemySnapshot enemies[MAX_NUM_OF_ENEMIES];
+    int enemyCount;
+    HudState hud;
+} RenderSnapshot;
+
+typedef struct Game {
+    World world;
+    Entity player;
+    ScalarRectangle boundaries;
+    Rectangle playerUIRect;
+    Tuning tuning;
+    GameInput input;
+    unsigned int seatButtons[MAX_PLAYERS]; // held buttons of network seats, set before each tick
+    HudState hud;
+    StateHash hash; // kept current by every write the tick makes
+    unsigned long long tick;
+    double time;
+    FrameGraph frameGraph;
+    ThreadPool *pool;
+    bool profiled; // off for batch runs, where many games ticking at once would queue on the profiler's lock
+    ReplayWriter *recorder; // NULL unless the session is being recorded
+    RewindBuffer *rewind; // NULL when rewind is off; it is off while recording, since replays only go forward
+    SpectatorFeed *spectators; // NULL unless viewer processes are fed
+    FlightRecorder *flightRecorder; // NULL when crash dumps are off
+    EventLog *events; // NULL unless gameplay events are logged
+} Game;
+
+void InitGame(Game *game);
+void UnloadGame(Game *game);
+void UpdateGame(Game *game, GameInput input);
+void BuildRenderSnapshot(const Game *game, RenderSnapshot *snapshot);
+void SaveGameState(const Game *game, StateWriter *writer);
+bool LoadGameState(Game *game, StateReader *reader);
+void RehashGame(Game *game);
+const char *GetHashPartName(int part);
+void InitFlock(Game *game, Vector2 startPosition);
+Entity AddPlayer(Game *game, int seat);
+void RemovePlayer(Game *game, Entity player);
+void MovePilotBody(ScalarRectangle *body, ScalarRectangle boundaries, unsigned int buttons, Scalar fraction);
+void SetEntityState(EntityState *state, int value, double time);
+void UpdateEntityState(EntityState *state, double time);
+
+#endif
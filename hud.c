@@ -0,0 +1,196 @@
+#include <stdio.h>
+#include <string.h>
+#include "raylib.h"
+#include "hud.h"
+#include "profiler.h"
+
+// One numeric field of the status line and the label in front of it
+typedef struct HudField {
+    const char *label;
+    const char *format;
+    double value;
+    char text[16];
+    float labelX;
+    float valueX;
+    float valueWidth;
+} HudField;
+
+static HudField fields[HUD_FIELD_COUNT] = {
+    { "Lives ", "%.0f" },
+    { " Score ", "%.0f" },
+    { " Max force ", "%0.1f" },
+    { " Speed H", "%0.1f" },
+    { " V", "%0.1f" },
+    { " Flock awareness distance ", "%0.1f" },
+};
+
+static RenderTexture2D target;
+static RenderTexture2D glyphStrip;
+static Rectangle glyphs[HUD_GLYPH_COUNT];
+static float spacing;
+static bool valid = false;
+static int redraws = 0;
+
+// Bakes the characters numbers are made of into one strip, so a changed value is a few quads
+static void BakeGlyphStrip(void) {
+    Font font = GetFontDefault();
+    float x = 0;
+
+    for (int i = 0; i < HUD_GLYPH_COUNT; i++) {
+        char glyph[2] = { HUD_GLYPHS[i], '\0' };
+        glyphs[i].x = x;
+        glyphs[i].y = 0;
+        glyphs[i].width = MeasureTextEx(font, glyph, HUD_FONT_SIZE, spacing).x;
+        glyphs[i].height = HUD_FONT_SIZE;
+        x += glyphs[i].width + spacing;
+    }
+
+    glyphStrip = LoadRenderTexture(x, HUD_FONT_SIZE);
+
+    BeginTextureMode(glyphStrip);
+    ClearBackground(BLANK);
+
+    for (int i = 0; i < HUD_GLYPH_COUNT; i++) {
+        char glyph[2] = { HUD_GLYPHS[i], '\0' };
+        DrawTextEx(font, glyph, (Vector2){ glyphs[i].x, 0 }, HUD_FONT_SIZE, spacing, WHITE);
+    }
+
+    EndTextureMode();
+}
+
+void InitHud(int width, int height) {
+    spacing = HUD_FONT_SIZE / 10; // DrawText spacing for the default font
+    target = LoadRenderTexture(width, height);
+    BakeGlyphStrip();
+    valid = false;
+}
+
+void UnloadHud(void) {
+    UnloadRenderTexture(glyphStrip);
+    UnloadRenderTexture(target);
+}
+
+static float MeasureValue(const char *text) {
+    float width = 0;
+
+    for (const char *c = text; *c != '\0'; c++) {
+        const char *glyph = strchr(HUD_GLYPHS, *c);
+
+        if (glyph != NULL) {
+            width += glyphs[glyph - HUD_GLYPHS].width + spacing;
+        }
+    }
+
+    return width > 0 ? width - spacing : 0;
+}
+
+static void DrawValue(const HudField *field) {
+    float x = field->valueX;
+
+    for (const char *c = field->text; *c != '\0'; c++) {
+        const char *glyph = strchr(HUD_GLYPHS, *c);
+
+        if (glyph == NULL) {
+            continue;
+        }
+
+        // Render textures are stored upside down, hence the negative source height
+        Rectangle source = glyphs[glyph - HUD_GLYPHS];
+        source.height = -source.height;
+        DrawTextureRec(glyphStrip.texture, source, (Vector2){ x, HUD_TEXT_OFFSET }, YELLOW);
+        x += source.width + spacing;
+    }
+}
+
+static void ClearRegion(float x, float width) {
+    DrawRectangle(x, 0, width, target.texture.height, BLACK);
+}
+
+// Lays out and draws fields from index first on; everything to its left stays as it is
+static void RelayoutFrom(int first) {
+    float x = fields[first].valueX;
+    ClearRegion(x, target.texture.width - x);
+
+    for (int i = first; i < HUD_FIELD_COUNT; i++) {
+        HudField *field = &fields[i];
+
+        if (i > first) {
+            field->labelX = x;
+            DrawText(field->label, x, HUD_TEXT_OFFSET, HUD_FONT_SIZE, YELLOW);
+            field->valueX = x + MeasureText(field->label, HUD_FONT_SIZE) + spacing;
+        }
+
+        DrawValue(field);
+        x = field->valueX + field->valueWidth + spacing;
+    }
+}
+
+// Re-renders only the fields whose value changed; a width change shifts everything after it
+void UpdateHud(const HudState *hud) {
+    double values[HUD_FIELD_COUNT] = {
+        hud->lives,
+        hud->score,
+        hud->tuning.maxForce,
+        hud->tuning.maxHSpeed,
+        hud->tuning.maxVSpeed,
+        hud->tuning.flockAwarenessDistance,
+    };
+
+    int relayout = valid ? HUD_FIELD_COUNT : 0;
+    bool dirty[HUD_FIELD_COUNT] = { false };
+    bool anyDirty = !valid;
+
+    for (int i = 0; i < HUD_FIELD_COUNT; i++) {
+        HudField *field = &fields[i];
+
+        if (valid && field->value == values[i]) {
+            continue;
+        }
+
+        float previousWidth = field->valueWidth;
+        field->value = values[i];
+        snprintf(field->text, sizeof(field->text), field->format, field->value);
+        field->valueWidth = MeasureValue(field->text);
+        dirty[i] = true;
+        anyDirty = true;
+
+        if (field->valueWidth != previousWidth && i < relayout) {
+            relayout = i;
+        }
+    }
+
+    if (!anyDirty) {
+        return;
+    }
+
+    BeginTextureMode(target);
+
+    if (!valid) {
+        ClearBackground(BLACK);
+        fields[0].labelX = 0;
+        DrawText(fields[0].label, 0, HUD_TEXT_OFFSET, HUD_FONT_SIZE, YELLOW);
+        fields[0].valueX = MeasureText(fields[0].label, HUD_FONT_SIZE) + spacing;
+    }
+
+    for (int i = 0; i < relayout; i++) {
+        if (dirty[i]) {
+            ClearRegion(fields[i].valueX, fields[i].valueWidth);
+            DrawValue(&fields[i]);
+        }
+    }
+
+    if (relayout < HUD_FIELD_COUNT) {
+        RelayoutFrom(relayout);
+    }
+
+    EndTextureMode();
+
+    valid = true;
+    redraws++;
+    ProfilerSetCounter("hud redraws", "%.0f", redraws);
+}
+
+void DrawHud(int x, int y) {
+    Rectangle source = { 0, 0, target.texture.width, -target.texture.height };
+    DrawTextureRec(target.texture, source, (Vector2){ x, y }, WHITE);
+}
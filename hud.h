@@ -0,0 +1,17 @@
+#ifndef HUD_H
+#define HUD_H
+
+#include "game.h"
+
+#define HUD_FONT_SIZE 20
+#define HUD_TEXT_OFFSET 10
+#define HUD_GLYPHS "0123456789.-"
+#define HUD_GLYPH_COUNT 12
+#define HUD_FIELD_COUNT 6
+
+void InitHud(int width, int height);
+void UnloadHud(void);
+void UpdateHud(const HudState *hud);
+void DrawHud(int x, int y);
+
+#endif
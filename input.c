@@ -0,0 +1,235 @@
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "input.h"
+#include "profiler.h"
+// After raylib.h: this redefines the KEY_* names as Linux key codes
+#include <linux/input.h>
+
+#define TEST_BIT(bits, bit) ((bits)[(bit) / 8] & (1 << ((bit) % 8)))
+
+static unsigned int MapKey(unsigned short code) {
+    switch (code) {
+        case KEY_LEFT: return INPUT_LEFT;
+        case KEY_RIGHT: return INPUT_RIGHT;
+        case KEY_SPACE: return INPUT_FIRE;
+        case KEY_1: return INPUT_FORCE_UP;
+        case KEY_2: return INPUT_FORCE_DOWN;
+        case KEY_3: return INPUT_VSPEED_UP;
+        case KEY_4: return INPUT_VSPEED_DOWN;
+        case KEY_5: return INPUT_HSPEED_UP;
+        case KEY_6: return INPUT_HSPEED_DOWN;
+        case KEY_7: return INPUT_AWARENESS_UP;
+        case KEY_8: return INPUT_AWARENESS_DOWN;
+        case KEY_BACKSPACE: return INPUT_REWIND;
+        default: return 0;
+    }
+}
+
+void InitInputQueue(InputQueue *queue) {
+    atomic_init(&queue->head, 0);
+    atomic_init(&queue->tail, 0);
+}
+
+bool PushInputEvent(InputQueue *queue, InputEvent event) {
+    unsigned int head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    unsigned int tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+
+    if (head - tail == INPUT_QUEUE_CAPACITY) {
+        return false;
+    }
+
+    queue->events[head & (INPUT_QUEUE_CAPACITY - 1)] = event;
+    atomic_store_explicit(&queue->head, head + 1, memory_order_release);
+
+    return true;
+}
+
+bool PeekInputEvent(InputQueue *queue, InputEvent *event) {
+    unsigned int tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    unsigned int head = atomic_load_explicit(&queue->head, memory_order_acquire);
+
+    if (head == tail) {
+        return false;
+    }
+
+    *event = queue->events[tail & (INPUT_QUEUE_CAPACITY - 1)];
+
+    return true;
+}
+
+void PopInputEvent(InputQueue *queue) {
+    unsigned int tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
+}
+
+// Opens every evdev node that looks like a keyboard and switches its timestamps to CLOCK_MONOTONIC
+static void OpenKeyboards(InputThread *input) {
+    for (int i = 0; i < 32 && input->deviceCount < INPUT_MAX_DEVICES; i++) {
+        char path[32];
+        snprintf(path, sizeof(path), "/dev/input/event%d", i);
+
+        int fd = open(path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+        if (fd < 0) {
+            continue;
+        }
+
+        unsigned char keys[KEY_MAX / 8 + 1] = { 0 };
+
+        if (ioctl(fd, EVIOCGBIT(EV_KEY, sizeof(keys)), keys) < 0 || !TEST_BIT(keys, KEY_SPACE) || !TEST_BIT(keys, KEY_LEFT)) {
+            close(fd);
+            continue;
+        }
+
+        int clock = CLOCK_MONOTONIC;
+
+        if (ioctl(fd, EVIOCSCLOCKID, &clock) < 0) {
+            TraceLog(LOG_WARNING, "INPUT: %s has no monotonic timestamps, skipping", path);
+            close(fd);
+            continue;
+        }
+
+        input->devices[input->deviceCount++] = fd;
+        TraceLog(LOG_INFO, "INPUT: Reading key events from %s", path);
+    }
+}
+
+static void ReadDevice(InputThread *input, int fd) {
+    struct input_event events[64];
+    ssize_t size;
+
+    while ((size = read(fd, events, sizeof(events))) > 0) {
+        int count = size / sizeof(struct input_event);
+
+        for (int i = 0; i < count; i++) {
+            // Value 2 is auto-repeat, which carries no new state
+            if (events[i].type != EV_KEY || events[i].value == 2) {
+                continue;
+            }
+
+            unsigned int button = MapKey(events[i].code);
+            if (button == 0) {
+                continue;
+            }
+
+            InputEvent event;
+            event.time = events[i].input_event_sec + events[i].input_event_usec * 1e-6;
+            event.button = button;
+            event.down = events[i].value == 1;
+
+            if (!PushInputEvent(&input->queue, event)) {
+                atomic_fetch_add(&input->dropped, 1);
+            }
+        }
+    }
+}
+
+// Blocks in poll() rather than spinning: the kernel stamps each event, so wake-up latency costs no precision
+static void *InputMain(void *argument) {
+    InputThread *input = argument;
+    struct pollfd fds[INPUT_MAX_DEVICES];
+
+    for (int i = 0; i < input->deviceCount; i++) {
+        fds[i].fd = input->devices[i];
+        fds[i].events = POLLIN;
+    }
+
+    while (!atomic_load(&input->quit)) {
+        if (poll(fds, input->deviceCount, INPUT_POLL_TIMEOUT) <= 0) {
+            continue;
+        }
+
+        for (int i = 0; i < input->deviceCount; i++) {
+            if (fds[i].revents & POLLIN) {
+                ReadDevice(input, fds[i].fd);
+            }
+        }
+    }
+
+    return NULL;
+}
+
+// Returns false when no keyboard can be read, in which case callers keep polling through raylib
+bool StartInputThread(InputThread *input) {
+    InitInputQueue(&input->queue);
+    input->deviceCount = 0;
+    input->down = 0;
+    atomic_init(&input->quit, false);
+    atomic_init(&input->dropped, 0);
+
+    OpenKeyboards(input);
+
+    if (input->deviceCount == 0) {
+        TraceLog(LOG_WARNING, "INPUT: No readable keyboard under /dev/input, using per-frame polling");
+        return false;
+    }
+
+    if (pthread_create(&input->thread, NULL, InputMain, input) != 0) {
+        TraceLog(LOG_WARNING, "INPUT: Failed to start input thread, using per-frame polling");
+        atomic_store(&input->quit, true);
+        StopInputThread(input);
+        return false;
+    }
+
+    return true;
+}
+
+void StopInputThread(InputThread *input) {
+    if (!atomic_load(&input->quit) && input->deviceCount > 0) {
+        atomic_store(&input->quit, true);
+        pthread_join(input->thread, NULL);
+    }
+
+    for (int i = 0; i < input->deviceCount; i++) {
+        close(input->devices[i]);
+    }
+
+    input->deviceCount = 0;
+}
+
+// Replaces the polled keyboard state in gameInput with the events stamped before tickEnd
+void DrainInputEvents(InputThread *input, double tickStart, double tickEnd, GameInput *gameInput) {
+    InputEvent event;
+    double now = GetMonotonicTime();
+
+    gameInput->buttons &= ~INPUT_KEYBOARD_MASK;
+    gameInput->buttons |= input->down & INPUT_HELD_MASK;
+    gameInput->eventCount = 0;
+
+    while (PeekInputEvent(&input->queue, &event) && event.time < tickEnd) {
+        PopInputEvent(&input->queue);
+        ProfilerRecord("input event delay", "%.3f ms", (now - event.time) * 1000);
+
+        bool changed = ((input->down & event.button) != 0) != event.down;
+        if (!changed) {
+            continue;
+        }
+
+        if (event.down) {
+            input->down |= event.button;
+        } else {
+            input->down &= ~event.button;
+        }
+
+        // Edge buttons fire once however briefly they were down; held ones keep their timing
+        if (!(event.button & INPUT_HELD_MASK)) {
+            if (event.down) {
+                gameInput->buttons |= event.button;
+            }
+        } else if (gameInput->eventCount < GAME_INPUT_MAX_EVENTS) {
+            GameInputEvent *tickEvent = &gameInput->events[gameInput->eventCount++];
+            float offset = (event.time - tickStart) / (tickEnd - tickStart);
+            float previous = gameInput->eventCount > 1 ? tickEvent[-1].offset : 0;
+
+            // Events from separate devices can interleave slightly out of order
+            tickEvent->offset = offset < previous ? previous : offset;
+            tickEvent->button = event.button;
+            tickEvent->down = event.down;
+        }
+    }
+
+    ProfilerSetCounter("input events dropped", "%.0f", atomic_load(&input->dropped));
+}
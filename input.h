@@ -0,0 +1,47 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include "game.h"
+
+#define INPUT_QUEUE_CAPACITY 1024 // power of two
+#define INPUT_MAX_DEVICES 8
+#define INPUT_POLL_TIMEOUT 10 // milliseconds, only bounds how long StopInputThread waits
+
+// Buttons the event thread owns; the mouse still comes from raylib through the mailbox
+#define INPUT_KEYBOARD_MASK (~(unsigned int)INPUT_SPAWN_FLOCK)
+
+typedef struct InputEvent {
+    double time; // GetMonotonicTime clock, stamped by the kernel when the key changed
+    unsigned int button;
+    bool down;
+} InputEvent;
+
+// Single producer, single consumer ring; head and tail count up forever and wrap on read
+typedef struct InputQueue {
+    InputEvent events[INPUT_QUEUE_CAPACITY];
+    atomic_uint head; // written by the producer
+    atomic_uint tail; // written by the consumer
+} InputQueue;
+
+typedef struct InputThread {
+    pthread_t thread;
+    InputQueue queue;
+    int devices[INPUT_MAX_DEVICES];
+    int deviceCount;
+    atomic_bool quit;
+    atomic_uint dropped;
+    unsigned int down; // owned by the consumer: held buttons after the last drained event
+} InputThread;
+
+void InitInputQueue(InputQueue *queue);
+bool PushInputEvent(InputQueue *queue, InputEvent event);
+bool PeekInputEvent(InputQueue *queue, InputEvent *event);
+void PopInputEvent(InputQueue *queue);
+bool StartInputThread(InputThread *input);
+void StopInputThread(InputThread *input);
+void DrainInputEvents(InputThread *input, double tickStart, double tickEnd, GameInput *gameInput);
+
+#endif
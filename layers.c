@@ -0,0 +1,81 @@
+#include <string.h>
+#include "raylib.h"
+#include "layers.h"
+#include "profiler.h"
+
+typedef void (*LayerRenderFunc)(const RenderSnapshot *snapshot);
+
+typedef struct Layer {
+    const char *counterName;
+    LayerRenderFunc render;
+    RenderTexture2D target;
+    bool valid;
+    int redraws;
+} Layer;
+
+static void RenderBackground(const RenderSnapshot *snapshot);
+static void RenderChrome(const RenderSnapshot *snapshot);
+
+static Layer layers[LAYER_COUNT] = {
+    [LAYER_BACKGROUND] = { "background redraws", RenderBackground },
+    [LAYER_CHROME] = { "chrome redraws", RenderChrome },
+};
+
+static Rectangle boundaries;
+
+static void RenderBackground(const RenderSnapshot *snapshot) {
+    ClearBackground(BLACK);
+}
+
+static void RenderChrome(const RenderSnapshot *snapshot) {
+    ClearBackground(BLANK);
+    DrawRectangleLines(snapshot->boundaries.x, snapshot->boundaries.y, snapshot->boundaries.width, snapshot->boundaries.height, DARKBROWN);
+}
+
+void InitLayers(int width, int height) {
+    for (int i = 0; i < LAYER_COUNT; i++) {
+        layers[i].target = LoadRenderTexture(width, height);
+        layers[i].valid = false;
+        layers[i].redraws = 0;
+    }
+}
+
+void UnloadLayers(void) {
+    for (int i = 0; i < LAYER_COUNT; i++) {
+        UnloadRenderTexture(layers[i].target);
+    }
+}
+
+void InvalidateLayer(StaticLayer layer) {
+    layers[layer].valid = false;
+}
+
+// Re-renders invalidated layers; call before BeginDrawing
+void UpdateLayers(const RenderSnapshot *snapshot) {
+    if (memcmp(&boundaries, &snapshot->boundaries, sizeof(Rectangle)) != 0) {
+        boundaries = snapshot->boundaries;
+        InvalidateLayer(LAYER_CHROME);
+    }
+
+    for (int i = 0; i < LAYER_COUNT; i++) {
+        Layer *layer = &layers[i];
+
+        if (layer->valid) {
+            continue;
+        }
+
+        BeginTextureMode(layer->target);
+        layer->render(snapshot);
+        EndTextureMode();
+
+        layer->valid = true;
+        layer->redraws++;
+        ProfilerSetCounter(layer->counterName, "%.0f", layer->redraws);
+    }
+}
+
+void DrawLayer(StaticLayer layer) {
+    Texture2D texture = layers[layer].target.texture;
+    Rectangle source = { 0, 0, texture.width, -texture.height };
+    DrawTextureRec(texture, source, (Vector2){ 0, 0 }, WHITE);
+}
@@ -0,0 +1,19 @@
+#ifndef LAYERS_H
+#define LAYERS_H
+
+#include "game.h"
+
+// Parts of the frame that do not move; each lives in its own render texture until invalidated
+typedef enum StaticLayer {
+    LAYER_BACKGROUND,
+    LAYER_CHROME,
+    LAYER_COUNT,
+} StaticLayer;
+
+void InitLayers(int width, int height);
+void UnloadLayers(void);
+void InvalidateLayer(StaticLayer layer);
+void UpdateLayers(const RenderSnapshot *snapshot);
+void DrawLayer(StaticLayer layer);
+
+#endif
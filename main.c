@@ -1,405 +1,1073 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include "raylib.h"
-#include "raymath.h"
-
-#define SCREEN_WIDTH 800
-#define SCREEN_HEIGHT 800
-#define PLAYER_SPEED 200
-#define PLAYER_MAX_LIVES 3
-#define PLAYER_MAX_SCORE 9999
-#define PROJECTILE_SPEED 600
-#define PROJECTILE_OFFSET_FROM_PLAYER 10
-#define PROJECTILE_EXPLOSION_DURATION 0.5 // seconds
-#define ENEMIES_COLS 11
-#define ENEMIES_ROWS 5
-#define MAX_NUM_OF_ENEMIES ENEMIES_ROWS * ENEMIES_COLS
-#define ENEMY_VERTICAL_MAX_DISTANCE 50
-#define ENEMY_DYING_DURATION 0.5
-
-typedef enum EntityStateValue {
-    PLAYER_STATE_IDLE,
-    PLAYER_STATE_MOVING,
-    PLAYER_STATE_FIRING,
-    PROJECTILE_STATE_ACTIVE,
-    PROJECTILE_STATE_EXPLODING,
-    PROJECTILE_STATE_INACTIVE,
-    ENEMY_STATE_ACTIVE,
-    ENEMY_STATE_DYING,
-    ENEMY_STATE_DEAD,
-} EntityStateValue;
-
-typedef enum MoveDirValue {
-    MOVE_NOTSET,
-    MOVE_RIGHT,
-    MOVE_DOWN,
-    MOVE_LEFT,
-} MoveDirValue;
-
-typedef struct EntityState {
-    EntityStateValue value;
-    double startTime;
-    double elapsedTime;
-} EntityState;
-
-typedef struct Projectile {
-    Rectangle body;
-    EntityState state;
-} Projectile;
-
-typedef struct Player {
-    Rectangle body;
-    Projectile projectile;
-    EntityState state;
-    int lives;
-    int score;
-} Player;
-
-typedef struct Enemy {
-    Rectangle body;
-    Vector2 position;
-    Vector2 velocity;
-    Vector2 acceleration;
-    EntityState state;
-    MoveDirValue dir;
-    MoveDirValue previousDir;
-    Vector2 moveStartPosition;
-    float distanceTraveled;
-} Enemy;
-
-typedef struct EnemyFlock {
-    Enemy entities[MAX_NUM_OF_ENEMIES];
-    Rectangle boundaries;
-    MoveDirValue moveDirection;
-} EnemyFlock;
-
-typedef struct Game {
-    Player player;
-    EnemyFlock enemyFlock;
-    Rectangle boundaries;
-    Rectangle playerUIRect;
-} Game;
-
-float maxForce = 0.01;
-float maxHSpeed = 100;
-float maxVSpeed = 100;
-float enemyDistance = 10;
-float flockAwarenessDistance = 200;
-
-void InitGame(Game *game);
-void UpdateGame(Game *game);
-void RenderGame(Game *game);
-void SetEntityState(EntityState *state, int value);
-void UpdateEntityState(EntityState *state);
-void UpdateEnemyDistanceTraveled(Enemy *enemy);
-void UpdateEnemyFlock(Game *game, EnemyFlock *flock);
-void RenderEnemyFlock(Game *game, EnemyFlock *flock);
-void InitFlock(Game *game, Vector2 startPosition);
-
-int main() {
+#include "assets.h"
+#include "eventlog.h"
+#include "flightrecorder.h"
+#include "flockshader.h"
+#include "game.h"
+#include "hud.h"
+#include "input.h"
+#include "layers.h"
+#include "net.h"
+#include "pacing.h"
+#include "particles.h"
+#include "profiler.h"
+#include "replay.h"
+#include "rewind.h"
+#include "simulation.h"
+#include "softrender.h"
+#include "spectator.h"
+#include "starfield.h"
+
+#define TARGET_FPS 144
+#define LATE_LATCH_MAX_HORIZON 0.1 // seconds
+#define ATTRACT_IDLE_TIME 60 // seconds without input before the game falls back to attract
+#define ASSET_BUNDLE_PATH "bin/assets.bundle"
+#define ASSET_MANIFEST_PATH "assets/manifest.txt"
+#define ASSET_UPLOADS_PER_FRAME 4 // texture uploads per frame while the loader is still running
+
+// Render-thread side of input; edges are derived here so extra polls mid-frame never drop a press
+typedef struct InputSampler {
+    InputMailbox *mailbox;
+    GameInput input;
+    unsigned int down;
+    unsigned int systemDown;
+    bool lateLatch;
+    bool viewOnly; // a spectator's: its keys must never move the game it shows, so late latch stays off
+    bool eventPending;
+    unsigned int eventSequence;
+    double eventTime;
+    double lastInputTime;
+} InputSampler;
+
+typedef enum SystemKey {
+    SYSTEM_PROFILER = 1 << 0,
+    SYSTEM_LATE_LATCH = 1 << 1,
+    SYSTEM_PAUSE = 1 << 2,
+    SYSTEM_FLOCK_SHADER = 1 << 3,
+} SystemKey;
+
+// Paused and attract both stop the simulation and only redraw when an input or window event arrives
+typedef enum RunState {
+    RUN_PLAYING,
+    RUN_PAUSED,
+    RUN_ATTRACT,
+} RunState;
+
+typedef struct RunControl {
+    RunState state;
+    double stateTime;
+} RunControl;
+
+int RunHeadless(Game *game, int frames, ReplayReader *replay, const char *golden, const char *writeGolden);
+void RunSingleThreaded(Game *game, InputThread *events, bool lateLatch);
+void RunPipelined(Game *game, InputThread *events, bool lateLatch);
+void RunNetworkClient(NetClient *client, InputThread *events, bool lateLatch);
+void RunSpectator(SpectatorViewer *viewer);
+int RunSpectatorHeadless(SpectatorViewer *viewer, int frames);
+void InitInputSampler(InputSampler *sampler, InputMailbox *mailbox, bool lateLatch);
+unsigned int HandleSystemKeys(InputSampler *sampler);
+bool StepRunState(RunControl *run, InputSampler *sampler, unsigned int systemPressed);
+void SampleInput(InputSampler *sampler);
+void NoteInputChange(InputSampler *sampler, unsigned int previous);
+int LatchPlayerInput(InputSampler *sampler);
+float ExtrapolatePlayerX(const RenderSnapshot *snapshot, int direction);
+void RecordInputLatency(InputSampler *sampler, const RenderSnapshot *snapshot);
+void RenderGame(const RenderSnapshot *snapshot, InputSampler *sampler, FramePacer *pacer, RunState state);
+void RenderRunState(RunState state);
+void RenderAssetProgress(Rectangle boundaries);
+void RenderEnemyFlock(const RenderSnapshot *snapshot);
+Color GetEnemyColor(int slot);
+GameInput GetScriptedInput(int frame);
+void RenderGameSoftware(const RenderSnapshot *snapshot, Image *canvas);
+
+static double launchTime;
+static bool firstFramePresented = false;
+static bool assetsResident = false;
+
+int main(int argc, char **argv) {
+    launchTime = GetMonotonicTime();
+
     Game game;
+    ThreadPool pool;
+    InputThread events;
+    bool singleThreaded = false;
+    bool lateLatch = true;
+    bool keyEvents = true;
+    bool flockShader = false;
+    int particleStress = 0;
+    int stars = STARFIELD_DEFAULT_STARS;
+    bool looseAssets = false;
+    const char *bundlePath = ASSET_BUNDLE_PATH;
+    int headlessFrames = 0;
+    const char *golden = NULL;
+    const char *writeGolden = NULL;
+    const char *recordPath = NULL;
+    const char *replayPath = NULL;
+    unsigned long long seekTick = 0;
+    int serverPort = 0;
+    const char *connectAddress = NULL;
+    int bots = 0;
+    const char *feedName = NULL;
+    const char *spectateName = NULL;
+    bool flightRecorder = true;
+    const char *crashDumpPath = NULL;
+    const char *eventLogPath = NULL;
+    ReplayWriter recorder;
+    ReplayReader replay;
+    RewindBuffer rewind;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--single-thread") == 0) {
+            singleThreaded = true;
+        } else if (strcmp(argv[i], "--no-late-latch") == 0) {
+            lateLatch = false;
+        } else if (strcmp(argv[i], "--poll-input") == 0) {
+            keyEvents = false;
+        } else if (strcmp(argv[i], "--flock-shader") == 0) {
+            flockShader = true;
+        } else if (strcmp(argv[i], "--particle-stress") == 0 && i + 1 < argc) {
+            particleStress = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--loose-assets") == 0) {
+            looseAssets = true;
+        } else if (strcmp(argv[i], "--bundle") == 0 && i + 1 < argc) {
+            bundlePath = argv[++i];
+        } else if (strcmp(argv[i], "--stars") == 0 && i + 1 < argc) {
+            stars = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--headless") == 0 && i + 1 < argc) {
+            headlessFrames = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--golden") == 0 && i + 1 < argc) {
+            golden = argv[++i];
+        } else if (strcmp(argv[i], "--write-golden") == 0 && i + 1 < argc) {
+            writeGolden = argv[++i];
+        } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            recordPath = argv[++i];
+        } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replayPath = argv[++i];
+        } else if (strcmp(argv[i], "--seek") == 0 && i + 1 < argc) {
+            seekTick = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--server") == 0 && i + 1 < argc) {
+            serverPort = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--connect") == 0 && i + 1 < argc) {
+            connectAddress = argv[++i];
+        } else if (strcmp(argv[i], "--bots") == 0 && i + 1 < argc) {
+            bots = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--spectator-feed") == 0) {
+            feedName = i + 1 < argc && argv[i + 1][0] == '/' ? argv[++i] : SPECTATOR_DEFAULT_NAME;
+        } else if (strcmp(argv[i], "--no-flight-recorder") == 0) {
+            flightRecorder = false;
+        } else if (strcmp(argv[i], "--crash-dump") == 0 && i + 1 < argc) {
+            crashDumpPath = argv[++i];
+        } else if (strcmp(argv[i], "--event-log") == 0 && i + 1 < argc) {
+            eventLogPath = argv[++i];
+        } else if (strcmp(argv[i], "--spectate") == 0) {
+            spectateName = i + 1 < argc && argv[i + 1][0] == '/' ? argv[++i] : SPECTATOR_DEFAULT_NAME;
+        }
+    }
 
     InitGame(&game);
-    SetTargetFPS(144);
+    InitThreadPool(&pool, GetDefaultWorkerCount());
+    game.pool = &pool;
+
+    static SpectatorFeed feed;
+    static SpectatorViewer viewer;
+    static FlightRecorder flight;
+    static EventLog eventLog;
+
+    if (feedName != NULL && StartSpectatorFeed(&feed, feedName)) {
+        game.spectators = &feed;
+    }
+
+    // Kept by a local game only: clients and viewers show someone else's, and a server's ticks also read
+    // network seats' buttons and joins, which the recorder does not capture, so its dump would not replay
+    if (flightRecorder && serverPort > 0) {
+        TraceLog(LOG_INFO, "FLIGHT: Not recording, a server's network seats cannot be replayed");
+    } else if (flightRecorder && connectAddress == NULL && spectateName == NULL && StartFlightRecorder(&flight, crashDumpPath)) {
+        game.flightRecorder = &flight;
+    }
+
+    if (eventLogPath != NULL && StartEventLog(&eventLog, eventLogPath)) {
+        game.events = &eventLog;
+    }
+
+    Color rowColors[ENEMIES_ROWS];
+    for (int i = 0; i < ENEMIES_ROWS; i++) {
+        rowColors[i] = GetEnemyColor(i * ENEMIES_COLS);
+    }
+
+    InitParticles(rowColors);
+    SetParticleStress(particleStress);
+    InitStarfield(stars, SCREEN_WIDTH, SCREEN_HEIGHT);
+
+    // A dedicated server and load-test bots never open a window; --headless bounds their ticks
+    if (serverPort > 0 || (connectAddress != NULL && bots > 0) || (spectateName != NULL && headlessFrames > 0)) {
+        int result = 1;
+
+        if (serverPort > 0) {
+            result = RunNetServer(&game, serverPort, headlessFrames);
+        } else if (spectateName != NULL) {
+            OpenSpectatorFeed(&viewer, spectateName);
+            result = RunSpectatorHeadless(&viewer, headlessFrames);
+            CloseSpectatorFeed(&viewer);
+        } else {
+            result = RunNetBots(connectAddress, bots, headlessFrames);
+        }
+
+        if (game.spectators != NULL) {
+            StopSpectatorFeed(game.spectators);
+        }
+
+        if (game.events != NULL) {
+            StopEventLog(game.events);
+        }
+
+        UnloadStarfield();
+        UnloadParticles();
+        UnloadThreadPool(&pool);
+        UnloadGame(&game);
+
+        return result;
+    }
+
+    // Replays only play back headless, where the input comes from one place
+    bool replayReady = headlessFrames > 0 && replayPath != NULL && OpenReplay(&replay, replayPath);
+
+    if (replayReady) {
+        double seekStart = GetMonotonicTime();
+        // Crash dumps start mid-game; playback starts at the first keyframe unless asked for a later tick
+        if (seekTick < replay.index[0].tick) {
+            seekTick = replay.index[0].tick;
+        }
+
+        replayReady = SeekReplay(&replay, &game, seekTick);
+        printf("seek to tick %llu %s in %.3f ms\n", seekTick, replayReady ? "done" : "failed", (GetMonotonicTime() - seekStart) * 1000);
+    }
+
+    if (recordPath != NULL && StartReplay(&recorder, recordPath, 0)) {
+        game.recorder = &recorder;
+    }
+
+    if (headlessFrames > 0) {
+        int result = 1;
+
+        if (replayPath == NULL || replayReady) {
+            result = RunHeadless(&game, headlessFrames, replayPath != NULL ? &replay : NULL, golden, writeGolden);
+        }
+
+        if (replayPath != NULL) {
+            CloseReplay(&replay);
+        }
+
+        if (game.recorder != NULL) {
+            FinishReplay(game.recorder);
+        }
 
+        if (game.spectators != NULL) {
+            StopSpectatorFeed(game.spectators);
+        }
+
+        if (game.flightRecorder != NULL) {
+            StopFlightRecorder(game.flightRecorder);
+        }
+
+        if (game.events != NULL) {
+            StopEventLog(game.events);
+        }
+
+        UnloadStarfield();
+        UnloadParticles();
+        UnloadThreadPool(&pool);
+        UnloadGame(&game);
+
+        return result;
+    }
+
+    // Decoding overlaps window and context creation; the packed bundle is the fast path and
+    // the loose files stay usable while assets are being edited
+    StartAssetLoader(looseAssets ? NULL : bundlePath, ASSET_MANIFEST_PATH);
     InitWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "Space Invaders");
 
-    while (!WindowShouldClose()) {
-        UpdateGame(&game);
-        RenderGame(&game);
+    InitLayers(SCREEN_WIDTH, SCREEN_HEIGHT);
+    InitHud(game.playerUIRect.width, game.playerUIRect.height);
+    InitParticleRenderer();
+    InitStarfieldRenderer();
+
+    if (InitFlockShader(rowColors) && flockShader) {
+        ToggleFlockShader();
     }
 
+    if (game.recorder == NULL && connectAddress == NULL && spectateName == NULL && InitRewind(&rewind, REWIND_BUDGET, REWIND_SECONDS)) {
+        game.rewind = &rewind;
+    }
+
+    keyEvents = keyEvents && StartInputThread(&events);
+
+    static NetClient client;
+
+    if (spectateName != NULL) {
+        OpenSpectatorFeed(&viewer, spectateName);
+        RunSpectator(&viewer);
+        CloseSpectatorFeed(&viewer);
+    } else if (connectAddress != NULL) {
+        if (StartNetClient(&client, connectAddress)) {
+            RunNetworkClient(&client, keyEvents ? &events : NULL, lateLatch);
+            StopNetClient(&client);
+        }
+    } else if (singleThreaded) {
+        RunSingleThreaded(&game, keyEvents ? &events : NULL, lateLatch);
+    } else {
+        RunPipelined(&game, keyEvents ? &events : NULL, lateLatch);
+    }
+
+    if (keyEvents) {
+        StopInputThread(&events);
+    }
+
+    if (game.recorder != NULL) {
+        FinishReplay(game.recorder);
+    }
+
+    if (game.rewind != NULL) {
+        UnloadRewind(game.rewind);
+    }
+
+    if (game.spectators != NULL) {
+        StopSpectatorFeed(game.spectators);
+    }
+
+    if (game.flightRecorder != NULL) {
+        StopFlightRecorder(game.flightRecorder);
+    }
+
+    if (game.events != NULL) {
+        StopEventLog(game.events);
+    }
+
+    UnloadFlockShader();
+    UnloadParticles();
+    UnloadStarfield();
+    UnloadHud();
+    UnloadLayers();
+    UnloadAssets();
     CloseWindow();
+    UnloadThreadPool(&pool);
+    UnloadGame(&game);
 
     return 0;
 }
 
-void InitGame(Game *game) {
-    int screenLeftMargin = 10;
-    int screenRightMargin = 10;
-    int screenTopMargin = 10;
-    int screenBottomMargin = 50;
-
-    game->boundaries.x = screenLeftMargin;
-    game->boundaries.y = screenTopMargin;
-    game->boundaries.width = SCREEN_WIDTH - screenLeftMargin - screenRightMargin;
-    game->boundaries.height = SCREEN_HEIGHT - screenTopMargin - screenBottomMargin;
-
-    game->player.body.width = 50;
-    game->player.body.height = 50;
-    game->player.body.x = game->boundaries.x;
-    game->player.body.y = game->boundaries.y + game->boundaries.height - game->player.body.height;
-    game->player.lives = PLAYER_MAX_LIVES;
-    game->player.score = 0;
-    game->player.state.value = PLAYER_STATE_IDLE;
-
-    game->player.projectile.state.value = PROJECTILE_STATE_INACTIVE;
-    game->player.projectile.body.width = 5;
-    game->player.projectile.body.height = 20;
-    game->player.projectile.body.x = game->player.body.x + game->player.body.width / 2 - game->player.projectile.body.width / 2;
-    game->player.projectile.body.y = game->player.body.y - game->player.projectile.body.height - PROJECTILE_OFFSET_FROM_PLAYER;
-
-    game->playerUIRect.width = SCREEN_WIDTH - screenLeftMargin - screenRightMargin;
-    game->playerUIRect.height = screenBottomMargin;
-    game->playerUIRect.x = screenLeftMargin;
-    game->playerUIRect.y = game->boundaries.y + game->boundaries.height;
-
-    Vector2 startPosition = {game->boundaries.x, game->boundaries.y};
-    InitFlock(game, startPosition);
-}
+// No window: one tick per frame from a fixed input script or a replay, drawn by the software rasterizer
+int RunHeadless(Game *game, int frames, ReplayReader *replay, const char *golden, const char *writeGolden) {
+    static RenderSnapshot snapshot;
+    Image canvas = LoadSoftCanvas(SCREEN_WIDTH, SCREEN_HEIGHT);
+    unsigned long long sequenceHash = 0;
+    unsigned long long stateHash = 0;
+    double updateTime = 0;
+    double renderTime = 0;
+    double particleTime = 0;
+    double starfieldTime = 0;
+    int result = 0;
+
+    for (int i = 0; i < frames; i++) {
+        GameInput input = GetScriptedInput(i);
+
+        // A recording that ends early ends the run there
+        if (replay != NULL && !NextReplayInput(replay, &input)) {
+            frames = i;
+            break;
+        }
 
-void UpdateGame(Game *game) {
-    Vector2 playerPosition = { game->player.body.x, game->player.body.y };
+        if (replay != NULL && !CheckReplayHash(replay, game)) {
+            result = 1;
+        }
 
-    if (IsKeyDown(KEY_LEFT)) {
-        playerPosition.x -= PLAYER_SPEED * GetFrameTime();
+        double updateStart = GetMonotonicTime();
+        UpdateGame(game, input);
+        updateTime += GetMonotonicTime() - updateStart;
+        BuildRenderSnapshot(game, &snapshot);
+
+        // Particles and stars are simulated for timing only; they are random, so they stay out of the hashed image
+        double particleStart = GetMonotonicTime();
+        UpdateParticles(&snapshot, TICK_TIME);
+        particleTime += GetMonotonicTime() - particleStart;
+
+        double starfieldStart = GetMonotonicTime();
+        UpdateStarfield(TICK_TIME);
+        starfieldTime += GetMonotonicTime() - starfieldStart;
+
+        double renderStart = GetMonotonicTime();
+        RenderGameSoftware(&snapshot, &canvas);
+        renderTime += GetMonotonicTime() - renderStart;
+
+        sequenceHash = sequenceHash * 31 + HashImage(canvas);
     }
 
-    if (IsKeyDown(KEY_RIGHT)) {
-        playerPosition.x += PLAYER_SPEED * GetFrameTime();
+    printf("frames %d render %.3f ms/frame (%.0f fps) last frame %016llx sequence %016llx\n", frames,
+        frames > 0 ? renderTime / frames * 1000 : 0, renderTime > 0 ? frames / renderTime : 0, HashImage(canvas), sequenceHash);
+    // The state hash covers the simulation alone, so it can be compared across builds whose rendering differs
+    for (int p = 0; p < HASH_PART_COUNT; p++) {
+        stateHash = stateHash * 31 + game->hash.parts[p];
     }
 
-    if (IsKeyPressed(KEY_ONE)) {
-        maxForce += 5;
+    printf("simulation update %.4f ms/frame state %016llx\n", frames > 0 ? updateTime / frames * 1000 : 0, stateHash);
+    printf("particle update %.3f ms/frame\n", frames > 0 ? particleTime / frames * 1000 : 0);
+    printf("starfield update %.3f ms/frame\n", frames > 0 ? starfieldTime / frames * 1000 : 0);
+
+    if (writeGolden != NULL && !ExportImage(canvas, writeGolden)) {
+        result = 1;
     }
 
-    if (IsKeyPressed(KEY_TWO)) {
-        maxForce -= 5;
-        if (maxForce < 1) {
-            maxForce = 1;
+    if (golden != NULL) {
+        Image expected = LoadImage(golden);
+        int mismatches = -1;
+
+        if (expected.data != NULL && expected.width == canvas.width && expected.height == canvas.height) {
+            ImageFormat(&expected, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+            mismatches = 0;
+
+            for (int i = 0; i < canvas.width * canvas.height; i++) {
+                if (memcmp((Color *)canvas.data + i, (Color *)expected.data + i, sizeof(Color)) != 0) {
+                    mismatches++;
+                }
+            }
+        }
+
+        if (mismatches != 0) {
+            printf("golden %s: %s\n", golden, mismatches < 0 ? "could not be loaded or has another size" : "mismatch");
+            printf("mismatched pixels %d\n", mismatches);
+            result = 1;
+        } else {
+            printf("golden %s: match\n", golden);
         }
-    }
 
-    if (IsKeyPressed(KEY_THREE)) {
-        maxVSpeed += 5;
+        UnloadImage(expected);
     }
 
-    if (IsKeyPressed(KEY_FOUR)) {
-        maxVSpeed -= 5;
-        if (maxVSpeed < 5) {
-            maxVSpeed = 5;
+    UnloadImage(canvas);
+
+    return result;
+}
+
+// Simulation and rendering share the main thread; ticks run from an accumulator each frame
+void RunSingleThreaded(Game *game, InputThread *events, bool lateLatch) {
+    static RenderSnapshot snapshot;
+    InputMailbox mailbox;
+    InputSampler sampler;
+    FramePacer pacer;
+    RunControl run = { RUN_PLAYING, GetMonotonicTime() };
+    double accumulator = 0;
+
+    InitInputMailbox(&mailbox);
+    InitInputSampler(&sampler, &mailbox, lateLatch);
+    InitFramePacer(&pacer, TARGET_FPS);
+
+    while (!WindowShouldClose()) {
+        unsigned int systemPressed = HandleSystemKeys(&sampler);
+        SampleInput(&sampler);
+
+        if (StepRunState(&run, &sampler, systemPressed) && run.state == RUN_PLAYING) {
+            DiscardInput(&mailbox, events);
+            ResetFramePacer(&pacer);
+            accumulator = 0;
         }
+
+        if (run.state != RUN_PLAYING) {
+            RenderGame(&snapshot, &sampler, &pacer, run.state);
+            continue;
+        }
+
+        accumulator += pacer.frameTime;
+        if (accumulator > 0.25) {
+            accumulator = 0.25;
+        }
+
+        double frameStart = GetMonotonicTime();
+
+        while (accumulator >= TICK_TIME) {
+            double tickStart = GetMonotonicTime();
+            GameInput input = TakeInput(&mailbox);
+
+            // Ticks run back to back here but stand for consecutive intervals ending at frameStart
+            if (events != NULL) {
+                double tickEnd = frameStart - accumulator + TICK_TIME;
+                DrainInputEvents(events, tickEnd - TICK_TIME, tickEnd, &input);
+            }
+
+            UpdateGame(game, input);
+            ProfilerRecord("sim tick", "%.3f ms", (GetMonotonicTime() - tickStart) * 1000);
+            accumulator -= TICK_TIME;
+        }
+
+        BuildRenderSnapshot(game, &snapshot);
+        snapshot.publishTime = GetMonotonicTime();
+        RenderGame(&snapshot, &sampler, &pacer, run.state);
+        WaitForNextFrame(&pacer);
     }
+}
+
+// The server runs the simulation; ticks here predict the own ship and send its input, and frames draw the
+// newest snapshot around it
+void RunNetworkClient(NetClient *client, InputThread *events, bool lateLatch) {
+    static RenderSnapshot snapshot;
+    InputMailbox mailbox;
+    InputSampler sampler;
+    FramePacer pacer;
+    double accumulator = 0;
+
+    InitInputMailbox(&mailbox);
+    InitInputSampler(&sampler, &mailbox, lateLatch);
+    InitFramePacer(&pacer, TARGET_FPS);
+
+    while (!WindowShouldClose()) {
+        HandleSystemKeys(&sampler);
+        SampleInput(&sampler);
+
+        accumulator += pacer.frameTime;
+        if (accumulator > 0.25) {
+            accumulator = 0.25;
+        }
+
+        // The server keeps ticking, so an unfocused client stays connected but holds nothing. Evdev reads
+        // the keyboard whichever window has focus, so its queued events are dropped rather than sent
+        bool focused = IsWindowFocused() && !IsWindowMinimized();
+        double frameStart = GetMonotonicTime();
+
+        while (accumulator >= TICK_TIME) {
+            if (!focused) {
+                DiscardInput(&mailbox, events);
+                UpdateNetClient(client, 0);
+                accumulator -= TICK_TIME;
+                continue;
+            }
+
+            GameInput input = TakeInput(&mailbox);
+
+            // Only held buttons go over the wire, as they stand once this tick's events are in, plus any
+            // pressed during it so a tap shorter than a tick still reaches the server
+            if (events != NULL) {
+                double tickEnd = frameStart - accumulator + TICK_TIME;
+                DrainInputEvents(events, tickEnd - TICK_TIME, tickEnd, &input);
+                input.buttons = (input.buttons & ~INPUT_HELD_MASK) | (events->down & INPUT_HELD_MASK);
+
+                for (int i = 0; i < input.eventCount; i++) {
+                    if (input.events[i].down) {
+                        input.buttons |= input.events[i].button;
+                    }
+                }
+            }
 
-    if (IsKeyPressed(KEY_FIVE)) {
-        maxHSpeed += 5;
+            UpdateNetClient(client, input.buttons);
+            accumulator -= TICK_TIME;
+        }
+
+        BuildNetRenderSnapshot(client, &snapshot);
+        RenderGame(&snapshot, &sampler, &pacer, RUN_PLAYING);
+        WaitForNextFrame(&pacer);
     }
+}
 
-    if (IsKeyPressed(KEY_SIX)) {
-        maxHSpeed -= 5;
-        if (maxHSpeed < 5) {
-            maxHSpeed = 5;
+// Draws another process's game straight out of its feed; torn frames are counted, not repaired, since
+// the ring gives a read SPECTATOR_SLOTS ticks before the writer can reach it again
+void RunSpectator(SpectatorViewer *viewer) {
+    InputMailbox mailbox;
+    InputSampler sampler;
+    FramePacer pacer;
+
+    InitInputMailbox(&mailbox);
+    InitInputSampler(&sampler, &mailbox, false);
+    sampler.viewOnly = true;
+    InitFramePacer(&pacer, TARGET_FPS);
+
+    while (!WindowShouldClose()) {
+        HandleSystemKeys(&sampler);
+        const RenderSnapshot *snapshot = BeginSpectatorRead(viewer);
+
+        if (snapshot == NULL) {
+            BeginDrawing();
+            ClearBackground(BLACK);
+            DrawText("WAITING FOR GAME", SCREEN_WIDTH / 2 - MeasureText("WAITING FOR GAME", 40) / 2, SCREEN_HEIGHT / 2 - 20, 40, YELLOW);
+            EndDrawing();
+            WaitTime(0.1);
+            continue;
         }
+
+        RenderGame(snapshot, &sampler, &pacer, RUN_PLAYING);
+        EndSpectatorRead(viewer);
+        ProfilerSetCounter("spectator torn", "%.0f", viewer->torn);
+        WaitForNextFrame(&pacer);
     }
+}
+
+// A viewer without a window: reads the feed at the display rate and draws it in software
+int RunSpectatorHeadless(SpectatorViewer *viewer, int frames) {
+    Image canvas = LoadSoftCanvas(SCREEN_WIDTH, SCREEN_HEIGHT);
+    double nextFrame = GetMonotonicTime();
+    double renderTime = 0;
+    double age = 0;
+
+    for (int i = 0; i < frames; i++) {
+        SleepUntil(nextFrame);
+        nextFrame += 1.0 / TARGET_FPS;
 
-    if (IsKeyPressed(KEY_SEVEN)) {
-        flockAwarenessDistance += 5;
+        double renderStart = GetMonotonicTime();
+        const RenderSnapshot *snapshot = BeginSpectatorRead(viewer);
+
+        if (snapshot == NULL) {
+            continue;
+        }
+
+        age += renderStart - snapshot->publishTime;
+        RenderGameSoftware(snapshot, &canvas);
+        EndSpectatorRead(viewer);
+        renderTime += GetMonotonicTime() - renderStart;
     }
 
-    if (IsKeyPressed(KEY_EIGHT)) {
-        flockAwarenessDistance -= 5;
-        if (flockAwarenessDistance < 5) {
-            flockAwarenessDistance = 5;
+    printf("spectator frames %llu torn %llu ticks skipped %llu render %.3f ms/frame snapshot age %.3f ms\n", viewer->reads,
+        viewer->torn, viewer->skipped, viewer->reads > 0 ? renderTime / viewer->reads * 1000 : 0, viewer->reads > 0 ? age / viewer->reads * 1000 : 0);
+    UnloadImage(canvas);
+
+    return viewer->reads > 0 && viewer->torn == 0 ? 0 : 1;
+}
+
+// Simulation runs on its own thread; this thread samples input and draws the newest snapshot
+void RunPipelined(Game *game, InputThread *events, bool lateLatch) {
+    SimulationThread simulation;
+    InputSampler sampler;
+    FramePacer pacer;
+    RunControl run = { RUN_PLAYING, GetMonotonicTime() };
+
+    StartSimulationThread(&simulation, game, events);
+    InitInputSampler(&sampler, &simulation.input, lateLatch);
+    InitFramePacer(&pacer, TARGET_FPS);
+
+    while (!WindowShouldClose()) {
+        unsigned int systemPressed = HandleSystemKeys(&sampler);
+        SampleInput(&sampler);
+
+        if (StepRunState(&run, &sampler, systemPressed)) {
+            SetSimulationPaused(&simulation, run.state != RUN_PLAYING);
+            ResetFramePacer(&pacer);
+        }
+
+        RenderGame(AcquireSnapshot(&simulation), &sampler, &pacer, run.state);
+
+        if (run.state == RUN_PLAYING) {
+            WaitForNextFrame(&pacer);
         }
     }
 
-    if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
-        InitFlock(game, GetMousePosition());
+    StopSimulationThread(&simulation);
+}
+
+void InitInputSampler(InputSampler *sampler, InputMailbox *mailbox, bool lateLatch) {
+    memset(sampler, 0, sizeof(InputSampler));
+    sampler->mailbox = mailbox;
+    sampler->lateLatch = lateLatch;
+    sampler->lastInputTime = GetMonotonicTime();
+}
+
+unsigned int HandleSystemKeys(InputSampler *sampler) {
+    unsigned int down = 0;
+
+    if (IsKeyDown(KEY_F3)) {
+        down |= SYSTEM_PROFILER;
     }
 
-    if (playerPosition.x != game->player.body.x || playerPosition.y != game->player.body.y) {
-        game->player.body.x = playerPosition.x;
-        game->player.body.y = playerPosition.y;
-        SetEntityState(&game->player.state, PLAYER_STATE_MOVING);
-    } else {
-        SetEntityState(&game->player.state, PLAYER_STATE_IDLE);
+    if (IsKeyDown(KEY_F4)) {
+        down |= SYSTEM_LATE_LATCH;
+    }
+
+    if (IsKeyDown(KEY_P)) {
+        down |= SYSTEM_PAUSE;
+    }
+
+    if (IsKeyDown(KEY_F5)) {
+        down |= SYSTEM_FLOCK_SHADER;
+    }
+
+    unsigned int pressed = down & ~sampler->systemDown;
+    sampler->systemDown = down;
+
+    if (pressed & SYSTEM_PROFILER) {
+        ToggleProfiler();
+    }
+
+    if ((pressed & SYSTEM_LATE_LATCH) && !sampler->viewOnly) {
+        sampler->lateLatch = !sampler->lateLatch;
+        TraceLog(LOG_INFO, "INPUT: Late latch %s", sampler->lateLatch ? "enabled" : "disabled");
+    }
+
+    if (pressed & SYSTEM_FLOCK_SHADER) {
+        ToggleFlockShader();
+    }
+
+    return pressed;
+}
+
+// Returns true when the state changed; idle states hand the frame rate over to raylib's event waiting
+bool StepRunState(RunControl *run, InputSampler *sampler, unsigned int systemPressed) {
+    double now = GetMonotonicTime();
+    RunState state = run->state;
+
+    if (!IsWindowFocused() || IsWindowMinimized()) {
+        state = RUN_ATTRACT;
+    } else if (systemPressed & SYSTEM_PAUSE) {
+        state = state == RUN_PLAYING ? RUN_PAUSED : RUN_PLAYING;
+    } else if (state == RUN_ATTRACT && sampler->lastInputTime > run->stateTime) {
+        state = RUN_PLAYING;
+    } else if (state == RUN_PLAYING && now - sampler->lastInputTime > ATTRACT_IDLE_TIME) {
+        state = RUN_ATTRACT;
+    }
+
+    if (state == run->state) {
+        return false;
+    }
+
+    if (state == RUN_PLAYING) {
+        DisableEventWaiting();
+    } else if (run->state == RUN_PLAYING) {
+        EnableEventWaiting();
+    }
+
+    TraceLog(LOG_INFO, "GAME: %s", state == RUN_PLAYING ? "Playing" : state == RUN_PAUSED ? "Paused" : "Attract");
+    run->state = state;
+    run->stateTime = now;
+    sampler->eventPending = false;
+
+    return true;
+}
+
+void SampleInput(InputSampler *sampler) {
+    GameInput *input = &sampler->input;
+    unsigned int previous = sampler->down;
+    unsigned int down = 0;
+
+    if (IsKeyDown(KEY_LEFT)) {
+        down |= INPUT_LEFT;
+    }
+
+    if (IsKeyDown(KEY_RIGHT)) {
+        down |= INPUT_RIGHT;
     }
 
     if (IsKeyDown(KEY_SPACE)) {
-        if (game->player.projectile.state.value == PROJECTILE_STATE_INACTIVE) {
-            SetEntityState(&game->player.projectile.state, PROJECTILE_STATE_ACTIVE);
-            game->player.projectile.body.x = game->player.body.x + game->player.body.width / 2 - game->player.projectile.body.width / 2;
-            game->player.projectile.body.y = game->player.body.y - game->player.projectile.body.height - PROJECTILE_OFFSET_FROM_PLAYER;
-        }
+        down |= INPUT_FIRE;
     }
 
-    if (game->player.body.x < game->boundaries.x) {
-        game->player.body.x = game->boundaries.x;
-    } else if (game->player.body.x + game->player.body.width >= game->boundaries.x + game->boundaries.width) {
-        game->player.body.x = game->boundaries.x + game->boundaries.width - game->player.body.width;
+    if (IsKeyDown(KEY_ONE)) {
+        down |= INPUT_FORCE_UP;
     }
 
-    UpdateEntityState(&game->player.state);
+    if (IsKeyDown(KEY_TWO)) {
+        down |= INPUT_FORCE_DOWN;
+    }
 
-    if (game->player.projectile.state.value != PROJECTILE_STATE_ACTIVE) {
-        UpdateEntityState(&game->player.projectile.state);
+    if (IsKeyDown(KEY_THREE)) {
+        down |= INPUT_VSPEED_UP;
     }
 
-    // Player projectile
-    if (game->player.projectile.state.value == PROJECTILE_STATE_ACTIVE) {
-        game->player.projectile.body.y -= PROJECTILE_SPEED * GetFrameTime();
+    if (IsKeyDown(KEY_FOUR)) {
+        down |= INPUT_VSPEED_DOWN;
+    }
 
-        // Out of bounds
-        if (game->player.projectile.body.y <= game->boundaries.y) {
-            game->player.projectile.body.y = game->boundaries.y;
-            SetEntityState(&game->player.projectile.state, PROJECTILE_STATE_INACTIVE);
-        }
-    } else if (game->player.projectile.state.value == PROJECTILE_STATE_EXPLODING) {
-        if (game->player.projectile.state.elapsedTime >= PROJECTILE_EXPLOSION_DURATION) {
-            SetEntityState(&game->player.projectile.state, PROJECTILE_STATE_INACTIVE);
-        }
+    if (IsKeyDown(KEY_FIVE)) {
+        down |= INPUT_HSPEED_UP;
+    }
+
+    if (IsKeyDown(KEY_SIX)) {
+        down |= INPUT_HSPEED_DOWN;
+    }
+
+    if (IsKeyDown(KEY_SEVEN)) {
+        down |= INPUT_AWARENESS_UP;
+    }
+
+    if (IsKeyDown(KEY_EIGHT)) {
+        down |= INPUT_AWARENESS_DOWN;
+    }
+
+    if (IsKeyDown(KEY_BACKSPACE)) {
+        down |= INPUT_REWIND;
+    }
+
+    if (IsMouseButtonDown(MOUSE_LEFT_BUTTON)) {
+        down |= INPUT_SPAWN_FLOCK;
     }
 
-    UpdateEnemyFlock(game, &game->enemyFlock);
+    if (down & ~previous & INPUT_SPAWN_FLOCK) {
+        input->spawnPosition = GetMousePosition();
+    }
+
+    // Movement and fire are held; everything else only acts on the frame it goes down
+    input->buttons = (down & INPUT_HELD_MASK) | (down & ~previous & ~INPUT_HELD_MASK);
+    sampler->down = down;
+    NoteInputChange(sampler, previous);
+    PostInput(sampler->mailbox, *input);
 }
 
-void RenderGame(Game *game) {
-    BeginDrawing();
-    ClearBackground(BLACK);
+void NoteInputChange(InputSampler *sampler, unsigned int previous) {
+    if (sampler->down == previous) {
+        return;
+    }
 
-    // Map
-    DrawRectangleLines(game->boundaries.x, game->boundaries.y, game->boundaries.width, game->boundaries.height, DARKBROWN);
+    sampler->input.sequence++;
+    sampler->lastInputTime = GetMonotonicTime();
 
-    // Player
-    DrawRectangle(game->player.body.x, game->player.body.y, game->player.body.width, game->player.body.height, RED);
+    // Latency is measured from the first horizontal change that has not been presented yet
+    if (((sampler->down ^ previous) & (INPUT_LEFT | INPUT_RIGHT)) && !sampler->eventPending) {
+        sampler->eventPending = true;
+        sampler->eventSequence = sampler->input.sequence;
+        sampler->eventTime = GetMonotonicTime();
+    }
+}
+
+// Polls the keyboard again right before the ship is drawn and forwards the fresh held state
+int LatchPlayerInput(InputSampler *sampler) {
+    unsigned int previous = sampler->down;
+
+    PollInputEvents();
+    sampler->down &= ~(INPUT_LEFT | INPUT_RIGHT);
+
+    if (IsKeyDown(KEY_LEFT)) {
+        sampler->down |= INPUT_LEFT;
+    }
+
+    if (IsKeyDown(KEY_RIGHT)) {
+        sampler->down |= INPUT_RIGHT;
+    }
+
+    NoteInputChange(sampler, previous);
+
+    // Edges for this frame were already posted by SampleInput, so only held buttons go out again
+    sampler->input.buttons = (sampler->input.buttons & ~(INPUT_LEFT | INPUT_RIGHT)) | (sampler->down & (INPUT_LEFT | INPUT_RIGHT));
+    GameInput held = sampler->input;
+    held.buttons &= INPUT_HELD_MASK;
+    PostInput(sampler->mailbox, held);
+
+    return ((sampler->down & INPUT_RIGHT) ? 1 : 0) - ((sampler->down & INPUT_LEFT) ? 1 : 0);
+}
+
+// Predicts where the simulation will have moved the local ship by the time this frame is shown
+float ExtrapolatePlayerX(const RenderSnapshot *snapshot, int direction) {
+    Rectangle body = snapshot->players[snapshot->localPlayer];
+    double horizon = GetMonotonicTime() - snapshot->publishTime;
+
+    if (horizon > LATE_LATCH_MAX_HORIZON) {
+        horizon = LATE_LATCH_MAX_HORIZON;
+    }
+
+    float x = body.x + direction * PLAYER_SPEED * horizon;
+
+    if (x < snapshot->boundaries.x) {
+        x = snapshot->boundaries.x;
+    } else if (x + body.width >= snapshot->boundaries.x + snapshot->boundaries.width) {
+        x = snapshot->boundaries.x + snapshot->boundaries.width - body.width;
+    }
+
+    return x;
+}
+
+// A latched frame shows the change itself; otherwise wait for a snapshot that has consumed it
+void RecordInputLatency(InputSampler *sampler, const RenderSnapshot *snapshot) {
+    if (!sampler->eventPending) {
+        return;
+    }
+
+    if (sampler->lateLatch) {
+        ProfilerRecord("input to present latched", "%.2f ms", (GetMonotonicTime() - sampler->eventTime) * 1000);
+    } else if ((int)(snapshot->inputSequence - sampler->eventSequence) >= 0) {
+        ProfilerRecord("input to present", "%.2f ms", (GetMonotonicTime() - sampler->eventTime) * 1000);
+    } else {
+        return;
+    }
+
+    sampler->eventPending = false;
+}
+
+void RenderGame(const RenderSnapshot *snapshot, InputSampler *sampler, FramePacer *pacer, RunState state) {
+    double renderStart = GetMonotonicTime();
+
+    // Texture updates go before BeginDrawing so they never split the frame's batch
+    UpdateLayers(snapshot);
+    UpdateHud(&snapshot->hud);
+    UpdateParticles(snapshot, state == RUN_PLAYING ? pacer->frameTime : 0);
+    UpdateStarfield(state == RUN_PLAYING ? pacer->frameTime : 0);
+
+    if (!assetsResident && UploadAssets(ASSET_UPLOADS_PER_FRAME)) {
+        assetsResident = true;
+        TraceLog(LOG_INFO, "GAME: Assets resident %.1f ms after launch", (GetMonotonicTime() - launchTime) * 1000);
+    }
+
+    ProfilerRecord("layer update", "%.3f ms", (GetMonotonicTime() - renderStart) * 1000);
+
+    BeginDrawing();
+
+    // Static layers with the scrolling stars between them; the opaque background replaces the clear
+    DrawLayer(LAYER_BACKGROUND);
+    DrawStarfield();
+    DrawLayer(LAYER_CHROME);
 
     // Enemies
-    RenderEnemyFlock(game, &game->enemyFlock);
+    RenderEnemyFlock(snapshot);
 
     // Projectiles
-    if (game->player.projectile.state.value == PROJECTILE_STATE_ACTIVE || game->player.projectile.state.value == PROJECTILE_STATE_EXPLODING) {
+    for (int i = 0; i < snapshot->projectileCount; i++) {
         DrawRectangle(
-            game->player.projectile.body.x,
-            game->player.projectile.body.y,
-            game->player.projectile.body.width,
-            game->player.projectile.body.height,
+            snapshot->projectiles[i].body.x,
+            snapshot->projectiles[i].body.y,
+            snapshot->projectiles[i].body.width,
+            snapshot->projectiles[i].body.height,
             YELLOW
         );
     }
 
+    // Explosions and debris
+    DrawParticles();
+
     // UI
-    char playerText[50 + PLAYER_MAX_LIVES + PLAYER_MAX_SCORE];
-    sprintf(playerText, "Lives %d Score %d Max force %0.1f Speed H%0.1f V%0.1f Flock awareness distance %0.1f", game->player.lives, game->player.score, maxForce, maxHSpeed, maxVSpeed, flockAwarenessDistance);
-    DrawText(playerText, game->playerUIRect.x, game->playerUIRect.y + 10, 20, YELLOW);
+    DrawHud(snapshot->playerUIRect.x, snapshot->playerUIRect.y);
+    DrawProfiler(snapshot->boundaries.x + 5, snapshot->boundaries.y + 5);
 
+    // Player, drawn last so the late latch samples input as close to the swap as possible
+    for (int i = 0; i < snapshot->playerCount; i++) {
+        Rectangle body = snapshot->players[i];
+
+        if (i == snapshot->localPlayer && sampler->lateLatch && state == RUN_PLAYING) {
+            body.x = ExtrapolatePlayerX(snapshot, LatchPlayerInput(sampler));
+        }
+
+        DrawRectangle(body.x, body.y, body.width, body.height, RED);
+    }
+
+    RenderRunState(state);
+    RenderAssetProgress(snapshot->boundaries);
+
+    // Age of the simulated state at the moment it is submitted, i.e. the latency the pipeline adds
+    ProfilerRecord("snapshot age", "%.3f ms", (GetMonotonicTime() - snapshot->publishTime) * 1000);
+    ProfilerRecord("render", "%.3f ms", (GetMonotonicTime() - renderStart) * 1000);
+
+    BeginFramePresent(pacer);
     EndDrawing();
-}
 
-void SetEntityState(EntityState *state, int value) {
-    if (state->value != value) {
-        state->value = value;
-        state->startTime = GetTime();
+    if (!firstFramePresented) {
+        firstFramePresented = true;
+        TraceLog(LOG_INFO, "GAME: First frame presented %.1f ms after launch", (GetMonotonicTime() - launchTime) * 1000);
+    }
+
+    if (state == RUN_PLAYING) {
+        RecordInputLatency(sampler, snapshot);
     }
 }
 
-void UpdateEntityState(EntityState *state) {
-    state->elapsedTime = GetTime() - state->startTime;
+void RenderRunState(RunState state) {
+    const char *text = NULL;
+
+    if (state == RUN_PAUSED) {
+        text = "PAUSED";
+    } else if (state == RUN_ATTRACT) {
+        text = "PRESS ANY KEY";
+    } else {
+        return;
+    }
+
+    int width = MeasureText(text, 40);
+    DrawText(text, SCREEN_WIDTH / 2 - width / 2, SCREEN_HEIGHT / 2 - 20, 40, YELLOW);
 }
 
-void UpdateEnemyDistanceTraveled(Enemy *enemy) {
-    enemy->distanceTraveled = Vector2Distance(enemy->moveStartPosition, enemy->position);
+// The game draws without its assets, so the first frames show while they are still arriving.
+// Drawn in the playfield's top right corner: the HUD fills the band below it and the profiler the top left
+void RenderAssetProgress(Rectangle boundaries) {
+    int resident = 0;
+    int total = 0;
+
+    if (assetsResident) {
+        return;
+    }
+
+    GetAssetProgress(&resident, &total);
+    const char *text = TextFormat("LOADING %d/%d", resident, total);
+    DrawText(text, boundaries.x + boundaries.width - MeasureText(text, 20) - 5, boundaries.y + 5, 20, GRAY);
 }
 
-void UpdateEnemyFlock(Game *game, EnemyFlock *enemyFlock) {
-    for (int i = 0; i < MAX_NUM_OF_ENEMIES; i++) {
-        Enemy *entity = &enemyFlock->entities[i];
-        UpdateEntityState(&entity->state);
+void RenderEnemyFlock(const RenderSnapshot *snapshot) {
+    double start = GetMonotonicTime();
 
-        if (entity->state.value == ENEMY_STATE_ACTIVE) {
-            entity->distanceTraveled = Vector2Distance(entity->moveStartPosition, entity->position);
+    if (DrawFlockShader(snapshot)) {
+        ProfilerSetCounter("flock draw calls", "%.0f", snapshot->enemyCount > 0 ? 1 : 0);
+        ProfilerRecord("flock draw", "%.3f ms", (GetMonotonicTime() - start) * 1000);
+        return;
+    }
 
-            if (entity->dir == MOVE_RIGHT) {
-                entity->position.x += maxHSpeed * GetFrameTime();
+    for (int i = snapshot->enemyCount - 1; i >= 0; i--) {
+        const EnemySnapshot *enemy = &snapshot->enemies[i];
 
-                if (entity->body.x + entity->body.width >= game->boundaries.x + game->boundaries.width - 10) {
-                    entity->previousDir = entity->dir;
-                    entity->dir = MOVE_DOWN;
-                    entity->moveStartPosition.x = entity->position.x;
-                    entity->moveStartPosition.y = entity->position.y;
-                }
-            } else if (entity->dir == MOVE_LEFT) {
-                entity->position.x -= maxHSpeed * GetFrameTime();
-
-                if (entity->body.x <= game->boundaries.x + 10) {
-                    entity->previousDir = entity->dir;
-                    entity->dir = MOVE_DOWN;
-                    entity->moveStartPosition.x = entity->position.x;
-                    entity->moveStartPosition.y = entity->position.y;
-                }
-            } else if (entity->dir == MOVE_DOWN) {
-                entity->position.y += maxVSpeed * GetFrameTime();
-
-                if (entity->distanceTraveled >= entity->body.height + enemyDistance) {
-                    if (entity->previousDir == MOVE_LEFT) {
-                        entity->dir = MOVE_RIGHT;
-                    } else if (entity->previousDir == MOVE_RIGHT) {
-                        entity->dir = MOVE_LEFT;
-                    }
-                }
-            }
+        DrawRectangle(
+            enemy->body.x,
+            enemy->body.y,
+            enemy->body.width,
+            enemy->body.height,
+            GetEnemyColor(enemy->slot)
+        );
 
-            entity->body.x = entity->position.x - entity->body.width / 2;
-            entity->body.y = entity->position.y - entity->body.height / 2;
+        DrawCircleV(enemy->position, FLOCK_MARKER_RADIUS, YELLOW);
+    }
 
-            if (game->player.projectile.state.value == PROJECTILE_STATE_ACTIVE) {
-                if (CheckCollisionRecs(game->player.projectile.body, entity->body)) {
-                    SetEntityState(&entity->state, ENEMY_STATE_DYING);
-                    SetEntityState(&game->player.projectile.state, PROJECTILE_STATE_EXPLODING);
-                    game->player.score += 10;
-                }
-            }
-        } else if (entity->state.value == ENEMY_STATE_DYING) {
-            if (entity->state.elapsedTime >= ENEMY_DYING_DURATION) {
-                SetEntityState(&entity->state, ENEMY_STATE_DEAD);
-            }
-        }
+    ProfilerSetCounter("flock draw calls", "%.0f", snapshot->enemyCount * 2);
+    ProfilerRecord("flock draw", "%.3f ms", (GetMonotonicTime() - start) * 1000);
+}
+
+Color GetEnemyColor(int slot) {
+    int row = slot / ENEMIES_COLS;
 
-        entity->acceleration.x = 0;
-        entity->acceleration.y = 0;
+    if (row == 1) {
+        return GREEN;
+    } else if (row > 1 && row < 3) {
+        return YELLOW;
     }
+
+    return RED;
 }
 
-void RenderEnemyFlock(Game *game, EnemyFlock *enemyFlock) {
-    for (int i = MAX_NUM_OF_ENEMIES - 1; i >= 0; i--) {
-        Enemy *entity = &enemyFlock->entities[i];
-        if (entity->state.value != ENEMY_STATE_DEAD) {
-            Color color = RED;
+// Sweeps right then left while firing, so a run covers movement, shots and kills
+GameInput GetScriptedInput(int frame) {
+    GameInput input = { 0 };
+    input.buttons = INPUT_FIRE | ((frame / 400) % 2 == 0 ? INPUT_RIGHT : INPUT_LEFT);
+    input.sequence = frame;
 
-            if (i / ENEMIES_COLS == 1) {
-                color = GREEN;
-            } else if (i / ENEMIES_COLS > 1 && i / ENEMIES_COLS < 3) {
-                color = YELLOW;
-            }
+    return input;
+}
 
-            DrawRectangle(
-                entity->body.x,
-                entity->body.y,
-                entity->body.width,
-                entity->body.height,
-                color
-            );
+// Same scene as RenderGame, minus the profiler, particles, stars and late latch, so the output depends only on the snapshot
+void RenderGameSoftware(const RenderSnapshot *snapshot, Image *canvas) {
+    SoftClear(canvas, BLACK);
 
-            DrawCircleV(entity->position, 5, YELLOW);
+    // Map
+    SoftRectLines(canvas, snapshot->boundaries.x, snapshot->boundaries.y, snapshot->boundaries.width, snapshot->boundaries.height, DARKBROWN);
 
-            // DrawLineV(entity->moveStartPosition, entity->position, WHITE);
-        }
+    // Enemies
+    for (int i = snapshot->enemyCount - 1; i >= 0; i--) {
+        const EnemySnapshot *enemy = &snapshot->enemies[i];
+        SoftFillRect(canvas, enemy->body.x, enemy->body.y, enemy->body.width, enemy->body.height, GetEnemyColor(enemy->slot));
+        SoftFillCircle(canvas, enemy->position, FLOCK_MARKER_RADIUS, YELLOW);
     }
 
-    // DrawRectangleLines(enemyFlock->boundaries.x, enemyFlock->boundaries.y, enemyFlock->boundaries.width, enemyFlock->boundaries.height, YELLOW);
-}
+    // Projectiles
+    for (int i = 0; i < snapshot->projectileCount; i++) {
+        Rectangle body = snapshot->projectiles[i].body;
+        SoftFillRect(canvas, body.x, body.y, body.width, body.height, YELLOW);
+    }
+
+    // UI
+    const HudState *hud = &snapshot->hud;
+    char playerText[128];
+    snprintf(playerText, sizeof(playerText), "Lives %d Score %d Max force %0.1f Speed H%0.1f V%0.1f Flock awareness distance %0.1f", hud->lives, hud->score, hud->tuning.maxForce, hud->tuning.maxHSpeed, hud->tuning.maxVSpeed, hud->tuning.flockAwarenessDistance);
+    SoftDrawText(canvas, playerText, snapshot->playerUIRect.x, snapshot->playerUIRect.y + HUD_TEXT_OFFSET, HUD_FONT_SIZE, YELLOW);
 
-void InitFlock(Game *game, Vector2 startPosition) {
-    float flockWidth = game->enemyFlock.entities[0].body.width / 2 + game->enemyFlock.entities[0].body.width * ENEMIES_COLS + enemyDistance * ENEMIES_COLS;
-    // float flockHeight = game->enemyFlock.entities[0].body.width / 2 + game->enemyFlock.entities[0].body.width * ENEMIES_ROWS + enemyDistance * ENEMIES_ROWS;
-
-    for (int i = 0; i < MAX_NUM_OF_ENEMIES; i++) {
-        Enemy *entity = &game->enemyFlock.entities[i];
-        entity->body.width = 50;
-        entity->body.height = 50;
-        entity->position.x = startPosition.x + (flockWidth  / 2) + enemyDistance + entity->body.width / 2 + entity->body.width * (i % ENEMIES_COLS) + enemyDistance * (i % ENEMIES_COLS);
-        entity->position.y = startPosition.y + enemyDistance + entity->body.height / 2 + entity->body.height  * (i / ENEMIES_COLS) + enemyDistance * (i / ENEMIES_COLS);
-        entity->body.x = startPosition.x - entity->body.width / 2;
-        entity->body.y = startPosition.y - entity->body.height / 2;
-        entity->state.value = ENEMY_STATE_ACTIVE;
-        entity->dir = MOVE_RIGHT;
-    }
-}
\ No newline at end of file
+    // Player
+    for (int i = 0; i < snapshot->playerCount; i++) {
+        Rectangle body = snapshot->players[i];
+        SoftFillRect(canvas, body.x, body.y, body.width, body.height, RED);
+    }
+}
@@ -0,0 +1,1006 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <netdb.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "raylib.h"
+#include "net.h"
+#include "pacing.h"
+#include "profiler.h"
+
+#define NET_SOCKET_BUFFER (1024 * 1024)
+#define NET_PAYLOAD_CACHE 4 // encoded payloads shared by clients acking the same baseline
+#define NET_REPORT_INTERVAL 5.0 // seconds between server status lines
+
+_Static_assert(MAX_PLAYERS <= 64 && MAX_NUM_OF_ENEMIES <= 64, "seat and flock masks are 64 bits");
+
+// Bits go in least significant first through a 64 bit accumulator
+typedef struct BitWriter {
+    unsigned char *data;
+    size_t capacity;
+    size_t size;
+    unsigned long long pending;
+    int pendingBits;
+    bool overflow;
+} BitWriter;
+
+typedef struct BitReader {
+    const unsigned char *data;
+    size_t size;
+    size_t position;
+    unsigned long long pending;
+    int pendingBits;
+    bool failed;
+} BitReader;
+
+typedef struct EncodedPayload {
+    unsigned int baselineTick;
+    unsigned char data[NET_MAX_PACKET];
+    size_t size;
+} EncodedPayload;
+
+static const NetPlayer emptyPlayer = { .shot = NET_SHOT_NONE };
+static const NetSnapshot emptySnapshot = { 0 };
+
+static void WriteBits(BitWriter *writer, unsigned int value, int count) {
+    writer->pending |= (unsigned long long)(value & (unsigned int)((1ull << count) - 1)) << writer->pendingBits;
+    writer->pendingBits += count;
+
+    while (writer->pendingBits >= 8) {
+        if (writer->size < writer->capacity) {
+            writer->data[writer->size++] = writer->pending & 0xFF;
+        } else {
+            writer->overflow = true;
+        }
+
+        writer->pending >>= 8;
+        writer->pendingBits -= 8;
+    }
+}
+
+static void FlushBits(BitWriter *writer) {
+    if (writer->pendingBits > 0) {
+        WriteBits(writer, 0, 8 - writer->pendingBits);
+    }
+}
+
+static unsigned int ReadBits(BitReader *reader, int count) {
+    while (reader->pendingBits < count) {
+        if (reader->position >= reader->size) {
+            reader->failed = true;
+            return 0;
+        }
+
+        reader->pending |= (unsigned long long)reader->data[reader->position++] << reader->pendingBits;
+        reader->pendingBits += 8;
+    }
+
+    unsigned int value = reader->pending & ((1ull << count) - 1);
+    reader->pending >>= count;
+    reader->pendingBits -= count;
+
+    return value;
+}
+
+static unsigned int ZigZag(int value) {
+    return ((unsigned int)value << 1) ^ (unsigned int)(value >> 31);
+}
+
+static int UnZigZag(unsigned int value) {
+    return (int)(value >> 1) ^ -(int)(value & 1);
+}
+
+static void WriteField(BitWriter *writer, unsigned int value, unsigned int base, int bits) {
+    WriteBits(writer, value != base, 1);
+
+    if (value != base) {
+        WriteBits(writer, value, bits);
+    }
+}
+
+static unsigned int ReadField(BitReader *reader, unsigned int base, int bits) {
+    return ReadBits(reader, 1) ? ReadBits(reader, bits) : base;
+}
+
+static void WriteMask(BitWriter *writer, unsigned long long mask, unsigned long long base) {
+    WriteBits(writer, mask != base, 1);
+
+    if (mask != base) {
+        WriteBits(writer, (unsigned int)mask, 32);
+        WriteBits(writer, (unsigned int)(mask >> 32), 32);
+    }
+}
+
+static unsigned long long ReadMask(BitReader *reader, unsigned long long base) {
+    if (!ReadBits(reader, 1)) {
+        return base;
+    }
+
+    unsigned long long low = ReadBits(reader, 32);
+
+    return low | (unsigned long long)ReadBits(reader, 32) << 32;
+}
+
+// 0: unchanged; 10: moved by the same delta as the previous coordinate of its stream; 11: explicit,
+// as a short zigzag delta or the full value. The flock moves in lockstep, so most enemies cost 1-2 bits
+static void WritePosition(BitWriter *writer, short value, short base, int *streamDelta) {
+    int delta = value - base;
+
+    if (delta == 0) {
+        WriteBits(writer, 0, 1);
+        return;
+    }
+
+    if (delta == *streamDelta) {
+        WriteBits(writer, 1, 2);
+        return;
+    }
+
+    WriteBits(writer, 3, 2);
+
+    if (ZigZag(delta) < 1u << NET_SMALL_DELTA_BITS) {
+        WriteBits(writer, 0, 1);
+        WriteBits(writer, ZigZag(delta), NET_SMALL_DELTA_BITS);
+    } else {
+        WriteBits(writer, 1, 1);
+        WriteBits(writer, (unsigned short)value, 16);
+    }
+
+    *streamDelta = delta;
+}
+
+static short ReadPosition(BitReader *reader, short base, int *streamDelta) {
+    if (!ReadBits(reader, 1)) {
+        return base;
+    }
+
+    if (!ReadBits(reader, 1)) {
+        return base + *streamDelta;
+    }
+
+    short value = ReadBits(reader, 1) ? (short)ReadBits(reader, 16) : base + UnZigZag(ReadBits(reader, NET_SMALL_DELTA_BITS));
+    *streamDelta = value - base;
+
+    return value;
+}
+
+// Streams whose deltas are predicted from their previous coordinate
+enum {
+    STREAM_PLAYER_X,
+    STREAM_PLAYER_Y,
+    STREAM_SHOT_X,
+    STREAM_SHOT_Y,
+    STREAM_ENEMY_X,
+    STREAM_ENEMY_Y,
+    STREAM_COUNT,
+};
+
+static void EncodeSnapshot(BitWriter *writer, const NetSnapshot *snapshot, const NetSnapshot *base) {
+    int streams[STREAM_COUNT] = { 0 };
+
+    WriteMask(writer, snapshot->seats, base->seats);
+
+    for (int seat = 0; seat < MAX_PLAYERS; seat++) {
+        if (!(snapshot->seats & (1ull << seat))) {
+            continue;
+        }
+
+        const NetPlayer *player = &snapshot->players[seat];
+        const NetPlayer *previous = (base->seats & (1ull << seat)) ? &base->players[seat] : &emptyPlayer;
+
+        WritePosition(writer, player->x, previous->x, &streams[STREAM_PLAYER_X]);
+        WritePosition(writer, player->y, previous->y, &streams[STREAM_PLAYER_Y]);
+        WriteField(writer, player->state, previous->state, 2);
+        WriteField(writer, player->lives, previous->lives, 2);
+        WriteField(writer, player->score, previous->score, 16);
+        WriteField(writer, player->shot, previous->shot, 2);
+
+        if (player->shot != NET_SHOT_NONE) {
+            bool had = previous->shot != NET_SHOT_NONE;
+            WritePosition(writer, player->shotX, had ? previous->shotX : 0, &streams[STREAM_SHOT_X]);
+            WritePosition(writer, player->shotY, had ? previous->shotY : 0, &streams[STREAM_SHOT_Y]);
+        }
+    }
+
+    WriteMask(writer, snapshot->alive, base->alive);
+    WriteMask(writer, snapshot->dying, base->dying);
+
+    for (int slot = 0; slot < MAX_NUM_OF_ENEMIES; slot++) {
+        if (!(snapshot->alive & (1ull << slot))) {
+            continue;
+        }
+
+        bool had = base->alive & (1ull << slot);
+        WritePosition(writer, snapshot->enemyX[slot], had ? base->enemyX[slot] : 0, &streams[STREAM_ENEMY_X]);
+        WritePosition(writer, snapshot->enemyY[slot], had ? base->enemyY[slot] : 0, &streams[STREAM_ENEMY_Y]);
+    }
+
+    bool tuned = memcmp(&snapshot->tuning, &base->tuning, sizeof(Tuning)) != 0;
+    WriteBits(writer, tuned, 1);
+
+    for (int w = 0; tuned && w < (int)(sizeof(Tuning) / sizeof(unsigned int)); w++) {
+        unsigned int word;
+        memcpy(&word, (const unsigned int *)&snapshot->tuning + w, sizeof(word));
+        WriteBits(writer, word, 32);
+    }
+
+    FlushBits(writer);
+}
+
+static bool DecodeSnapshot(BitReader *reader, NetSnapshot *snapshot, const NetSnapshot *base) {
+    int streams[STREAM_COUNT] = { 0 };
+
+    snapshot->seats = ReadMask(reader, base->seats);
+
+    for (int seat = 0; seat < MAX_PLAYERS; seat++) {
+        if (!(snapshot->seats & (1ull << seat))) {
+            continue;
+        }
+
+        NetPlayer *player = &snapshot->players[seat];
+        const NetPlayer *previous = (base->seats & (1ull << seat)) ? &base->players[seat] : &emptyPlayer;
+
+        player->x = ReadPosition(reader, previous->x, &streams[STREAM_PLAYER_X]);
+        player->y = ReadPosition(reader, previous->y, &streams[STREAM_PLAYER_Y]);
+        player->state = ReadField(reader, previous->state, 2);
+        player->lives = ReadField(reader, previous->lives, 2);
+        player->score = ReadField(reader, previous->score, 16);
+        player->shot = ReadField(reader, previous->shot, 2);
+
+        if (player->shot != NET_SHOT_NONE) {
+            bool had = previous->shot != NET_SHOT_NONE;
+            player->shotX = ReadPosition(reader, had ? previous->shotX : 0, &streams[STREAM_SHOT_X]);
+            player->shotY = ReadPosition(reader, had ? previous->shotY : 0, &streams[STREAM_SHOT_Y]);
+        }
+    }
+
+    snapshot->alive = ReadMask(reader, base->alive);
+    snapshot->dying = ReadMask(reader, base->dying);
+
+    if (snapshot->alive >> MAX_NUM_OF_ENEMIES) {
+        return false;
+    }
+
+    for (int slot = 0; slot < MAX_NUM_OF_ENEMIES; slot++) {
+        if (!(snapshot->alive & (1ull << slot))) {
+            continue;
+        }
+
+        bool had = base->alive & (1ull << slot);
+        snapshot->enemyX[slot] = ReadPosition(reader, had ? base->enemyX[slot] : 0, &streams[STREAM_ENEMY_X]);
+        snapshot->enemyY[slot] = ReadPosition(reader, had ? base->enemyY[slot] : 0, &streams[STREAM_ENEMY_Y]);
+    }
+
+    snapshot->tuning = base->tuning;
+
+    if (ReadBits(reader, 1)) {
+        for (int w = 0; w < (int)(sizeof(Tuning) / sizeof(unsigned int)); w++) {
+            unsigned int word = ReadBits(reader, 32);
+            memcpy((unsigned int *)&snapshot->tuning + w, &word, sizeof(word));
+        }
+    }
+
+    return !reader->failed;
+}
+
+static short QuantizePosition(Scalar value) {
+    return (short)lrintf(SCALAR_TO_FLOAT(value) * NET_POSITION_SCALE);
+}
+
+static float DequantizePosition(short value) {
+    return (float)value / NET_POSITION_SCALE;
+}
+
+static void CaptureNetSnapshot(const Game *game, NetSnapshot *snapshot) {
+    const Archetype *players = &game->world.archetypes[ARCHETYPE_PLAYER];
+    const Archetype *enemies = &game->world.archetypes[ARCHETYPE_ENEMY];
+    const ScalarRectangle *bodies = COLUMN(players, ScalarRectangle, COMPONENT_BODY);
+    const EntityState *states = COLUMN(players, EntityState, COMPONENT_STATE);
+    const Pilot *pilots = COLUMN(players, Pilot, COMPONENT_PILOT);
+
+    memset(snapshot, 0, sizeof(NetSnapshot));
+    snapshot->tick = game->tick;
+    snapshot->tuning = game->tuning;
+
+    for (int i = 0; i < players->count; i++) {
+        int seat = pilots[i].seat;
+
+        if (seat == PILOT_LOCAL) {
+            continue;
+        }
+
+        NetPlayer *player = &snapshot->players[seat];
+        const ScalarRectangle *shotBody = GetComponent(&game->world, pilots[i].projectile, COMPONENT_BODY);
+        const EntityState *shotState = GetComponent(&game->world, pilots[i].projectile, COMPONENT_STATE);
+
+        snapshot->seats |= 1ull << seat;
+        player->x = QuantizePosition(bodies[i].x);
+        player->y = QuantizePosition(bodies[i].y);
+        player->state = states[i].value;
+        player->lives = pilots[i].lives;
+        player->score = pilots[i].score;
+        player->shot = NET_SHOT_NONE;
+
+        if (shotBody != NULL) {
+            player->shot = shotState->value - PROJECTILE_STATE_ACTIVE;
+            player->shotX = QuantizePosition(shotBody->x);
+            player->shotY = QuantizePosition(shotBody->y);
+        }
+    }
+
+    const ScalarVector2 *positions = COLUMN(enemies, ScalarVector2, COMPONENT_POSITION);
+    const EntityState *enemyStates = COLUMN(enemies, EntityState, COMPONENT_STATE);
+    const int *slots = COLUMN(enemies, int, COMPONENT_SLOT);
+
+    for (int i = 0; i < enemies->count; i++) {
+        int slot = slots[i];
+
+        snapshot->alive |= 1ull << slot;
+        snapshot->dying |= enemyStates[i].value == ENEMY_STATE_DYING ? 1ull << slot : 0;
+        snapshot->enemyX[slot] = QuantizePosition(positions[i].x);
+        snapshot->enemyY[slot] = QuantizePosition(positions[i].y);
+    }
+}
+
+static int OpenSocket(int port) {
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    int buffer = NET_SOCKET_BUFFER;
+    struct sockaddr_in address = { .sin_family = AF_INET, .sin_port = htons(port), .sin_addr.s_addr = htonl(INADDR_ANY) };
+
+    if (fd < 0) {
+        return -1;
+    }
+
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &buffer, sizeof(buffer));
+    setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &buffer, sizeof(buffer));
+
+    if (fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) != 0 || bind(fd, (struct sockaddr *)&address, sizeof(address)) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+// host or host:port
+static bool ResolveAddress(const char *text, struct sockaddr_in *address) {
+    char host[256];
+    char port[16];
+    const char *colon = strrchr(text, ':');
+    struct addrinfo hints = { .ai_family = AF_INET, .ai_socktype = SOCK_DGRAM };
+    struct addrinfo *result = NULL;
+
+    snprintf(host, sizeof(host), "%.*s", colon != NULL ? (int)(colon - text) : (int)strlen(text), text);
+    snprintf(port, sizeof(port), "%s", colon != NULL ? colon + 1 : TextFormat("%d", NET_DEFAULT_PORT));
+
+    if (getaddrinfo(host, port, &hints, &result) != 0 || result == NULL) {
+        return false;
+    }
+
+    memcpy(address, result->ai_addr, sizeof(struct sockaddr_in));
+    freeaddrinfo(result);
+
+    return true;
+}
+
+static bool SendPacket(int socket, const struct sockaddr_in *address, const void *data, size_t size) {
+    return sendto(socket, data, size, 0, (const struct sockaddr *)address, sizeof(struct sockaddr_in)) == (ssize_t)size;
+}
+
+static bool SameAddress(const struct sockaddr_in *a, const struct sockaddr_in *b) {
+    return a->sin_addr.s_addr == b->sin_addr.s_addr && a->sin_port == b->sin_port;
+}
+
+bool StartNetServer(NetServer *server, Game *game, int port) {
+    memset(server, 0, sizeof(NetServer));
+    server->game = game;
+    server->socket = OpenSocket(port);
+
+    if (server->socket < 0) {
+        TraceLog(LOG_WARNING, "NET: Failed to listen on port %d", port);
+        return false;
+    }
+
+    TraceLog(LOG_INFO, "NET: Server listening on port %d", port);
+
+    return true;
+}
+
+void StopNetServer(NetServer *server) {
+    if (server->socket >= 0) {
+        close(server->socket);
+    }
+
+    server->socket = -1;
+}
+
+static void SendWelcome(NetServer *server, int seat) {
+    unsigned char packet[1 + sizeof(NetWelcome)] = { NET_WELCOME };
+    NetWelcome welcome = { NET_PROTOCOL, seat, server->game->boundaries, server->game->playerUIRect };
+
+    memcpy(packet + 1, &welcome, sizeof(welcome));
+    SendPacket(server->socket, &server->clients[seat].address, packet, sizeof(packet));
+}
+
+static void ConnectClient(NetServer *server, const struct sockaddr_in *address) {
+    for (int seat = 0; seat < MAX_PLAYERS; seat++) {
+        NetServerClient *client = &server->clients[seat];
+
+        if (!client->connected) {
+            memset(client, 0, sizeof(NetServerClient));
+            client->address = *address;
+            client->connected = true;
+            client->player = AddPlayer(server->game, seat);
+            client->lastHeard = GetMonotonicTime();
+            server->clientCount++;
+            SendWelcome(server, seat);
+            TraceLog(LOG_INFO, "NET: Seat %d connected, %d clients", seat, server->clientCount);
+            return;
+        }
+    }
+}
+
+static void DisconnectClient(NetServer *server, int seat) {
+    NetServerClient *client = &server->clients[seat];
+
+    RemovePlayer(server->game, client->player);
+    server->game->seatButtons[seat] = 0;
+    client->connected = false;
+    server->clientCount--;
+    TraceLog(LOG_INFO, "NET: Seat %d disconnected, %d clients", seat, server->clientCount);
+}
+
+// [ack tick][newest sequence][count][buttons of newest, newest - 1, ...]
+static void ReceiveInput(NetServerClient *client, const unsigned char *data, size_t size) {
+    unsigned int ack;
+    unsigned int newest;
+
+    if (size < 9 || size < 9 + (size_t)data[8]) {
+        return;
+    }
+
+    memcpy(&ack, data, sizeof(ack));
+    memcpy(&newest, data + 4, sizeof(newest));
+
+    if (ack > client->ackTick) {
+        client->ackTick = ack;
+    }
+
+    for (int i = 0; i < data[8] && i < (int)newest; i++) {
+        unsigned int sequence = newest - i;
+
+        if (sequence > client->inputApplied && sequence + NET_INPUT_QUEUE > newest) {
+            client->inputs[sequence % NET_INPUT_QUEUE] = data[9 + i];
+            client->inputSequences[sequence % NET_INPUT_QUEUE] = sequence;
+        }
+    }
+
+    if (newest > client->inputNewest) {
+        client->inputNewest = newest;
+    }
+}
+
+static void ReceiveServerPackets(NetServer *server) {
+    unsigned char packet[NET_MAX_PACKET];
+    struct sockaddr_in address;
+    socklen_t addressSize = sizeof(address);
+    ssize_t size;
+
+    while ((size = recvfrom(server->socket, packet, sizeof(packet), 0, (struct sockaddr *)&address, &addressSize)) > 0) {
+        int seat = -1;
+        unsigned int protocol = 0;
+
+        server->bytesReceived += size;
+
+        for (int s = 0; s < MAX_PLAYERS && seat < 0; s++) {
+            if (server->clients[s].connected && SameAddress(&server->clients[s].address, &address)) {
+                seat = s;
+            }
+        }
+
+        if (packet[0] == NET_CONNECT && size >= 5) {
+            memcpy(&protocol, packet + 1, sizeof(protocol));
+
+            if (protocol != NET_PROTOCOL) {
+                continue;
+            }
+
+            // A lost welcome is answered again; the seat is kept
+            if (seat >= 0) {
+                SendWelcome(server, seat);
+            } else {
+                ConnectClient(server, &address);
+            }
+
+            continue;
+        }
+
+        if (seat < 0) {
+            continue;
+        }
+
+        server->clients[seat].lastHeard = GetMonotonicTime();
+
+        if (packet[0] == NET_INPUT) {
+            ReceiveInput(&server->clients[seat], packet + 1, size - 1);
+        } else if (packet[0] == NET_DISCONNECT) {
+            DisconnectClient(server, seat);
+        }
+
+        addressSize = sizeof(address);
+    }
+}
+
+// One input per tick keeps the server on the client's steps; an empty queue repeats the held buttons,
+// and a client running ahead is pulled back so its inputs do not wait in the queue as latency
+static void ApplyClientInput(NetServer *server, int seat) {
+    NetServerClient *client = &server->clients[seat];
+    unsigned int next = client->inputApplied + 1;
+
+    if (client->inputNewest - client->inputApplied > NET_INPUT_QUEUE / 2) {
+        next = client->inputNewest - NET_INPUT_QUEUE / 4;
+    }
+
+    if (client->inputNewest >= next) {
+        if (client->inputSequences[next % NET_INPUT_QUEUE] == next) {
+            client->buttons = client->inputs[next % NET_INPUT_QUEUE];
+        }
+
+        client->inputApplied = next;
+    }
+
+    server->game->seatButtons[seat] = client->buttons;
+}
+
+// Before each tick: take in packets, hand every seat its input and drop the silent
+void UpdateNetServer(NetServer *server) {
+    double now = GetMonotonicTime();
+
+    ReceiveServerPackets(server);
+
+    for (int seat = 0; seat < MAX_PLAYERS; seat++) {
+        if (!server->clients[seat].connected) {
+            continue;
+        }
+
+        if (now - server->clients[seat].lastHeard > NET_TIMEOUT) {
+            DisconnectClient(server, seat);
+        } else {
+            ApplyClientInput(server, seat);
+        }
+    }
+}
+
+// Captured once per tick; the payload depends only on the baseline, so clients acking the same one share it
+void SendNetSnapshots(NetServer *server) {
+    static EncodedPayload cache[NET_PAYLOAD_CACHE];
+    int cached = 0;
+    unsigned int tick = server->game->tick;
+    NetSnapshot *snapshot = &server->history[(tick / NET_SNAPSHOT_INTERVAL) % NET_BASELINES];
+
+    CaptureNetSnapshot(server->game, snapshot);
+
+    for (int seat = 0; seat < MAX_PLAYERS; seat++) {
+        NetServerClient *client = &server->clients[seat];
+        const NetSnapshot *base = &server->history[(client->ackTick / NET_SNAPSHOT_INTERVAL) % NET_BASELINES];
+        EncodedPayload scratch;
+        EncodedPayload *payload = NULL;
+
+        if (!client->connected) {
+            continue;
+        }
+
+        if (client->ackTick == 0 || base->tick != client->ackTick || tick - client->ackTick >= NET_SNAPSHOT_INTERVAL * NET_BASELINES) {
+            base = &emptySnapshot;
+        }
+
+        unsigned int baselineTick = base == &emptySnapshot ? 0 : client->ackTick;
+
+        for (int c = 0; c < cached && payload == NULL; c++) {
+            if (cache[c].baselineTick == baselineTick) {
+                payload = &cache[c];
+            }
+        }
+
+        if (payload == NULL) {
+            payload = cached < NET_PAYLOAD_CACHE ? &cache[cached++] : &scratch;
+
+            BitWriter writer = { payload->data, NET_MAX_PACKET - 1 - sizeof(NetSnapshotHeader), 0, 0, 0, false };
+            EncodeSnapshot(&writer, snapshot, base);
+            payload->baselineTick = baselineTick;
+            payload->size = writer.overflow ? 0 : writer.size;
+
+            if (writer.overflow) {
+                TraceLog(LOG_WARNING, "NET: Snapshot for tick %u does not fit a packet", tick);
+            }
+        }
+
+        if (payload->size == 0) {
+            continue;
+        }
+
+        unsigned char packet[NET_MAX_PACKET] = { NET_SNAPSHOT };
+        const ScalarRectangle *ship = GetComponent(&server->game->world, client->player, COMPONENT_BODY);
+        NetSnapshotHeader header = { tick, baselineTick, client->inputApplied, ship != NULL ? ship->x : 0 };
+        size_t size = 1 + sizeof(header) + payload->size;
+
+        memcpy(packet + 1, &header, sizeof(header));
+        memcpy(packet + 1 + sizeof(header), payload->data, payload->size);
+
+        if (SendPacket(server->socket, &client->address, packet, size)) {
+            server->bytesSent += size;
+            server->packetsSent++;
+        }
+    }
+}
+
+// Headless dedicated server; ticks 0 runs until killed
+int RunNetServer(Game *game, int port, int ticks) {
+    static NetServer server;
+    double nextTick = GetMonotonicTime();
+    double lastReport = nextTick;
+    double updateTime = 0;
+    double networkTime = 0;
+    double worstTick = 0;
+    double clientSeconds = 0;
+    int reportTicks = 0;
+    int peakClients = 0;
+
+    if (!StartNetServer(&server, game, port)) {
+        return 1;
+    }
+
+    // Nobody sits at a dedicated server
+    RemovePlayer(game, game->player);
+
+    for (int t = 0; ticks == 0 || t < ticks; t++) {
+        SleepUntil(nextTick);
+        nextTick += TICK_TIME;
+
+        if (GetMonotonicTime() - nextTick > 0.25) {
+            nextTick = GetMonotonicTime();
+        }
+
+        double start = GetMonotonicTime();
+        UpdateNetServer(&server);
+        double updateStart = GetMonotonicTime();
+        UpdateGame(game, (GameInput){ 0 });
+        double sendStart = GetMonotonicTime();
+
+        if (game->tick % NET_SNAPSHOT_INTERVAL == 0) {
+            SendNetSnapshots(&server);
+        }
+
+        double end = GetMonotonicTime();
+
+        updateTime += sendStart - updateStart;
+        networkTime += (updateStart - start) + (end - sendStart);
+        worstTick = end - start > worstTick ? end - start : worstTick;
+        clientSeconds += server.clientCount * TICK_TIME;
+        peakClients = server.clientCount > peakClients ? server.clientCount : peakClients;
+        reportTicks++;
+
+        if (end - lastReport >= NET_REPORT_INTERVAL) {
+            TraceLog(LOG_INFO, "NET: %d clients, tick %.3f ms (update %.3f, network %.3f), %.1f KB/s out per client",
+                server.clientCount, (updateTime + networkTime) / reportTicks * 1000, updateTime / reportTicks * 1000,
+                networkTime / reportTicks * 1000, clientSeconds > 0 ? server.bytesSent / clientSeconds / 1024 : 0);
+            lastReport = end;
+        }
+    }
+
+    printf("server ticks %d peak clients %d tick %.3f ms (update %.3f ms, network %.3f ms) worst %.3f ms\n",
+        reportTicks, peakClients, (updateTime + networkTime) / reportTicks * 1000, updateTime / reportTicks * 1000,
+        networkTime / reportTicks * 1000, worstTick * 1000);
+    printf("server per client %.2f KB/s out in %.1f packets/s, %.2f KB/s in\n",
+        clientSeconds > 0 ? server.bytesSent / clientSeconds / 1024 : 0, clientSeconds > 0 ? server.packetsSent / clientSeconds : 0,
+        clientSeconds > 0 ? server.bytesReceived / clientSeconds / 1024 : 0);
+
+    StopNetServer(&server);
+
+    return 0;
+}
+
+bool StartNetClient(NetClient *client, const char *address) {
+    memset(client, 0, sizeof(NetClient));
+    client->socket = -1;
+    client->lastConnect = -NET_CONNECT_RETRY;
+
+    if (!ResolveAddress(address, &client->server) || (client->socket = OpenSocket(0)) < 0) {
+        TraceLog(LOG_WARNING, "NET: [%s] Failed to open a connection", address);
+        return false;
+    }
+
+    return true;
+}
+
+void StopNetClient(NetClient *client) {
+    unsigned char packet = NET_DISCONNECT;
+
+    if (client->socket < 0) {
+        return;
+    }
+
+    if (client->connected) {
+        SendPacket(client->socket, &client->server, &packet, 1);
+    }
+
+    close(client->socket);
+    client->socket = -1;
+}
+
+// The server's ship after the newest input it applied, with the inputs still in flight replayed on top,
+// is the new prediction
+static void ReconcileShip(NetClient *client, const NetSnapshotHeader *header, const NetPlayer *own) {
+    unsigned int ack = header->inputAck;
+
+    if (ack > client->sequence || client->sequence - ack >= NET_PREDICTION_HISTORY) {
+        return;
+    }
+
+    // The first snapshot only tells the ship where it spawned
+    if (client->reconciled > 0 && ack > 0 && client->predictedX[ack % NET_PREDICTION_HISTORY] != header->shipX) {
+        client->mispredicted++;
+    }
+
+    client->reconciled++;
+    client->ship.x = header->shipX;
+    client->ship.y = SCALAR_FROM_FLOAT(DequantizePosition(own->y));
+
+    for (unsigned int sequence = ack + 1; sequence <= client->sequence; sequence++) {
+        MovePilotBody(&client->ship, client->welcome.boundaries, client->history[sequence % NET_PREDICTION_HISTORY], SCALAR(1));
+        client->predictedX[sequence % NET_PREDICTION_HISTORY] = client->ship.x;
+    }
+}
+
+static void ReceiveSnapshot(NetClient *client, const unsigned char *data, size_t size) {
+    NetSnapshotHeader header;
+    NetSnapshot snapshot;
+
+    if (size < sizeof(header)) {
+        return;
+    }
+
+    memcpy(&header, data, sizeof(header));
+
+    const NetSnapshot *base = &client->received[(header.baselineTick / NET_SNAPSHOT_INTERVAL) % NET_BASELINES];
+    const NetSnapshot *latest = &client->received[(client->latestTick / NET_SNAPSHOT_INTERVAL) % NET_BASELINES];
+    BitReader reader = { data + sizeof(header), size - sizeof(header), 0, 0, 0, false };
+
+    // Late arrivals are dropped; a baseline no longer kept cannot be decoded, and the next ack fixes that
+    if (header.tick <= client->latestTick || (header.baselineTick != 0 && base->tick != header.baselineTick)) {
+        return;
+    }
+
+    if (!DecodeSnapshot(&reader, &snapshot, header.baselineTick != 0 ? base : &emptySnapshot)) {
+        TraceLog(LOG_WARNING, "NET: Malformed snapshot for tick %u", header.tick);
+        return;
+    }
+
+    snapshot.tick = header.tick;
+
+    for (int seat = 0; seat < MAX_PLAYERS; seat++) {
+        unsigned int previous = (latest->seats & (1ull << seat)) ? latest->players[seat].shot : NET_SHOT_NONE;
+
+        if ((snapshot.seats & (1ull << seat)) && snapshot.players[seat].shot != previous) {
+            client->shotTicks[seat] = header.tick;
+        }
+    }
+
+    for (int slot = 0; slot < MAX_NUM_OF_ENEMIES; slot++) {
+        if ((snapshot.dying & ~latest->dying) & (1ull << slot)) {
+            client->dyingTicks[slot] = header.tick;
+        }
+    }
+
+    client->received[(header.tick / NET_SNAPSHOT_INTERVAL) % NET_BASELINES] = snapshot;
+    client->latestTick = header.tick;
+    client->snapshots++;
+    client->deltaSnapshots += header.baselineTick != 0;
+
+    if (snapshot.seats & (1ull << client->welcome.seat)) {
+        ReconcileShip(client, &header, &snapshot.players[client->welcome.seat]);
+    }
+}
+
+static void ReceiveClientPackets(NetClient *client) {
+    unsigned char packet[NET_MAX_PACKET];
+    struct sockaddr_in address;
+    socklen_t addressSize = sizeof(address);
+    ssize_t size;
+
+    while ((size = recvfrom(client->socket, packet, sizeof(packet), 0, (struct sockaddr *)&address, &addressSize)) > 0) {
+        addressSize = sizeof(address);
+
+        if (!SameAddress(&address, &client->server)) {
+            continue;
+        }
+
+        client->bytesReceived += size;
+        client->lastHeard = GetMonotonicTime();
+
+        if (packet[0] == NET_WELCOME && size >= 1 + (ssize_t)sizeof(NetWelcome) && !client->connected) {
+            memcpy(&client->welcome, packet + 1, sizeof(NetWelcome));
+
+            if (client->welcome.protocol != NET_PROTOCOL || client->welcome.seat < 0 || client->welcome.seat >= MAX_PLAYERS) {
+                continue;
+            }
+
+            client->connected = true;
+            client->sequence = 0;
+            client->latestTick = 0;
+            client->ship = (ScalarRectangle){ 0, 0, SCALAR(PLAYER_SIZE), SCALAR(PLAYER_SIZE) };
+            TraceLog(LOG_INFO, "NET: Connected to seat %d", client->welcome.seat);
+        } else if (packet[0] == NET_SNAPSHOT && client->connected) {
+            ReceiveSnapshot(client, packet + 1, size - 1);
+        }
+    }
+}
+
+// Once per local tick: take in snapshots, then predict this tick's input and send it
+void UpdateNetClient(NetClient *client, unsigned int buttons) {
+    double now = GetMonotonicTime();
+
+    ReceiveClientPackets(client);
+
+    if (client->connected && now - client->lastHeard > NET_TIMEOUT) {
+        TraceLog(LOG_WARNING, "NET: Server timed out, reconnecting");
+        client->connected = false;
+    }
+
+    if (!client->connected) {
+        if (now - client->lastConnect >= NET_CONNECT_RETRY) {
+            unsigned char packet[5] = { NET_CONNECT };
+            unsigned int protocol = NET_PROTOCOL;
+
+            memcpy(packet + 1, &protocol, sizeof(protocol));
+            SendPacket(client->socket, &client->server, packet, sizeof(packet));
+            client->lastConnect = now;
+        }
+
+        return;
+    }
+
+    buttons &= INPUT_LEFT | INPUT_RIGHT | INPUT_FIRE;
+    client->sequence++;
+    client->history[client->sequence % NET_PREDICTION_HISTORY] = buttons;
+    MovePilotBody(&client->ship, client->welcome.boundaries, buttons, SCALAR(1));
+    client->predictedX[client->sequence % NET_PREDICTION_HISTORY] = client->ship.x;
+    client->tickTime = now;
+
+    unsigned char packet[10 + NET_INPUT_REDUNDANCY] = { NET_INPUT };
+    int count = client->sequence < NET_INPUT_REDUNDANCY ? client->sequence : NET_INPUT_REDUNDANCY;
+
+    memcpy(packet + 1, &client->latestTick, sizeof(client->latestTick));
+    memcpy(packet + 5, &client->sequence, sizeof(client->sequence));
+    packet[9] = count;
+
+    for (int i = 0; i < count; i++) {
+        packet[10 + i] = client->history[(client->sequence - i) % NET_PREDICTION_HISTORY];
+    }
+
+    if (SendPacket(client->socket, &client->server, packet, 10 + count)) {
+        client->bytesSent += 10 + count;
+    }
+}
+
+// Other ships and the flock are shown as last received; the own ship as predicted
+void BuildNetRenderSnapshot(const NetClient *client, RenderSnapshot *snapshot) {
+    const NetSnapshot *latest = &client->received[(client->latestTick / NET_SNAPSHOT_INTERVAL) % NET_BASELINES];
+
+    snapshot->tick = client->latestTick;
+    snapshot->time = client->latestTick * TICK_TIME;
+    snapshot->publishTime = client->tickTime;
+    snapshot->inputSequence = client->sequence;
+    snapshot->boundaries = ScalarRectangleToFloat(client->welcome.boundaries);
+    snapshot->playerUIRect = client->welcome.playerUIRect;
+    snapshot->playerCount = 0;
+    snapshot->localPlayer = 0;
+    snapshot->projectileCount = 0;
+    snapshot->enemyCount = 0;
+    snapshot->hud = (HudState){ 0 };
+
+    if (client->latestTick == 0) {
+        return;
+    }
+
+    snapshot->hud.tuning = latest->tuning;
+
+    for (int seat = 0; seat < MAX_PLAYERS; seat++) {
+        const NetPlayer *player = &latest->players[seat];
+        Rectangle body = { DequantizePosition(player->x), DequantizePosition(player->y), PLAYER_SIZE, PLAYER_SIZE };
+
+        if (!(latest->seats & (1ull << seat))) {
+            continue;
+        }
+
+        if (seat == client->welcome.seat) {
+            body = ScalarRectangleToFloat(client->ship);
+            snapshot->localPlayer = snapshot->playerCount;
+            snapshot->hud.lives = player->lives;
+            snapshot->hud.score = player->score;
+        }
+
+        snapshot->players[snapshot->playerCount++] = body;
+
+        if (player->shot != NET_SHOT_NONE) {
+            ProjectileSnapshot *shot = &snapshot->projectiles[snapshot->projectileCount++];
+            shot->body = (Rectangle){ DequantizePosition(player->shotX), DequantizePosition(player->shotY), PROJECTILE_WIDTH, PROJECTILE_HEIGHT };
+            shot->state = PROJECTILE_STATE_ACTIVE + player->shot;
+            shot->stateStartTime = client->shotTicks[seat] * TICK_TIME;
+        }
+    }
+
+    for (int slot = 0; slot < MAX_NUM_OF_ENEMIES; slot++) {
+        if (!(latest->alive & (1ull << slot))) {
+            continue;
+        }
+
+        EnemySnapshot *enemy = &snapshot->enemies[snapshot->enemyCount++];
+        bool dying = latest->dying & (1ull << slot);
+
+        enemy->position = (Vector2){ DequantizePosition(latest->enemyX[slot]), DequantizePosition(latest->enemyY[slot]) };
+        enemy->body = (Rectangle){ enemy->position.x - ENEMY_SIZE / 2, enemy->position.y - ENEMY_SIZE / 2, ENEMY_SIZE, ENEMY_SIZE };
+        enemy->state = dying ? ENEMY_STATE_DYING : ENEMY_STATE_ACTIVE;
+        enemy->stateStartTime = dying ? client->dyingTicks[slot] * TICK_TIME : 0;
+        enemy->slot = slot;
+    }
+}
+
+// Headless load test: count clients on one thread, each sweeping and firing on its own schedule; ticks 0 runs
+// until killed
+int RunNetBots(const char *address, int count, int ticks) {
+    NetClient *bots = calloc(count, sizeof(NetClient));
+    double nextTick = GetMonotonicTime();
+    double start = nextTick;
+    int connected = 0;
+    int snapshots = 0;
+    int deltaSnapshots = 0;
+    int reconciled = 0;
+    int mispredicted = 0;
+    unsigned long long bytesReceived = 0;
+    unsigned long long bytesSent = 0;
+
+    for (int i = 0; i < count; i++) {
+        if (bots == NULL || !StartNetClient(&bots[i], address)) {
+            free(bots);
+            return 1;
+        }
+    }
+
+    for (int t = 0; ticks == 0 || t < ticks; t++) {
+        SleepUntil(nextTick);
+        nextTick += TICK_TIME;
+
+        for (int i = 0; i < count; i++) {
+            unsigned int buttons = INPUT_FIRE | (((t + i * 37) / 300) % 2 == 0 ? INPUT_RIGHT : INPUT_LEFT);
+            UpdateNetClient(&bots[i], buttons);
+        }
+    }
+
+    double seconds = GetMonotonicTime() - start;
+
+    for (int i = 0; i < count; i++) {
+        connected += bots[i].connected;
+        snapshots += bots[i].snapshots;
+        deltaSnapshots += bots[i].deltaSnapshots;
+        reconciled += bots[i].reconciled;
+        mispredicted += bots[i].mispredicted;
+        bytesReceived += bots[i].bytesReceived;
+        bytesSent += bots[i].bytesSent;
+        StopNetClient(&bots[i]);
+    }
+
+    printf("bots %d of %d connected, per client %.2f KB/s in and %.2f KB/s out\n", connected, count,
+        bytesReceived / seconds / count / 1024, bytesSent / seconds / count / 1024);
+    printf("bots received %d snapshots, %.1f%% deltas, %.0f bytes each; %d of %d reconciliations mispredicted\n",
+        snapshots, snapshots > 0 ? 100.0 * deltaSnapshots / snapshots : 0, snapshots > 0 ? (double)bytesReceived / snapshots : 0,
+        mispredicted, reconciled);
+
+    free(bots);
+
+    return connected == count && snapshots > 0 ? 0 : 1;
+}
@@ -0,0 +1,133 @@
+#ifndef NET_H
+#define NET_H
+
+#include <stdbool.h>
+#include <netinet/in.h>
+#include "game.h"
+
+#define NET_DEFAULT_PORT 7777
+#define NET_MAX_PACKET 1200 // under the usual path MTU, so a snapshot never fragments
+#define NET_SNAPSHOT_INTERVAL 2 // ticks per snapshot
+#define NET_BASELINES 32 // snapshots both ends keep to delta against; a power of two
+#define NET_INPUT_REDUNDANCY 8 // newest inputs repeated in every input packet, so a lost packet loses nothing
+#define NET_INPUT_QUEUE 16 // inputs the server holds per client; a power of two
+#define NET_PREDICTION_HISTORY 256 // predicted ticks a client keeps for reconciling; a power of two
+#define NET_CONNECT_RETRY 0.25 // seconds
+#define NET_TIMEOUT 3.0 // seconds of silence before the other end is dropped
+#define NET_POSITION_SCALE 16 // int16 positions count 1/16 pixels
+#define NET_SMALL_DELTA_BITS 7 // zigzag deltas below 1 << 7 take the short form
+#define NET_SHOT_NONE 3 // NetPlayer.shot when the seat has no projectile
+
+// Snapshots carry raw Scalars, so fixed point and float builds cannot play together
+#ifdef FIXED_POINT
+#define NET_PROTOCOL (0x494E5601 | 0x100)
+#else
+#define NET_PROTOCOL 0x494E5601
+#endif
+
+typedef enum NetMessage {
+    NET_CONNECT = 1,
+    NET_WELCOME,
+    NET_INPUT,
+    NET_SNAPSHOT,
+    NET_DISCONNECT,
+} NetMessage;
+
+// Quantized state as a snapshot carries it; both ends keep recent ones as delta baselines
+typedef struct NetPlayer {
+    short x;
+    short y;
+    short shotX;
+    short shotY;
+    unsigned short score;
+    unsigned char state;
+    unsigned char lives;
+    unsigned char shot; // projectile state less PROJECTILE_STATE_ACTIVE, or NET_SHOT_NONE
+} NetPlayer;
+
+typedef struct NetSnapshot {
+    unsigned int tick;
+    unsigned long long seats; // bit per occupied seat
+    NetPlayer players[MAX_PLAYERS]; // by seat
+    unsigned long long alive; // bit per flock slot
+    unsigned long long dying;
+    short enemyX[MAX_NUM_OF_ENEMIES]; // centres, by slot
+    short enemyY[MAX_NUM_OF_ENEMIES];
+    Tuning tuning;
+} NetSnapshot;
+
+// Byte aligned part of a snapshot packet; the bit-packed delta follows it
+typedef struct NetSnapshotHeader {
+    unsigned int tick;
+    unsigned int baselineTick; // 0 when the snapshot stands on its own
+    unsigned int inputAck; // newest input of this client the tick has applied
+    Scalar shipX; // exact, so reconciling adds no quantization error
+} NetSnapshotHeader;
+
+typedef struct NetWelcome {
+    unsigned int protocol;
+    int seat;
+    ScalarRectangle boundaries;
+    Rectangle playerUIRect;
+} NetWelcome;
+
+typedef struct NetServerClient {
+    struct sockaddr_in address;
+    bool connected;
+    Entity player;
+    double lastHeard;
+    unsigned int ackTick; // newest snapshot the client has confirmed
+    unsigned int inputs[NET_INPUT_QUEUE]; // buttons, by sequence
+    unsigned int inputSequences[NET_INPUT_QUEUE];
+    unsigned int inputNewest;
+    unsigned int inputApplied;
+    unsigned int buttons; // held by the last applied input, repeated while the queue is empty
+} NetServerClient;
+
+typedef struct NetServer {
+    int socket;
+    Game *game;
+    NetServerClient clients[MAX_PLAYERS]; // by seat
+    int clientCount;
+    NetSnapshot history[NET_BASELINES]; // sent snapshots, by tick / NET_SNAPSHOT_INTERVAL
+    unsigned long long bytesSent;
+    unsigned long long bytesReceived;
+    unsigned long long packetsSent;
+} NetServer;
+
+typedef struct NetClient {
+    int socket;
+    struct sockaddr_in server;
+    bool connected;
+    NetWelcome welcome;
+    double lastHeard;
+    double lastConnect;
+    NetSnapshot received[NET_BASELINES]; // decoded snapshots, by tick / NET_SNAPSHOT_INTERVAL
+    unsigned int latestTick;
+    unsigned int sequence; // newest input sent
+    double tickTime; // when that input was predicted
+    unsigned int history[NET_PREDICTION_HISTORY]; // buttons, by sequence
+    Scalar predictedX[NET_PREDICTION_HISTORY]; // own ship after that input
+    ScalarRectangle ship;
+    unsigned int shotTicks[MAX_PLAYERS]; // tick each seat's projectile entered its state, for animation
+    unsigned int dyingTicks[MAX_NUM_OF_ENEMIES];
+    unsigned long long bytesSent;
+    unsigned long long bytesReceived;
+    int snapshots;
+    int deltaSnapshots;
+    int reconciled;
+    int mispredicted;
+} NetClient;
+
+bool StartNetServer(NetServer *server, Game *game, int port);
+void StopNetServer(NetServer *server);
+void UpdateNetServer(NetServer *server);
+void SendNetSnapshots(NetServer *server);
+int RunNetServer(Game *game, int port, int ticks);
+bool StartNetClient(NetClient *client, const char *address);
+void StopNetClient(NetClient *client);
+void UpdateNetClient(NetClient *client, unsigned int buttons);
+void BuildNetRenderSnapshot(const NetClient *client, RenderSnapshot *snapshot);
+int RunNetBots(const char *address, int count, int ticks);
+
+#endif
@@ -0,0 +1,123 @@
+#include <errno.h>
+#include <math.h>
+#include <time.h>
+#include "raylib.h"
+#include "pacing.h"
+#include "profiler.h"
+
+static double GetCpuTime(clockid_t clock) {
+    struct timespec now;
+    clock_gettime(clock, &now);
+
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+void SleepUntil(double time) {
+    struct timespec deadline;
+    deadline.tv_sec = (time_t)time;
+    deadline.tv_nsec = (long)((time - deadline.tv_sec) * 1e9);
+
+    int result;
+
+    do {
+        result = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL);
+    } while (result == EINTR);
+}
+
+// Tracks a high percentile of sleep overshoot: grows fast, shrinks slowly, and ignores preemptions
+static void LearnSleepOvershoot(FramePacer *pacer, double overshoot) {
+    double margin = overshoot * 1.25;
+
+    if (margin > PACING_MAX_SPIN) {
+        return;
+    }
+
+    pacer->spinMargin += (margin - pacer->spinMargin) * (margin > pacer->spinMargin ? 0.25 : 0.01);
+
+    if (pacer->spinMargin < PACING_MIN_SPIN) {
+        pacer->spinMargin = PACING_MIN_SPIN;
+    } else if (pacer->spinMargin > PACING_MAX_SPIN) {
+        pacer->spinMargin = PACING_MAX_SPIN;
+    }
+}
+
+void InitFramePacer(FramePacer *pacer, int targetFps) {
+    pacer->interval = 1.0 / targetFps;
+    pacer->spinMargin = PACING_MIN_SPIN;
+    pacer->swapTime = 0;
+    pacer->displayPaced = false;
+
+    // Short sleeps show the timer slack of this machine before the first frame depends on it
+    for (int i = 0; i < PACING_CALIBRATION_SLEEPS; i++) {
+        double target = GetMonotonicTime() + 0.0002;
+        SleepUntil(target);
+        LearnSleepOvershoot(pacer, GetMonotonicTime() - target);
+    }
+
+    TraceLog(LOG_INFO, "PACING: Target %d fps, spinning the last %.0f us of each frame", targetFps, pacer->spinMargin * 1e6);
+    ResetFramePacer(pacer);
+}
+
+// Starts a fresh schedule, e.g. after frames were driven by events instead of the pacer
+void ResetFramePacer(FramePacer *pacer) {
+    double now = GetMonotonicTime();
+    pacer->deadline = now + pacer->interval;
+    pacer->presentStart = now;
+    pacer->lastPresent = now;
+    pacer->frameTime = pacer->interval;
+    pacer->processCpu = GetCpuTime(CLOCK_PROCESS_CPUTIME_ID);
+    pacer->threadCpu = GetCpuTime(CLOCK_THREAD_CPUTIME_ID);
+}
+
+// Call right before EndDrawing so the time blocked in the swap can be told apart from our own work
+void BeginFramePresent(FramePacer *pacer) {
+    pacer->presentStart = GetMonotonicTime();
+}
+
+// Call right after EndDrawing: records the present, then waits for the next frame's start
+void WaitForNextFrame(FramePacer *pacer) {
+    double present = GetMonotonicTime();
+    double processCpu = GetCpuTime(CLOCK_PROCESS_CPUTIME_ID);
+    double threadCpu = GetCpuTime(CLOCK_THREAD_CPUTIME_ID);
+
+    pacer->frameTime = present - pacer->lastPresent;
+    pacer->swapTime += ((present - pacer->presentStart) - pacer->swapTime) * PROFILER_SMOOTHING;
+
+    ProfilerRecord("present interval", "%.3f ms", pacer->frameTime * 1000);
+    ProfilerRecord("present jitter", "%.3f ms", fabs(pacer->frameTime - pacer->interval) * 1000);
+    ProfilerRecord("process cpu", "%.0f %%", (processCpu - pacer->processCpu) / pacer->frameTime * 100);
+    ProfilerRecord("render thread cpu", "%.3f ms", (threadCpu - pacer->threadCpu) * 1000);
+    ProfilerSetCounter("spin margin", "%.0f us", pacer->spinMargin * 1e6);
+
+    pacer->lastPresent = present;
+    pacer->processCpu = processCpu;
+    pacer->threadCpu = threadCpu;
+
+    // When the swap itself blocks for vsync the display sets the cadence; sleeping too would skip refreshes
+    bool displayPaced = pacer->swapTime > pacer->interval * PACING_DISPLAY_PACED;
+
+    if (displayPaced != pacer->displayPaced) {
+        pacer->displayPaced = displayPaced;
+        TraceLog(LOG_INFO, "PACING: %s", displayPaced ? "Following display refresh" : "Pacing frames in software");
+    }
+
+    pacer->deadline += pacer->interval;
+
+    // A late frame restarts the schedule from now instead of rushing to catch up
+    if (displayPaced || pacer->deadline < present) {
+        pacer->deadline = present + (displayPaced ? 0 : pacer->interval);
+        return;
+    }
+
+    double sleepUntil = pacer->deadline - pacer->spinMargin;
+
+    if (sleepUntil > present) {
+        SleepUntil(sleepUntil);
+        LearnSleepOvershoot(pacer, GetMonotonicTime() - sleepUntil);
+    }
+
+    while (GetMonotonicTime() < pacer->deadline) {
+    }
+
+    ProfilerRecord("pacing wait", "%.3f ms", (GetMonotonicTime() - present) * 1000);
+}
@@ -0,0 +1,31 @@
+#ifndef PACING_H
+#define PACING_H
+
+#include <stdbool.h>
+
+#define PACING_MIN_SPIN 0.00005 // seconds
+#define PACING_MAX_SPIN 0.004
+#define PACING_CALIBRATION_SLEEPS 20
+#define PACING_DISPLAY_PACED 0.25 // fraction of the interval spent blocked in the swap
+
+// Sleeps most of the slack before each frame and spins only the last stretch the OS cannot hit
+typedef struct FramePacer {
+    double interval;        // target seconds per frame
+    double deadline;        // when the next frame should begin
+    double spinMargin;      // learned sleep overshoot; this much before the deadline is spun
+    double presentStart;
+    double lastPresent;
+    double frameTime;       // last present-to-present interval
+    double swapTime;        // smoothed time spent inside the swap
+    double processCpu;
+    double threadCpu;
+    bool displayPaced;
+} FramePacer;
+
+void InitFramePacer(FramePacer *pacer, int targetFps);
+void ResetFramePacer(FramePacer *pacer);
+void SleepUntil(double time);
+void BeginFramePresent(FramePacer *pacer);
+void WaitForNextFrame(FramePacer *pacer);
+
+#endif
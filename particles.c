@@ -0,0 +1,321 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "raylib.h"
+#include "raymath.h"
+#include "rlgl.h"
+#include "particles.h"
+#include "profiler.h"
+
+#define PARTICLE_STRESS_BURST 64
+
+// GCC vector extension; compiles to SSE or NEON without -march and to AVX when it is enabled
+typedef float ParticleLanes __attribute__((vector_size(PARTICLE_LANES * sizeof(float))));
+
+// One array per field, so integration streams whole lanes and the renderer uploads arrays as they are
+typedef struct ParticlePool {
+    float *x;
+    float *y;
+    float *vx;
+    float *vy;
+    float *life; // 1 at birth, fades to 0
+    float *decay; // life lost per second
+    Color *color;
+    int count;
+} ParticlePool;
+
+typedef enum ParticleBuffer {
+    PARTICLE_BUFFER_X,
+    PARTICLE_BUFFER_Y,
+    PARTICLE_BUFFER_LIFE,
+    PARTICLE_BUFFER_COLOR,
+    PARTICLE_BUFFER_COUNT,
+} ParticleBuffer;
+
+// Quad corners are per vertex; everything else is per instance, one particle each
+static const char *vertexSource =
+    "#version 330\n"
+    "in vec2 vertexPosition;\n"
+    "in float particleX;\n"
+    "in float particleY;\n"
+    "in float particleLife;\n"
+    "in vec4 particleColor;\n"
+    "uniform mat4 mvp;\n"
+    "out vec4 fragColor;\n"
+    "void main() {\n"
+    "    fragColor = vec4(particleColor.rgb, particleColor.a * particleLife);\n"
+    "    gl_Position = mvp * vec4(vertexPosition + vec2(particleX, particleY), 0.0, 1.0);\n"
+    "}\n";
+
+static const char *fragmentSource =
+    "#version 330\n"
+    "in vec4 fragColor;\n"
+    "out vec4 finalColor;\n"
+    "void main() {\n"
+    "    finalColor = fragColor;\n"
+    "}\n";
+
+static ParticlePool pool;
+static Color enemyColors[ENEMIES_ROWS];
+static double emittedUntil = -1; // snapshot time whose state changes already have particles
+static int stressCount = 0;
+static unsigned int seed = 0x9E3779B9;
+
+static Shader shader;
+static unsigned int vao;
+static unsigned int quadBuffer;
+static unsigned int buffers[PARTICLE_BUFFER_COUNT];
+static bool rendererReady = false;
+
+// xorshift32; GetRandomValue goes through rand() and integers, too slow for stress refills
+static float RandomUnit(void) {
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+
+    return (seed >> 8) * (1.0f / 16777216.0f);
+}
+
+static void *AllocLanes(size_t size) {
+    void *lanes = aligned_alloc(sizeof(ParticleLanes), size);
+
+    if (lanes != NULL) {
+        memset(lanes, 0, size);
+    }
+
+    return lanes;
+}
+
+static void EmitBurst(Vector2 origin, int count, float speed, Color color) {
+    if (count > PARTICLE_CAPACITY - pool.count) {
+        count = PARTICLE_CAPACITY - pool.count;
+    }
+
+    for (int n = 0; n < count; n++) {
+        int i = pool.count++;
+        float angle = RandomUnit() * 2 * PI;
+        float magnitude = speed * (0.25f + 0.75f * RandomUnit());
+
+        pool.x[i] = origin.x;
+        pool.y[i] = origin.y;
+        pool.vx[i] = cosf(angle) * magnitude;
+        pool.vy[i] = sinf(angle) * magnitude;
+        pool.life[i] = 1;
+        pool.decay[i] = 1 / (0.4f + 0.6f * RandomUnit());
+        pool.color[i] = color;
+    }
+}
+
+// Emits for every entity that started dying or exploding after the last snapshot handled, so
+// skipped or repeated snapshots neither drop nor double a burst
+static void EmitStateChanges(const RenderSnapshot *snapshot) {
+    // Time only runs backwards after a rewind or a seek; changes from then on are new again
+    if (snapshot->time < emittedUntil) {
+        emittedUntil = snapshot->time;
+    }
+
+    if (snapshot->time <= emittedUntil) {
+        return;
+    }
+
+    for (int i = 0; i < snapshot->enemyCount; i++) {
+        const EnemySnapshot *enemy = &snapshot->enemies[i];
+
+        if (enemy->state == ENEMY_STATE_DYING && enemy->stateStartTime > emittedUntil) {
+            EmitBurst(enemy->position, PARTICLES_PER_ENEMY, 220, enemyColors[enemy->slot / ENEMIES_COLS]);
+        }
+    }
+
+    for (int i = 0; i < snapshot->projectileCount; i++) {
+        const ProjectileSnapshot *projectile = &snapshot->projectiles[i];
+
+        if (projectile->state == PROJECTILE_STATE_EXPLODING && projectile->stateStartTime > emittedUntil) {
+            Vector2 centre = { projectile->body.x + projectile->body.width / 2, projectile->body.y + projectile->body.height / 2 };
+            EmitBurst(centre, PARTICLES_PER_EXPLOSION, 160, YELLOW);
+        }
+    }
+
+    emittedUntil = snapshot->time;
+}
+
+// Keeps the pool topped up with bursts scattered over the playfield, for load testing
+static void EmitStress(const RenderSnapshot *snapshot) {
+    Rectangle area = snapshot->boundaries;
+
+    while (pool.count < stressCount) {
+        Vector2 origin = { area.x + RandomUnit() * area.width, area.y + RandomUnit() * area.height };
+        Color color = enemyColors[(int)(RandomUnit() * ENEMIES_ROWS)];
+        EmitBurst(origin, stressCount - pool.count < PARTICLE_STRESS_BURST ? stressCount - pool.count : PARTICLE_STRESS_BURST, 220, color);
+    }
+}
+
+static void IntegrateParticles(float frameTime) {
+    ParticleLanes *x = (ParticleLanes *)pool.x;
+    ParticleLanes *y = (ParticleLanes *)pool.y;
+    ParticleLanes *vx = (ParticleLanes *)pool.vx;
+    ParticleLanes *vy = (ParticleLanes *)pool.vy;
+    ParticleLanes *life = (ParticleLanes *)pool.life;
+    ParticleLanes *decay = (ParticleLanes *)pool.decay;
+    float drag = 1 - PARTICLE_DRAG * frameTime;
+    float fall = PARTICLE_GRAVITY * frameTime;
+    int blocks = (pool.count + PARTICLE_LANES - 1) / PARTICLE_LANES;
+
+    // The tail of the last block is padding or dead slots; integrating it is harmless
+    for (int i = 0; i < blocks; i++) {
+        vx[i] = vx[i] * drag;
+        vy[i] = vy[i] * drag + fall;
+        x[i] += vx[i] * frameTime;
+        y[i] += vy[i] * frameTime;
+        life[i] -= decay[i] * frameTime;
+    }
+}
+
+// Walk backwards so that swap-back removal only moves rows already visited
+static void RemoveDeadParticles(void) {
+    for (int i = pool.count - 1; i >= 0; i--) {
+        if (pool.life[i] > 0) {
+            continue;
+        }
+
+        int last = --pool.count;
+        pool.x[i] = pool.x[last];
+        pool.y[i] = pool.y[last];
+        pool.vx[i] = pool.vx[last];
+        pool.vy[i] = pool.vy[last];
+        pool.life[i] = pool.life[last];
+        pool.decay[i] = pool.decay[last];
+        pool.color[i] = pool.color[last];
+    }
+}
+
+// Allocates the whole pool up front; nothing is allocated per frame afterwards
+bool InitParticles(const Color rowColors[ENEMIES_ROWS]) {
+    size_t size = PARTICLE_CAPACITY * sizeof(float);
+
+    memcpy(enemyColors, rowColors, sizeof(enemyColors));
+    memset(&pool, 0, sizeof(pool));
+    pool.x = AllocLanes(size);
+    pool.y = AllocLanes(size);
+    pool.vx = AllocLanes(size);
+    pool.vy = AllocLanes(size);
+    pool.life = AllocLanes(size);
+    pool.decay = AllocLanes(size);
+    pool.color = AllocLanes(PARTICLE_CAPACITY * sizeof(Color));
+    emittedUntil = -1;
+
+    if (!pool.x || !pool.y || !pool.vx || !pool.vy || !pool.life || !pool.decay || !pool.color) {
+        TraceLog(LOG_WARNING, "PARTICLES: Failed to allocate a pool of %d particles", PARTICLE_CAPACITY);
+        UnloadParticles();
+        return false;
+    }
+
+    return true;
+}
+
+// Streams the pool's arrays straight into per-instance attributes of one quad
+bool InitParticleRenderer(void) {
+    shader = LoadShaderFromMemory(vertexSource, fragmentSource);
+
+    if (!IsShaderReady(shader) || shader.id == rlGetShaderIdDefault()) {
+        TraceLog(LOG_WARNING, "PARTICLES: Instancing shader unavailable, particles are not drawn");
+        return false;
+    }
+
+    const char *attributes[PARTICLE_BUFFER_COUNT] = { "particleX", "particleY", "particleLife", "particleColor" };
+    const int sizes[PARTICLE_BUFFER_COUNT] = { 1, 1, 1, 4 };
+    const float half = PARTICLE_SIZE / 2.0f;
+    // Counter-clockwise once the y-down projection flips it, or rlgl's back-face culling drops it
+    const float quad[] = { -half, -half, -half, half, half, half, -half, -half, half, half, half, -half };
+
+    vao = rlLoadVertexArray();
+    rlEnableVertexArray(vao);
+
+    quadBuffer = rlLoadVertexBuffer(quad, sizeof(quad), false);
+    rlSetVertexAttribute(shader.locs[SHADER_LOC_VERTEX_POSITION], 2, RL_FLOAT, false, 0, 0);
+    rlEnableVertexAttribute(shader.locs[SHADER_LOC_VERTEX_POSITION]);
+
+    for (int i = 0; i < PARTICLE_BUFFER_COUNT; i++) {
+        int location = GetShaderLocationAttrib(shader, attributes[i]);
+        bool color = i == PARTICLE_BUFFER_COLOR;
+
+        buffers[i] = rlLoadVertexBuffer(NULL, PARTICLE_CAPACITY * 4, true);
+        rlSetVertexAttribute(location, sizes[i], color ? RL_UNSIGNED_BYTE : RL_FLOAT, color, 0, 0);
+        rlEnableVertexAttribute(location);
+        rlSetVertexAttributeDivisor(location, 1);
+    }
+
+    rlDisableVertexArray();
+    rendererReady = true;
+
+    return true;
+}
+
+void UnloadParticles(void) {
+    if (rendererReady) {
+        for (int i = 0; i < PARTICLE_BUFFER_COUNT; i++) {
+            rlUnloadVertexBuffer(buffers[i]);
+        }
+
+        rlUnloadVertexBuffer(quadBuffer);
+        rlUnloadVertexArray(vao);
+        UnloadShader(shader);
+        rendererReady = false;
+    }
+
+    free(pool.x);
+    free(pool.y);
+    free(pool.vx);
+    free(pool.vy);
+    free(pool.life);
+    free(pool.decay);
+    free(pool.color);
+    memset(&pool, 0, sizeof(pool));
+}
+
+void SetParticleStress(int count) {
+    stressCount = count < PARTICLE_CAPACITY ? count : PARTICLE_CAPACITY;
+}
+
+// Emits for the snapshot's state changes, then moves and fades everything by frameTime
+void UpdateParticles(const RenderSnapshot *snapshot, float frameTime) {
+    if (pool.x == NULL) {
+        return;
+    }
+
+    double start = GetMonotonicTime();
+
+    EmitStateChanges(snapshot);
+    EmitStress(snapshot);
+    IntegrateParticles(frameTime);
+    RemoveDeadParticles();
+
+    ProfilerSetCounter("particles", "%.0f", pool.count);
+    ProfilerRecord("particle update", "%.3f ms", (GetMonotonicTime() - start) * 1000);
+}
+
+void DrawParticles(void) {
+    if (!rendererReady || pool.count == 0) {
+        return;
+    }
+
+    double start = GetMonotonicTime();
+
+    // Switching the blend mode flushes raylib's batch, so everything drawn so far stays underneath
+    BeginBlendMode(BLEND_ADDITIVE);
+
+    rlUpdateVertexBuffer(buffers[PARTICLE_BUFFER_X], pool.x, pool.count * sizeof(float), 0);
+    rlUpdateVertexBuffer(buffers[PARTICLE_BUFFER_Y], pool.y, pool.count * sizeof(float), 0);
+    rlUpdateVertexBuffer(buffers[PARTICLE_BUFFER_LIFE], pool.life, pool.count * sizeof(float), 0);
+    rlUpdateVertexBuffer(buffers[PARTICLE_BUFFER_COLOR], pool.color, pool.count * sizeof(Color), 0);
+
+    rlEnableShader(shader.id);
+    rlSetUniformMatrix(shader.locs[SHADER_LOC_MATRIX_MVP], MatrixMultiply(rlGetMatrixModelview(), rlGetMatrixProjection()));
+    rlEnableVertexArray(vao);
+    rlDrawVertexArrayInstanced(0, 6, pool.count);
+    rlDisableVertexArray();
+    rlDisableShader();
+
+    EndBlendMode();
+
+    ProfilerRecord("particle draw", "%.3f ms", (GetMonotonicTime() - start) * 1000);
+}
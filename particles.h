@@ -0,0 +1,22 @@
+#ifndef PARTICLES_H
+#define PARTICLES_H
+
+#include <stdbool.h>
+#include "game.h"
+
+#define PARTICLE_CAPACITY (256 * 1024)
+#define PARTICLE_LANES 8 // floats integrated per SIMD step; the pool is padded and aligned to this
+#define PARTICLE_SIZE 3
+#define PARTICLE_DRAG 1.5 // fraction of velocity lost per second
+#define PARTICLE_GRAVITY 120
+#define PARTICLES_PER_ENEMY 160
+#define PARTICLES_PER_EXPLOSION 48
+
+bool InitParticles(const Color rowColors[ENEMIES_ROWS]);
+bool InitParticleRenderer(void);
+void UnloadParticles(void);
+void SetParticleStress(int count);
+void UpdateParticles(const RenderSnapshot *snapshot, float frameTime);
+void DrawParticles(void);
+
+#endif
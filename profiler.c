@@ -0,0 +1,94 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "raylib.h"
+#include "profiler.h"
+
+static ProfilerEntry entries[PROFILER_MAX_ENTRIES];
+static int entryCount = 0;
+static bool visible = false;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+double GetMonotonicTime(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+// Entries are keyed by name; callers pass string literals so the pointer stays valid
+static ProfilerEntry *FindEntry(const char *name, const char *format) {
+    for (int i = 0; i < entryCount; i++) {
+        if (entries[i].name == name || strcmp(entries[i].name, name) == 0) {
+            return &entries[i];
+        }
+    }
+
+    if (entryCount == PROFILER_MAX_ENTRIES) {
+        return NULL;
+    }
+
+    ProfilerEntry *entry = &entries[entryCount++];
+    entry->name = name;
+    entry->format = format;
+    entry->value = 0;
+    entry->highlighted = false;
+
+    return entry;
+}
+
+void ProfilerRecord(const char *name, const char *format, double value) {
+    pthread_mutex_lock(&lock);
+    ProfilerEntry *entry = FindEntry(name, format);
+
+    if (entry != NULL) {
+        entry->value += (value - entry->value) * PROFILER_SMOOTHING;
+    }
+
+    pthread_mutex_unlock(&lock);
+}
+
+void ProfilerSetCounter(const char *name, const char *format, double value) {
+    pthread_mutex_lock(&lock);
+    ProfilerEntry *entry = FindEntry(name, format);
+
+    if (entry != NULL) {
+        entry->value = value;
+    }
+
+    pthread_mutex_unlock(&lock);
+}
+
+void ProfilerHighlight(const char *name, bool highlighted) {
+    pthread_mutex_lock(&lock);
+
+    for (int i = 0; i < entryCount; i++) {
+        if (entries[i].name == name || strcmp(entries[i].name, name) == 0) {
+            entries[i].highlighted = highlighted;
+        }
+    }
+
+    pthread_mutex_unlock(&lock);
+}
+
+void ToggleProfiler(void) {
+    visible = !visible;
+}
+
+void DrawProfiler(int x, int y) {
+    if (!visible) {
+        return;
+    }
+
+    pthread_mutex_lock(&lock);
+
+    for (int i = 0; i < entryCount; i++) {
+        char line[96];
+        int length = snprintf(line, sizeof(line), "%s ", entries[i].name);
+        snprintf(line + length, sizeof(line) - length, entries[i].format, entries[i].value);
+        DrawText(line, x, y + i * 12, 10, entries[i].highlighted ? ORANGE : LIGHTGRAY);
+    }
+
+    pthread_mutex_unlock(&lock);
+}
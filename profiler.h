@@ -0,0 +1,23 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdbool.h>
+
+#define PROFILER_MAX_ENTRIES 64
+#define PROFILER_SMOOTHING 0.1
+
+typedef struct ProfilerEntry {
+    const char *name;
+    const char *format;
+    double value;
+    bool highlighted;
+} ProfilerEntry;
+
+double GetMonotonicTime(void);
+void ProfilerRecord(const char *name, const char *format, double value);
+void ProfilerSetCounter(const char *name, const char *format, double value);
+void ProfilerHighlight(const char *name, bool highlighted);
+void ToggleProfiler(void);
+void DrawProfiler(int x, int y);
+
+#endif
@@ -0,0 +1,567 @@
+#include <stdlib.h>
+#include <string.h>
+#include "raylib.h"
+#include "replay.h"
+
+// Grows a byte buffer to at least size, doubling so per-tick appends stay amortized
+static bool ReserveBytes(unsigned char **buffer, size_t *capacity, size_t size) {
+    if (size <= *capacity) {
+        return true;
+    }
+
+    size_t grown = *capacity ? *capacity : 4096;
+    while (grown < size) {
+        grown *= 2;
+    }
+
+    unsigned char *data = realloc(*buffer, grown);
+
+    if (data == NULL) {
+        return false;
+    }
+
+    *buffer = data;
+    *capacity = grown;
+
+    return true;
+}
+
+// Fixed buffers stay put, so the encoder can run where allocating is not allowed
+static bool ReserveChunkBytes(ReplayChunkEncoder *encoder, unsigned char **buffer, size_t *capacity, size_t size) {
+    if (size <= *capacity || (!encoder->fixed && ReserveBytes(buffer, capacity, size))) {
+        return true;
+    }
+
+    encoder->failed = true;
+
+    return false;
+}
+
+static void AppendBytes(ReplayChunkEncoder *encoder, const void *data, size_t size) {
+    if (!ReserveChunkBytes(encoder, &encoder->buffer, &encoder->capacity, encoder->size + size)) {
+        return;
+    }
+
+    memcpy(encoder->buffer + encoder->size, data, size);
+    encoder->size += size;
+}
+
+// LEB128: seven bits per byte, low groups first, high bit set on all but the last
+static void AppendVarint(ReplayChunkEncoder *encoder, unsigned int value) {
+    unsigned char bytes[5];
+    int count = 0;
+
+    do {
+        bytes[count] = value & 0x7F;
+        value >>= 7;
+        bytes[count] |= value ? 0x80 : 0;
+        count++;
+    } while (value);
+
+    AppendBytes(encoder, bytes, count);
+}
+
+// Parts are compared by their low 32 bits; only the ones that moved since the previous tick are stored
+static void AppendHash(ReplayChunkEncoder *encoder, const StateHash *hash) {
+    unsigned char record[1 + HASH_PART_COUNT * sizeof(unsigned int)] = { 0 };
+    size_t size = 1;
+
+    for (int p = 0; p < HASH_PART_COUNT; p++) {
+        unsigned int low = hash->parts[p];
+
+        if (low != (unsigned int)encoder->previousHash.parts[p]) {
+            record[0] |= 1 << p;
+            memcpy(record + size, &low, sizeof(low));
+            size += sizeof(low);
+        }
+    }
+
+    if (!ReserveChunkBytes(encoder, &encoder->hashes, &encoder->hashCapacity, encoder->hashSize + size)) {
+        return;
+    }
+
+    memcpy(encoder->hashes + encoder->hashSize, record, size);
+    encoder->hashSize += size;
+    encoder->previousHash = *hash;
+}
+
+// Starts a chunk whose keyframe is the game as it stands; the buffers are reused from the previous chunk
+void OpenReplayChunk(ReplayChunkEncoder *encoder, const Game *game) {
+    StateWriter state = { encoder->buffer, encoder->capacity, 0 };
+
+    encoder->chunk.magic = 0;
+    encoder->failed = false;
+    SaveGameState(game, &state);
+
+    if (state.size > encoder->capacity) {
+        if (!ReserveChunkBytes(encoder, &encoder->buffer, &encoder->capacity, state.size)) {
+            return;
+        }
+
+        state = (StateWriter){ encoder->buffer, encoder->capacity, 0 };
+        SaveGameState(game, &state);
+    }
+
+    encoder->chunk = (ReplayChunk){ REPLAY_CHUNK_MAGIC, 0, game->tick, state.size, 0, 0 };
+    encoder->size = state.size;
+    encoder->previous = (GameInput){ 0 };
+    encoder->repeat = 0;
+    encoder->hashSize = 0;
+    encoder->previousHash = (StateHash){ 0 };
+}
+
+// Called with the state the input is about to be applied to. Ticks whose held buttons match the previous
+// tick and carry no events or spawn click collapse into a run; the others store their changed bits
+void AppendReplayTick(ReplayChunkEncoder *encoder, const Game *game, const GameInput *input) {
+    encoder->chunk.tickCount++;
+    AppendHash(encoder, &game->hash);
+
+    if (input->buttons == encoder->previous.buttons && input->eventCount == 0 && !(input->buttons & INPUT_SPAWN_FLOCK)) {
+        encoder->repeat++;
+        return;
+    }
+
+    AppendVarint(encoder, encoder->repeat);
+    AppendVarint(encoder, input->buttons ^ encoder->previous.buttons);
+    AppendVarint(encoder, input->eventCount);
+
+    if (input->buttons & INPUT_SPAWN_FLOCK) {
+        AppendBytes(encoder, &input->spawnPosition, sizeof(Vector2));
+    }
+
+    // Offsets are stored bit for bit; re-simulation must see exactly the floats the game saw
+    for (int i = 0; i < input->eventCount; i++) {
+        unsigned char down = input->events[i].down;
+        AppendBytes(encoder, &input->events[i].offset, sizeof(float));
+        AppendVarint(encoder, input->events[i].button);
+        AppendBytes(encoder, &down, 1);
+    }
+
+    encoder->previous.buttons = input->buttons;
+    encoder->repeat = 0;
+}
+
+// Ends the open run and fills in the section sizes; the chunk header and buffers are then ready to write
+void CloseReplayChunk(ReplayChunkEncoder *encoder) {
+    if (encoder->repeat > 0) {
+        AppendVarint(encoder, encoder->repeat);
+        encoder->repeat = 0;
+    }
+
+    encoder->chunk.inputSize = encoder->size - encoder->chunk.stateSize;
+    encoder->chunk.hashSize = encoder->hashSize;
+}
+
+static void FlushReplayChunk(ReplayWriter *writer) {
+    ReplayChunkEncoder *encoder = &writer->encoder;
+
+    if (encoder->chunk.magic == 0) {
+        return;
+    }
+
+    CloseReplayChunk(encoder);
+
+    if (writer->indexCount == writer->indexCapacity) {
+        int capacity = writer->indexCapacity ? writer->indexCapacity * 2 : 64;
+        ReplayIndexEntry *index = realloc(writer->index, capacity * sizeof(ReplayIndexEntry));
+
+        if (index == NULL) {
+            writer->failed = true;
+            return;
+        }
+
+        writer->index = index;
+        writer->indexCapacity = capacity;
+    }
+
+    writer->index[writer->indexCount++] = (ReplayIndexEntry){ encoder->chunk.firstTick, ftell(writer->file) };
+
+    // Whole chunks only, so a session cut short still replays up to its last keyframe interval
+    if (encoder->failed || fwrite(&encoder->chunk, sizeof(ReplayChunk), 1, writer->file) != 1 ||
+        fwrite(encoder->buffer, 1, encoder->size, writer->file) != encoder->size ||
+        fwrite(encoder->hashes, 1, encoder->hashSize, writer->file) != encoder->hashSize || fflush(writer->file) != 0) {
+        writer->failed = true;
+    }
+
+    encoder->chunk.magic = 0;
+}
+
+bool StartReplay(ReplayWriter *writer, const char *path, int keyframeTicks) {
+    memset(writer, 0, sizeof(ReplayWriter));
+    writer->keyframeTicks = keyframeTicks > 0 ? keyframeTicks : REPLAY_KEYFRAME_SECONDS * TICK_RATE;
+    writer->file = fopen(path, "wb");
+
+    ReplayHeader header = { REPLAY_MAGIC, REPLAY_VERSION, TICK_RATE, writer->keyframeTicks };
+
+    if (writer->file == NULL || fwrite(&header, sizeof(header), 1, writer->file) != 1) {
+        TraceLog(LOG_WARNING, "REPLAY: [%s] Failed to open for writing", path);
+
+        if (writer->file != NULL) {
+            fclose(writer->file);
+            writer->file = NULL;
+        }
+
+        return false;
+    }
+
+    return true;
+}
+
+void RecordReplayTick(ReplayWriter *writer, const Game *game, const GameInput *input) {
+    if (writer->file == NULL || writer->failed) {
+        return;
+    }
+
+    if (writer->encoder.chunk.magic != 0 && writer->encoder.chunk.tickCount == writer->keyframeTicks) {
+        FlushReplayChunk(writer);
+    }
+
+    if (writer->encoder.chunk.magic == 0) {
+        OpenReplayChunk(&writer->encoder, game);
+    }
+
+    AppendReplayTick(&writer->encoder, game, input);
+    writer->failed = writer->encoder.failed;
+}
+
+bool FinishReplay(ReplayWriter *writer) {
+    if (writer->file == NULL) {
+        return false;
+    }
+
+    FlushReplayChunk(writer);
+
+    ReplayFooter footer = { REPLAY_FOOTER_MAGIC, writer->indexCount, ftell(writer->file) };
+
+    if (fwrite(writer->index, sizeof(ReplayIndexEntry), writer->indexCount, writer->file) != (size_t)writer->indexCount ||
+        fwrite(&footer, sizeof(footer), 1, writer->file) != 1) {
+        writer->failed = true;
+    }
+
+    if (fclose(writer->file) != 0 || writer->failed) {
+        TraceLog(LOG_WARNING, "REPLAY: Failed to write the recording");
+        writer->failed = true;
+    } else {
+        TraceLog(LOG_INFO, "REPLAY: Recorded %d keyframes", writer->indexCount);
+    }
+
+    bool ok = !writer->failed;
+    free(writer->encoder.buffer);
+    free(writer->encoder.hashes);
+    free(writer->index);
+    memset(writer, 0, sizeof(ReplayWriter));
+
+    return ok;
+}
+
+// Walks the chunk headers of a recording that never got its footer
+static bool RebuildReplayIndex(ReplayReader *reader, long fileSize) {
+    long offset = sizeof(ReplayHeader);
+    int capacity = 0;
+    ReplayChunk chunk;
+
+    while (offset + (long)sizeof(ReplayChunk) <= fileSize) {
+        if (fseek(reader->file, offset, SEEK_SET) != 0 || fread(&chunk, sizeof(chunk), 1, reader->file) != 1 ||
+            chunk.magic != REPLAY_CHUNK_MAGIC || offset + (long)sizeof(chunk) + chunk.stateSize + chunk.inputSize + chunk.hashSize > fileSize) {
+            break;
+        }
+
+        if (reader->chunkCount == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            ReplayIndexEntry *index = realloc(reader->index, capacity * sizeof(ReplayIndexEntry));
+
+            if (index == NULL) {
+                return false;
+            }
+
+            reader->index = index;
+        }
+
+        reader->index[reader->chunkCount++] = (ReplayIndexEntry){ chunk.firstTick, offset };
+        offset += sizeof(chunk) + chunk.stateSize + chunk.inputSize + chunk.hashSize;
+    }
+
+    TraceLog(LOG_WARNING, "REPLAY: No index footer, recovered %d keyframes", reader->chunkCount);
+
+    return reader->chunkCount > 0;
+}
+
+static bool LoadReplayChunk(ReplayReader *reader, int chunkIndex) {
+    ReplayChunk *chunk = &reader->chunk;
+    size_t size = 0;
+
+    if (fseek(reader->file, reader->index[chunkIndex].offset, SEEK_SET) != 0 ||
+        fread(chunk, sizeof(ReplayChunk), 1, reader->file) != 1 || chunk->magic != REPLAY_CHUNK_MAGIC ||
+        !ReserveBytes(&reader->buffer, &reader->capacity, size = (size_t)chunk->stateSize + chunk->inputSize + chunk->hashSize) ||
+        fread(reader->buffer, 1, size, reader->file) != size) {
+        TraceLog(LOG_WARNING, "REPLAY: Chunk %d is damaged", chunkIndex);
+        return false;
+    }
+
+    reader->chunkIndex = chunkIndex;
+    reader->cursor = chunk->stateSize;
+    reader->ticksLeft = chunk->tickCount;
+    reader->repeat = 0;
+    reader->runRead = false;
+    reader->previous = (GameInput){ 0 };
+    reader->hashCursor = (size_t)chunk->stateSize + chunk->inputSize;
+    reader->expected = (StateHash){ 0 };
+
+    return true;
+}
+
+bool OpenReplay(ReplayReader *reader, const char *path) {
+    ReplayFooter footer = { 0 };
+
+    memset(reader, 0, sizeof(ReplayReader));
+    reader->chunkIndex = -1;
+    reader->file = fopen(path, "rb");
+
+    if (reader->file == NULL || fread(&reader->header, sizeof(ReplayHeader), 1, reader->file) != 1 ||
+        reader->header.magic != REPLAY_MAGIC || reader->header.version != REPLAY_VERSION || reader->header.tickRate != TICK_RATE ||
+        reader->header.keyframeTicks == 0) {
+        TraceLog(LOG_WARNING, "REPLAY: [%s] Not a valid version %d recording at %d ticks per second", path, REPLAY_VERSION, TICK_RATE);
+        CloseReplay(reader);
+        return false;
+    }
+
+    fseek(reader->file, 0, SEEK_END);
+    long fileSize = ftell(reader->file);
+    bool indexed = fileSize >= (long)(sizeof(ReplayHeader) + sizeof(ReplayFooter)) &&
+        fseek(reader->file, fileSize - sizeof(ReplayFooter), SEEK_SET) == 0 &&
+        fread(&footer, sizeof(footer), 1, reader->file) == 1 && footer.magic == REPLAY_FOOTER_MAGIC && footer.chunkCount > 0 &&
+        footer.indexOffset + (unsigned long long)footer.chunkCount * sizeof(ReplayIndexEntry) + sizeof(footer) == (unsigned long long)fileSize;
+
+    if (indexed) {
+        reader->index = malloc(footer.chunkCount * sizeof(ReplayIndexEntry));
+        reader->chunkCount = footer.chunkCount;
+        indexed = reader->index != NULL && fseek(reader->file, footer.indexOffset, SEEK_SET) == 0 &&
+            fread(reader->index, sizeof(ReplayIndexEntry), footer.chunkCount, reader->file) == footer.chunkCount;
+    }
+
+    if (!indexed) {
+        free(reader->index);
+        reader->index = NULL;
+        reader->chunkCount = 0;
+
+        if (!RebuildReplayIndex(reader, fileSize)) {
+            TraceLog(LOG_WARNING, "REPLAY: [%s] Holds no complete chunk", path);
+            CloseReplay(reader);
+            return false;
+        }
+    }
+
+    if (!LoadReplayChunk(reader, reader->chunkCount - 1)) {
+        CloseReplay(reader);
+        return false;
+    }
+
+    reader->endTick = reader->chunk.firstTick + reader->chunk.tickCount;
+    reader->chunkIndex = -1;
+
+    return true;
+}
+
+static bool ReadVarint(ReplayReader *reader, unsigned int *value) {
+    size_t end = reader->chunk.stateSize + reader->chunk.inputSize;
+
+    *value = 0;
+
+    for (int shift = 0; shift < 35 && reader->cursor < end; shift += 7) {
+        unsigned char byte = reader->buffer[reader->cursor++];
+        *value |= (unsigned int)(byte & 0x7F) << shift;
+
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static bool ReadReplayBytes(ReplayReader *reader, void *data, size_t size) {
+    if (reader->cursor + size > reader->chunk.stateSize + reader->chunk.inputSize) {
+        return false;
+    }
+
+    memcpy(data, reader->buffer + reader->cursor, size);
+    reader->cursor += size;
+
+    return true;
+}
+
+static bool ReadReplayHash(ReplayReader *reader) {
+    size_t end = reader->hashCursor + 1;
+    size_t limit = (size_t)reader->chunk.stateSize + reader->chunk.inputSize + reader->chunk.hashSize;
+
+    if (end > limit) {
+        return false;
+    }
+
+    unsigned char mask = reader->buffer[reader->hashCursor];
+
+    for (int p = 0; p < HASH_PART_COUNT; p++) {
+        unsigned int low;
+
+        if (!(mask & (1 << p))) {
+            continue;
+        }
+
+        if (end + sizeof(low) > limit) {
+            return false;
+        }
+
+        memcpy(&low, reader->buffer + end, sizeof(low));
+        reader->expected.parts[p] = low;
+        end += sizeof(low);
+    }
+
+    reader->hashCursor = end;
+
+    return true;
+}
+
+// Compares the state the next tick starts from with the recording; the first divergence is logged with its parts
+bool CheckReplayHash(ReplayReader *reader, const Game *game) {
+    char parts[64] = "";
+
+    for (int p = 0; p < HASH_PART_COUNT; p++) {
+        if ((unsigned int)game->hash.parts[p] != (unsigned int)reader->expected.parts[p]) {
+            snprintf(parts + strlen(parts), sizeof(parts) - strlen(parts), "%s%s", parts[0] ? ", " : "", GetHashPartName(p));
+        }
+    }
+
+    if (parts[0] == '\0') {
+        return true;
+    }
+
+    if (!reader->diverged) {
+        reader->diverged = true;
+        TraceLog(LOG_WARNING, "REPLAY: State diverged from the recording at tick %llu in %s", game->tick, parts);
+    }
+
+    return false;
+}
+
+// Input for the tick after the last one returned, crossing into the next chunk without loading its keyframe
+bool NextReplayInput(ReplayReader *reader, GameInput *input) {
+    if (reader->chunkIndex < 0 || (reader->ticksLeft == 0 &&
+        (reader->chunkIndex + 1 >= reader->chunkCount || !LoadReplayChunk(reader, reader->chunkIndex + 1)))) {
+        return false;
+    }
+
+    if (!ReadReplayHash(reader)) {
+        return false;
+    }
+
+    if (!reader->runRead) {
+        if (!ReadVarint(reader, &reader->repeat)) {
+            return false;
+        }
+
+        reader->runRead = true;
+    }
+
+    unsigned long long tick = reader->chunk.firstTick + reader->chunk.tickCount - reader->ticksLeft + 1;
+    reader->ticksLeft--;
+
+    if (reader->repeat > 0) {
+        reader->repeat--;
+        *input = (GameInput){ .buttons = reader->previous.buttons, .sequence = tick };
+        return true;
+    }
+
+    unsigned int changed = 0;
+    unsigned int eventCount = 0;
+    GameInput next = { 0 };
+
+    if (!ReadVarint(reader, &changed) || !ReadVarint(reader, &eventCount) || eventCount > GAME_INPUT_MAX_EVENTS) {
+        return false;
+    }
+
+    next.buttons = reader->previous.buttons ^ changed;
+    next.sequence = tick;
+    next.eventCount = eventCount;
+
+    if ((next.buttons & INPUT_SPAWN_FLOCK) && !ReadReplayBytes(reader, &next.spawnPosition, sizeof(Vector2))) {
+        return false;
+    }
+
+    for (int i = 0; i < next.eventCount; i++) {
+        unsigned char down = 0;
+
+        if (!ReadReplayBytes(reader, &next.events[i].offset, sizeof(float)) ||
+            !ReadVarint(reader, &next.events[i].button) || !ReadReplayBytes(reader, &down, 1)) {
+            return false;
+        }
+
+        next.events[i].down = down;
+    }
+
+    reader->previous = next;
+    reader->runRead = false;
+    *input = next;
+
+    return true;
+}
+
+// Restores the keyframe at or before tick and re-simulates the rest; the game must come from InitGame and not be recording
+bool SeekReplay(ReplayReader *reader, Game *game, unsigned long long tick) {
+    if (tick < reader->index[0].tick || tick > reader->endTick) {
+        return false;
+    }
+
+    // Keyframes are evenly spaced, so the chunk is found directly; the search only runs on irregular files
+    int chunkIndex = (tick - reader->index[0].tick) / reader->header.keyframeTicks;
+
+    if (chunkIndex >= reader->chunkCount) {
+        chunkIndex = reader->chunkCount - 1;
+    }
+
+    if (reader->index[chunkIndex].tick > tick || (chunkIndex + 1 < reader->chunkCount && reader->index[chunkIndex + 1].tick <= tick)) {
+        int low = 0;
+        int high = reader->chunkCount - 1;
+
+        while (low < high) {
+            int middle = (low + high + 1) / 2;
+
+            if (reader->index[middle].tick <= tick) {
+                low = middle;
+            } else {
+                high = middle - 1;
+            }
+        }
+
+        chunkIndex = low;
+    }
+
+    if (!LoadReplayChunk(reader, chunkIndex)) {
+        return false;
+    }
+
+    StateReader state = { reader->buffer, reader->chunk.stateSize, 0, false };
+
+    if (!LoadGameState(game, &state)) {
+        TraceLog(LOG_WARNING, "REPLAY: Keyframe at tick %llu does not match this build's game state", reader->chunk.firstTick);
+        return false;
+    }
+
+    GameInput input;
+
+    while (game->tick < tick && NextReplayInput(reader, &input)) {
+        CheckReplayHash(reader, game);
+        UpdateGame(game, input);
+    }
+
+    return game->tick == tick;
+}
+
+void CloseReplay(ReplayReader *reader) {
+    if (reader->file != NULL) {
+        fclose(reader->file);
+    }
+
+    free(reader->index);
+    free(reader->buffer);
+    memset(reader, 0, sizeof(ReplayReader));
+}
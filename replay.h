@@ -0,0 +1,107 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdbool.h>
+#include <stdio.h>
+#include "game.h"
+
+#define REPLAY_MAGIC 0x50524953 // "SIRP"
+#define REPLAY_CHUNK_MAGIC 0x4B4E4843 // "CHNK"
+#define REPLAY_FOOTER_MAGIC 0x58444E49 // "INDX"
+// Keyframes hold simulation state, so fixed point and float builds cannot read each other's recordings
+#ifdef FIXED_POINT
+#define REPLAY_VERSION (3 | 0x100)
+#else
+#define REPLAY_VERSION 3
+#endif
+#define REPLAY_KEYFRAME_SECONDS 5
+
+// File layout: header, chunks, index, footer. Each chunk is a keyframe followed by the inputs of the
+// ticks that start from it and the state hash each of those ticks started from, so any chunk decodes on its own
+typedef struct ReplayHeader {
+    unsigned int magic;
+    unsigned int version;
+    unsigned int tickRate;
+    unsigned int keyframeTicks;
+} ReplayHeader;
+
+typedef struct ReplayChunk {
+    unsigned int magic;
+    unsigned int tickCount;
+    unsigned long long firstTick; // game tick of the keyframe; the first input is for firstTick + 1
+    unsigned int stateSize;
+    unsigned int inputSize;
+    unsigned int hashSize; // per tick: a mask of changed parts, then the low 32 bits of each changed one
+} ReplayChunk;
+
+typedef struct ReplayIndexEntry {
+    unsigned long long tick;
+    unsigned long long offset;
+} ReplayIndexEntry;
+
+// Last bytes of the file; a recording cut short has none and its index is rebuilt by walking the chunks
+typedef struct ReplayFooter {
+    unsigned int magic;
+    unsigned int chunkCount;
+    unsigned long long indexOffset;
+} ReplayFooter;
+
+// A chunk being encoded in memory; chunk.magic is 0 while none is open
+typedef struct ReplayChunkEncoder {
+    ReplayChunk chunk;
+    unsigned char *buffer; // keyframe then inputs
+    size_t size;
+    size_t capacity;
+    GameInput previous;
+    unsigned int repeat;
+    unsigned char *hashes;
+    size_t hashSize;
+    size_t hashCapacity;
+    StateHash previousHash;
+    bool fixed; // the buffers never grow; a chunk that outgrows them fails instead
+    bool failed;
+} ReplayChunkEncoder;
+
+typedef struct ReplayWriter {
+    FILE *file;
+    unsigned int keyframeTicks;
+    ReplayChunkEncoder encoder;
+    ReplayIndexEntry *index;
+    int indexCount;
+    int indexCapacity;
+    bool failed;
+} ReplayWriter;
+
+typedef struct ReplayReader {
+    FILE *file;
+    ReplayHeader header;
+    ReplayIndexEntry *index;
+    int chunkCount;
+    unsigned long long endTick;
+    int chunkIndex; // chunk the input cursor is in, -1 before the first read
+    ReplayChunk chunk;
+    unsigned char *buffer;
+    size_t capacity;
+    size_t cursor;
+    unsigned int ticksLeft;
+    unsigned int repeat;
+    bool runRead; // the run length before the next change record has been read
+    GameInput previous;
+    size_t hashCursor;
+    StateHash expected; // hash the next tick must start from, low 32 bits per part
+    bool diverged;
+} ReplayReader;
+
+void OpenReplayChunk(ReplayChunkEncoder *encoder, const Game *game);
+void AppendReplayTick(ReplayChunkEncoder *encoder, const Game *game, const GameInput *input);
+void CloseReplayChunk(ReplayChunkEncoder *encoder);
+bool StartReplay(ReplayWriter *writer, const char *path, int keyframeTicks);
+void RecordReplayTick(ReplayWriter *writer, const Game *game, const GameInput *input);
+bool FinishReplay(ReplayWriter *writer);
+bool OpenReplay(ReplayReader *reader, const char *path);
+bool SeekReplay(ReplayReader *reader, Game *game, unsigned long long tick);
+bool NextReplayInput(ReplayReader *reader, GameInput *input);
+bool CheckReplayHash(ReplayReader *reader, const Game *game);
+void CloseReplay(ReplayReader *reader);
+
+#endif
@@ -0,0 +1,265 @@
+#include <stdlib.h>
+#include <string.h>
+#include "raylib.h"
+#include "profiler.h"
+#include "rewind.h"
+
+bool InitRewind(RewindBuffer *rewind, size_t budget, int seconds) {
+    memset(rewind, 0, sizeof(RewindBuffer));
+    rewind->budget = budget;
+    rewind->capacity = seconds * TICK_RATE;
+    rewind->data = malloc(budget);
+    rewind->records = malloc(rewind->capacity * sizeof(RewindRecord));
+
+    if (rewind->data == NULL || rewind->records == NULL) {
+        TraceLog(LOG_WARNING, "REWIND: Failed to allocate %zu bytes", budget);
+        UnloadRewind(rewind);
+        return false;
+    }
+
+    TraceLog(LOG_INFO, "REWIND: %d seconds in %zu MB, hold backspace to rewind", seconds, budget / (1024 * 1024));
+
+    return true;
+}
+
+void UnloadRewind(RewindBuffer *rewind) {
+    free(rewind->data);
+    free(rewind->records);
+    free(rewind->current);
+    free(rewind->next);
+    free(rewind->encoded);
+    memset(rewind, 0, sizeof(RewindBuffer));
+}
+
+// Both state buffers stay zero padded to the same capacity, so states of different sizes XOR cleanly
+static bool ReserveStates(RewindBuffer *rewind, size_t size) {
+    if (size <= rewind->stateCapacity) {
+        return true;
+    }
+
+    size_t capacity = size * 2;
+    unsigned char *current = calloc(capacity, 1);
+    unsigned char *next = calloc(capacity, 1);
+    unsigned char *encoded = malloc(capacity * 2 + 16);
+
+    if (current == NULL || next == NULL || encoded == NULL) {
+        free(current);
+        free(next);
+        free(encoded);
+        return false;
+    }
+
+    if (rewind->current != NULL) {
+        memcpy(current, rewind->current, rewind->currentSize);
+    }
+
+    free(rewind->current);
+    free(rewind->next);
+    free(rewind->encoded);
+    rewind->current = current;
+    rewind->next = next;
+    rewind->encoded = encoded;
+    rewind->stateCapacity = capacity;
+
+    return true;
+}
+
+static size_t PutVarint(unsigned char *to, size_t value) {
+    size_t count = 0;
+
+    do {
+        to[count] = (value & 0x7F) | (value >= 0x80 ? 0x80 : 0);
+        value >>= 7;
+        count++;
+    } while (value);
+
+    return count;
+}
+
+static size_t GetVarint(const unsigned char *from, size_t *value) {
+    size_t count = 0;
+
+    *value = 0;
+
+    do {
+        *value |= (size_t)(from[count] & 0x7F) << (7 * count);
+    } while (from[count++] & 0x80);
+
+    return count;
+}
+
+// XOR of the two states as (zero run, literal length, literal bytes) triples; unchanged fields become zero runs
+static size_t EncodeDelta(const unsigned char *from, const unsigned char *to, size_t size, unsigned char *out) {
+    size_t written = 0;
+    size_t i = 0;
+
+    while (i < size) {
+        size_t zeros = 0;
+
+        while (i + zeros < size && from[i + zeros] == to[i + zeros]) {
+            zeros++;
+        }
+
+        // Trailing zeros need no triple; the decoder stops at the end of the record
+        i += zeros;
+        if (i == size) {
+            break;
+        }
+
+        size_t start = i;
+
+        // The literal swallows zero runs too short to be worth their own triple
+        while (i < size) {
+            size_t run = 0;
+
+            while (i + run < size && run < REWIND_MIN_ZERO_RUN && from[i + run] == to[i + run]) {
+                run++;
+            }
+
+            if (run == REWIND_MIN_ZERO_RUN || i + run == size) {
+                break;
+            }
+
+            i += run + 1;
+        }
+
+        written += PutVarint(out + written, zeros);
+        written += PutVarint(out + written, i - start);
+
+        for (size_t b = start; b < i; b++) {
+            out[written++] = from[b] ^ to[b];
+        }
+    }
+
+    return written;
+}
+
+static void ApplyDelta(unsigned char *state, const unsigned char *delta, size_t size) {
+    size_t read = 0;
+    size_t i = 0;
+
+    while (read < size) {
+        size_t zeros;
+        size_t literal;
+
+        read += GetVarint(delta + read, &zeros);
+        read += GetVarint(delta + read, &literal);
+        i += zeros;
+
+        for (size_t b = 0; b < literal; b++) {
+            state[i++] ^= delta[read++];
+        }
+    }
+}
+
+static void DropOldestRecord(RewindBuffer *rewind) {
+    rewind->first = (rewind->first + 1) % rewind->capacity;
+    rewind->count--;
+}
+
+// Places size bytes after the newest record, wrapping to the start and dropping the oldest records in the way
+static size_t AllocateRecord(RewindBuffer *rewind, size_t size) {
+    size_t place = rewind->head;
+
+    if (rewind->count == rewind->capacity) {
+        DropOldestRecord(rewind);
+    }
+
+    if (place + size > rewind->budget) {
+        // Records past the head are older than any at the start, so they go first
+        while (rewind->count > 0 && rewind->records[rewind->first].offset >= rewind->head) {
+            DropOldestRecord(rewind);
+        }
+
+        place = 0;
+    }
+
+    while (rewind->count > 0) {
+        const RewindRecord *oldest = &rewind->records[rewind->first];
+
+        if (oldest->offset >= place + size || oldest->offset + oldest->size <= place) {
+            break;
+        }
+
+        DropOldestRecord(rewind);
+    }
+
+    return place;
+}
+
+// Called after every played tick; the first call only takes the baseline state
+void RecordRewindTick(RewindBuffer *rewind, const Game *game) {
+    StateWriter writer = { NULL, 0, 0 };
+
+    rewind->heldTicks = 0;
+    SaveGameState(game, &writer);
+
+    if (!ReserveStates(rewind, writer.size)) {
+        return;
+    }
+
+    size_t previousSize = rewind->currentSize;
+    size_t size = writer.size > previousSize ? writer.size : previousSize;
+
+    writer = (StateWriter){ rewind->next, rewind->stateCapacity, 0 };
+    SaveGameState(game, &writer);
+    memset(rewind->next + writer.size, 0, rewind->stateCapacity - writer.size);
+
+    if (previousSize > 0) {
+        size_t encodedSize = EncodeDelta(rewind->current, rewind->next, size, rewind->encoded);
+
+        if (encodedSize <= rewind->budget) {
+            size_t offset = AllocateRecord(rewind, encodedSize);
+            int slot = (rewind->first + rewind->count) % rewind->capacity;
+
+            memcpy(rewind->data + offset, rewind->encoded, encodedSize);
+            rewind->records[slot] = (RewindRecord){ offset, encodedSize, previousSize };
+            rewind->count++;
+            rewind->head = offset + encodedSize;
+            ProfilerRecord("rewind bytes/tick", "%.0f", encodedSize);
+        }
+    }
+
+    unsigned char *swap = rewind->current;
+    rewind->current = rewind->next;
+    rewind->next = swap;
+    rewind->currentSize = writer.size;
+    ProfilerSetCounter("rewind seconds", "%.1f", (double)rewind->count / TICK_RATE);
+}
+
+// Undoes 1 to REWIND_MAX_SPEED ticks; returns false once the oldest kept state is reached
+bool RewindGame(RewindBuffer *rewind, Game *game) {
+    int speed = 1;
+    int steps = 0;
+
+    for (int held = rewind->heldTicks; held >= TICK_RATE && speed < REWIND_MAX_SPEED; held -= TICK_RATE) {
+        speed *= 2;
+    }
+
+    rewind->heldTicks++;
+
+    for (; steps < speed && rewind->count > 0; steps++) {
+        int slot = (rewind->first + rewind->count - 1) % rewind->capacity;
+        const RewindRecord *record = &rewind->records[slot];
+        size_t size = record->previousSize > rewind->currentSize ? record->previousSize : rewind->currentSize;
+
+        ApplyDelta(rewind->current, rewind->data + record->offset, record->size);
+        memset(rewind->current + record->previousSize, 0, size - record->previousSize);
+        rewind->currentSize = record->previousSize;
+        rewind->head = record->offset;
+        rewind->count--;
+    }
+
+    if (steps > 0) {
+        StateReader reader = { rewind->current, rewind->currentSize, 0, false };
+
+        if (!LoadGameState(game, &reader)) {
+            TraceLog(LOG_WARNING, "REWIND: Failed to restore tick %llu", game->tick);
+        }
+    }
+
+    ProfilerSetCounter("rewind seconds", "%.1f", (double)rewind->count / TICK_RATE);
+    ProfilerSetCounter("rewind speed", "%.0f", speed);
+
+    return steps > 0;
+}
@@ -0,0 +1,42 @@
+#ifndef REWIND_H
+#define REWIND_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "game.h"
+
+#define REWIND_BUDGET (16 * 1024 * 1024) // bytes of encoded deltas
+#define REWIND_SECONDS 30
+#define REWIND_MAX_SPEED 8 // ticks undone per tick; the speed doubles for every second the key is held
+#define REWIND_MIN_ZERO_RUN 4 // shorter zero runs cost more to split out than to copy
+
+// One tick's delta in the ring; XOR is its own inverse, so applying it to a state gives the one before
+typedef struct RewindRecord {
+    size_t offset;
+    size_t size;
+    size_t previousSize; // size of the state the delta leads back to
+} RewindRecord;
+
+// Deltas newest last in a byte ring; when the budget or the time window runs out the oldest are dropped
+typedef struct RewindBuffer {
+    unsigned char *data;
+    size_t budget;
+    size_t head; // end of the newest record
+    RewindRecord *records;
+    int first;
+    int count;
+    int capacity;
+    unsigned char *current; // latest state, zero padded to stateCapacity
+    unsigned char *next;
+    unsigned char *encoded;
+    size_t currentSize;
+    size_t stateCapacity;
+    int heldTicks;
+} RewindBuffer;
+
+bool InitRewind(RewindBuffer *rewind, size_t budget, int seconds);
+void UnloadRewind(RewindBuffer *rewind);
+void RecordRewindTick(RewindBuffer *rewind, const Game *game);
+bool RewindGame(RewindBuffer *rewind, Game *game);
+
+#endif
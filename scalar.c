@@ -0,0 +1,55 @@
+#include <stdlib.h>
+#include "raylib.h"
+#include "raymath.h"
+#include "scalar.h"
+
+#ifdef FIXED_POINT
+
+// Bit by bit, two bits of the square per step; exact, so every build agrees on the result
+static unsigned long long SquareRoot(unsigned long long value) {
+    unsigned long long root = 0;
+
+    if (value == 0) {
+        return 0;
+    }
+
+    for (unsigned long long bit = 1ull << ((63 - __builtin_clzll(value)) & ~1); bit != 0; bit >>= 2) {
+        if (value >= root + bit) {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+    }
+
+    return root;
+}
+
+// The squared 16.16 distance is 32.32, so its integer root is 16.16 again. Marches move along one axis at a
+// time, so the root is rarely needed
+Scalar ScalarDistance(ScalarVector2 a, ScalarVector2 b) {
+    long long dx = (long long)a.x - b.x;
+    long long dy = (long long)a.y - b.y;
+
+    if (dx == 0 || dy == 0) {
+        return (Scalar)llabs(dx + dy);
+    }
+
+    return (Scalar)SquareRoot((unsigned long long)(dx * dx) + (unsigned long long)(dy * dy));
+}
+
+#else
+
+Scalar ScalarDistance(ScalarVector2 a, ScalarVector2 b) {
+    return Vector2Distance((Vector2){ a.x, a.y }, (Vector2){ b.x, b.y });
+}
+
+#endif
+
+Vector2 ScalarVector2ToFloat(ScalarVector2 vector) {
+    return (Vector2){ SCALAR_TO_FLOAT(vector.x), SCALAR_TO_FLOAT(vector.y) };
+}
+
+Rectangle ScalarRectangleToFloat(ScalarRectangle rectangle) {
+    return (Rectangle){ SCALAR_TO_FLOAT(rectangle.x), SCALAR_TO_FLOAT(rectangle.y), SCALAR_TO_FLOAT(rectangle.width), SCALAR_TO_FLOAT(rectangle.height) };
+}
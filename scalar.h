@@ -0,0 +1,48 @@
+#ifndef SCALAR_H
+#define SCALAR_H
+
+#include "raylib.h"
+
+// The simulation's number type. Built with FIXED_POINT it is 16.16 fixed point, so a tick gives the same bits
+// whatever the compiler flags or CPU; otherwise it is float. Floats only cross over at the render boundary
+#ifdef FIXED_POINT
+
+typedef int Scalar;
+
+#define SCALAR_ONE 65536
+#define SCALAR(value) ((Scalar)((value) * SCALAR_ONE)) // compile time constants only
+#define SCALAR_MUL(a, b) ((Scalar)(((long long)(a) * (b)) >> 16))
+#define SCALAR_PER_TICK(speed) ((speed) / TICK_RATE)
+// Scaling by a power of two is exact and truncation has one answer, so input floats convert the same everywhere
+#define SCALAR_FROM_FLOAT(value) ((Scalar)((value) * (float)SCALAR_ONE))
+#define SCALAR_TO_FLOAT(value) ((float)(value) / SCALAR_ONE)
+
+#else
+
+typedef float Scalar;
+
+#define SCALAR(value) ((float)(value))
+#define SCALAR_MUL(a, b) ((a) * (b))
+#define SCALAR_PER_TICK(speed) ((speed) * (float)TICK_TIME)
+#define SCALAR_FROM_FLOAT(value) (value)
+#define SCALAR_TO_FLOAT(value) (value)
+
+#endif
+
+typedef struct ScalarVector2 {
+    Scalar x;
+    Scalar y;
+} ScalarVector2;
+
+typedef struct ScalarRectangle {
+    Scalar x;
+    Scalar y;
+    Scalar width;
+    Scalar height;
+} ScalarRectangle;
+
+Scalar ScalarDistance(ScalarVector2 a, ScalarVector2 b);
+Vector2 ScalarVector2ToFloat(ScalarVector2 vector);
+Rectangle ScalarRectangleToFloat(ScalarRectangle rectangle);
+
+#endif
@@ -0,0 +1,231 @@
+#include <string.h>
+#include <unistd.h>
+#include "raylib.h"
+#include "flightrecorder.h"
+#include "profiler.h"
+#include "scheduler.h"
+
+static void RunStage(FrameGraph *graph, int index) {
+    FrameStage *stage = &graph->stages[index];
+    stage->startTime = GetMonotonicTime();
+    stage->run(graph->context);
+    stage->endTime = GetMonotonicTime();
+}
+
+static int PopReadyStage(FrameGraph *graph) {
+    return graph->readyCount > 0 ? graph->ready[--graph->readyCount] : -1;
+}
+
+static void CompleteStage(FrameGraph *graph, int index) {
+    FrameStage *stage = &graph->stages[index];
+
+    for (int i = 0; i < stage->dependentCount; i++) {
+        FrameStage *dependent = &graph->stages[stage->dependents[i]];
+
+        if (--dependent->pending == 0) {
+            graph->ready[graph->readyCount++] = stage->dependents[i];
+        }
+    }
+
+    graph->remaining--;
+}
+
+static void *WorkerMain(void *argument) {
+    ThreadPool *pool = argument;
+
+    InstallCrashStack();
+    pthread_mutex_lock(&pool->lock);
+
+    while (!pool->quit) {
+        int index = pool->graph != NULL ? PopReadyStage(pool->graph) : -1;
+
+        if (index < 0) {
+            pthread_cond_wait(&pool->wake, &pool->lock);
+            continue;
+        }
+
+        FrameGraph *graph = pool->graph;
+        pthread_mutex_unlock(&pool->lock);
+        RunStage(graph, index);
+        pthread_mutex_lock(&pool->lock);
+        CompleteStage(graph, index);
+        pthread_cond_broadcast(&pool->wake);
+    }
+
+    pthread_mutex_unlock(&pool->lock);
+    RemoveCrashStack();
+
+    return NULL;
+}
+
+void InitThreadPool(ThreadPool *pool, int workerCount) {
+    memset(pool, 0, sizeof(ThreadPool));
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+
+    if (workerCount > THREAD_POOL_MAX_WORKERS) {
+        workerCount = THREAD_POOL_MAX_WORKERS;
+    }
+
+    for (int i = 0; i < workerCount; i++) {
+        if (pthread_create(&pool->workers[pool->workerCount], NULL, WorkerMain, pool) != 0) {
+            TraceLog(LOG_WARNING, "SCHEDULER: Failed to start worker %d, continuing with %d", i, pool->workerCount);
+            break;
+        }
+
+        pool->workerCount++;
+    }
+
+    TraceLog(LOG_INFO, "SCHEDULER: Thread pool started with %d workers", pool->workerCount);
+}
+
+void UnloadThreadPool(ThreadPool *pool) {
+    pthread_mutex_lock(&pool->lock);
+    pool->quit = true;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < pool->workerCount; i++) {
+        pthread_join(pool->workers[i], NULL);
+    }
+
+    pthread_cond_destroy(&pool->wake);
+    pthread_mutex_destroy(&pool->lock);
+}
+
+int GetDefaultWorkerCount(void) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return cores > 1 ? (int)cores - 1 : 0;
+}
+
+void BeginFrameGraph(FrameGraph *graph, void *context) {
+    graph->stageCount = 0;
+    graph->context = context;
+}
+
+int AddFrameStage(FrameGraph *graph, const char *name, ResourceMask reads, ResourceMask writes, StageFunc run) {
+    if (graph->stageCount >= FRAME_GRAPH_MAX_STAGES) {
+        TraceLog(LOG_FATAL, "SCHEDULER: Too many stages (max %d)", FRAME_GRAPH_MAX_STAGES);
+    }
+
+    int index = graph->stageCount++;
+    FrameStage *stage = &graph->stages[index];
+    stage->name = name;
+    stage->reads = reads;
+    stage->writes = writes;
+    stage->run = run;
+    stage->dependentCount = 0;
+    stage->dependencyCount = 0;
+
+    // An earlier stage must finish first if either side writes something the other touches
+    for (int i = 0; i < index; i++) {
+        FrameStage *earlier = &graph->stages[i];
+
+        if ((earlier->writes & (reads | writes)) || (earlier->reads & writes)) {
+            earlier->dependents[earlier->dependentCount++] = index;
+            stage->dependencyCount++;
+        }
+    }
+
+    return index;
+}
+
+static void FindCriticalPath(FrameGraph *graph) {
+    for (int i = 0; i < graph->stageCount; i++) {
+        FrameStage *stage = &graph->stages[i];
+        stage->pathTime = stage->endTime - stage->startTime;
+        stage->criticalParent = -1;
+    }
+
+    // Declaration order is a topological order, so every parent is final before its children
+    int last = -1;
+
+    for (int i = 0; i < graph->stageCount; i++) {
+        FrameStage *stage = &graph->stages[i];
+
+        for (int d = 0; d < stage->dependentCount; d++) {
+            FrameStage *dependent = &graph->stages[stage->dependents[d]];
+            double pathTime = stage->pathTime + (dependent->endTime - dependent->startTime);
+
+            if (pathTime > dependent->pathTime) {
+                dependent->pathTime = pathTime;
+                dependent->criticalParent = i;
+            }
+        }
+
+        if (last < 0 || stage->pathTime > graph->stages[last].pathTime) {
+            last = i;
+        }
+    }
+
+    graph->criticalPathLength = 0;
+    graph->criticalTime = last >= 0 ? graph->stages[last].pathTime : 0;
+
+    for (int i = last; i >= 0; i = graph->stages[i].criticalParent) {
+        graph->criticalPath[graph->criticalPathLength++] = i;
+    }
+}
+
+// Runs the graph to completion; the calling thread works through ready stages alongside the pool
+void RunFrameGraph(FrameGraph *graph, ThreadPool *pool) {
+    double startTime = GetMonotonicTime();
+
+    if (pool == NULL || pool->workerCount == 0) {
+        for (int i = 0; i < graph->stageCount; i++) {
+            RunStage(graph, i);
+        }
+    } else {
+        pthread_mutex_lock(&pool->lock);
+
+        graph->readyCount = 0;
+        graph->remaining = graph->stageCount;
+
+        for (int i = 0; i < graph->stageCount; i++) {
+            graph->stages[i].pending = graph->stages[i].dependencyCount;
+
+            if (graph->stages[i].pending == 0) {
+                graph->ready[graph->readyCount++] = i;
+            }
+        }
+
+        pool->graph = graph;
+        pthread_cond_broadcast(&pool->wake);
+
+        while (graph->remaining > 0) {
+            int index = PopReadyStage(graph);
+
+            if (index < 0) {
+                pthread_cond_wait(&pool->wake, &pool->lock);
+                continue;
+            }
+
+            pthread_mutex_unlock(&pool->lock);
+            RunStage(graph, index);
+            pthread_mutex_lock(&pool->lock);
+            CompleteStage(graph, index);
+            pthread_cond_broadcast(&pool->wake);
+        }
+
+        pool->graph = NULL;
+        pthread_mutex_unlock(&pool->lock);
+    }
+
+    graph->frameTime = GetMonotonicTime() - startTime;
+    FindCriticalPath(graph);
+}
+
+void ProfileFrameGraph(const FrameGraph *graph) {
+    for (int i = 0; i < graph->stageCount; i++) {
+        const FrameStage *stage = &graph->stages[i];
+        ProfilerRecord(stage->name, "%.3f ms", (stage->endTime - stage->startTime) * 1000);
+        ProfilerHighlight(stage->name, false);
+    }
+
+    for (int i = 0; i < graph->criticalPathLength; i++) {
+        ProfilerHighlight(graph->stages[graph->criticalPath[i]].name, true);
+    }
+
+    ProfilerRecord("update", "%.3f ms", graph->frameTime * 1000);
+    ProfilerRecord("critical path", "%.3f ms", graph->criticalTime * 1000);
+}
@@ -0,0 +1,59 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <pthread.h>
+#include <stdbool.h>
+
+#define FRAME_GRAPH_MAX_STAGES 32
+#define THREAD_POOL_MAX_WORKERS 32
+
+typedef unsigned int ResourceMask;
+typedef void (*StageFunc)(void *context);
+
+typedef struct FrameStage {
+    const char *name;
+    ResourceMask reads;
+    ResourceMask writes;
+    StageFunc run;
+    int dependents[FRAME_GRAPH_MAX_STAGES];
+    int dependentCount;
+    int dependencyCount;
+    int pending;
+    double startTime;
+    double endTime;
+    double pathTime;
+    int criticalParent;
+} FrameStage;
+
+// Stages of one frame; edges are derived from overlapping resource accesses in declaration order
+typedef struct FrameGraph {
+    FrameStage stages[FRAME_GRAPH_MAX_STAGES];
+    int stageCount;
+    void *context;
+    int ready[FRAME_GRAPH_MAX_STAGES];
+    int readyCount;
+    int remaining;
+    int criticalPath[FRAME_GRAPH_MAX_STAGES];
+    int criticalPathLength;
+    double criticalTime;
+    double frameTime;
+} FrameGraph;
+
+typedef struct ThreadPool {
+    pthread_t workers[THREAD_POOL_MAX_WORKERS];
+    int workerCount;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    FrameGraph *graph;
+    bool quit;
+} ThreadPool;
+
+void InitThreadPool(ThreadPool *pool, int workerCount);
+void UnloadThreadPool(ThreadPool *pool);
+int GetDefaultWorkerCount(void);
+void BeginFrameGraph(FrameGraph *graph, void *context);
+int AddFrameStage(FrameGraph *graph, const char *name, ResourceMask reads, ResourceMask writes, StageFunc run);
+void RunFrameGraph(FrameGraph *graph, ThreadPool *pool);
+void ProfileFrameGraph(const FrameGraph *graph);
+
+#endif
@@ -0,0 +1,145 @@
+#include <string.h>
+#include "flightrecorder.h"
+#include "pacing.h"
+#include "profiler.h"
+#include "simulation.h"
+
+void InitInputMailbox(InputMailbox *mailbox) {
+    atomic_init(&mailbox->held, 0);
+    atomic_init(&mailbox->pressed, 0);
+    atomic_init(&mailbox->sequence, 0);
+    atomic_init(&mailbox->spawnPosition, 0);
+}
+
+void PostInput(InputMailbox *mailbox, GameInput input) {
+    if (input.buttons & INPUT_SPAWN_FLOCK) {
+        unsigned long long packed;
+        memcpy(&packed, &input.spawnPosition, sizeof(packed));
+        atomic_store(&mailbox->spawnPosition, packed);
+    }
+
+    atomic_store(&mailbox->held, input.buttons & INPUT_HELD_MASK);
+    atomic_fetch_or(&mailbox->pressed, input.buttons & ~INPUT_HELD_MASK);
+    atomic_store(&mailbox->sequence, input.sequence);
+}
+
+GameInput TakeInput(InputMailbox *mailbox) {
+    GameInput input = { 0 };
+    input.sequence = atomic_load(&mailbox->sequence);
+    input.buttons = atomic_load(&mailbox->held) | atomic_exchange(&mailbox->pressed, 0);
+
+    if (input.buttons & INPUT_SPAWN_FLOCK) {
+        unsigned long long packed = atomic_load(&mailbox->spawnPosition);
+        memcpy(&input.spawnPosition, &packed, sizeof(packed));
+    }
+
+    return input;
+}
+
+// Drops input nobody ticked while the game was suspended, keeping only the held state current
+void DiscardInput(InputMailbox *mailbox, InputThread *events) {
+    GameInput input = TakeInput(mailbox);
+
+    if (events != NULL) {
+        double now = GetMonotonicTime();
+        DrainInputEvents(events, now - TICK_TIME, now, &input);
+    }
+}
+
+static void PublishSnapshot(SimulationThread *simulation) {
+    RenderSnapshot *snapshot = GetTripleBufferWrite(&simulation->snapshots);
+    BuildRenderSnapshot(simulation->game, snapshot);
+    snapshot->publishTime = GetMonotonicTime();
+    PublishTripleBuffer(&simulation->snapshots);
+}
+
+static void *SimulationMain(void *argument) {
+    SimulationThread *simulation = argument;
+    double nextTick = GetMonotonicTime();
+
+    InstallCrashStack();
+
+    while (!atomic_load(&simulation->quit)) {
+        if (atomic_load(&simulation->paused)) {
+            pthread_mutex_lock(&simulation->pauseLock);
+
+            while (atomic_load(&simulation->paused) && !atomic_load(&simulation->quit)) {
+                pthread_cond_wait(&simulation->resume, &simulation->pauseLock);
+            }
+
+            pthread_mutex_unlock(&simulation->pauseLock);
+
+            // The paused time is not simulated, so restart the schedule from now
+            DiscardInput(&simulation->input, simulation->events);
+            nextTick = GetMonotonicTime();
+            continue;
+        }
+
+        double now = GetMonotonicTime();
+
+        if (now < nextTick) {
+            SleepUntil(nextTick);
+            continue;
+        }
+
+        GameInput input = TakeInput(&simulation->input);
+
+        // This tick stands for the interval ending at its deadline, so events up to then belong to it
+        if (simulation->events != NULL) {
+            DrainInputEvents(simulation->events, nextTick - TICK_TIME, nextTick, &input);
+        }
+
+        UpdateGame(simulation->game, input);
+        PublishSnapshot(simulation);
+        ProfilerRecord("sim tick", "%.3f ms", (GetMonotonicTime() - now) * 1000);
+
+        // After a long stall, resume from now instead of replaying every missed tick
+        nextTick += TICK_TIME;
+        if (now - nextTick > 0.25) {
+            nextTick = now;
+        }
+    }
+
+    RemoveCrashStack();
+
+    return NULL;
+}
+
+void StartSimulationThread(SimulationThread *simulation, Game *game, InputThread *events) {
+    simulation->game = game;
+    simulation->events = events;
+    InitTripleBuffer(&simulation->snapshots, sizeof(RenderSnapshot));
+    InitInputMailbox(&simulation->input);
+    atomic_init(&simulation->quit, false);
+    atomic_init(&simulation->paused, false);
+    pthread_mutex_init(&simulation->pauseLock, NULL);
+    pthread_cond_init(&simulation->resume, NULL);
+
+    // The reader must never see an empty slot, so publish the initial state before starting
+    PublishSnapshot(simulation);
+
+    if (pthread_create(&simulation->thread, NULL, SimulationMain, simulation) != 0) {
+        TraceLog(LOG_FATAL, "SIMULATION: Failed to start simulation thread");
+    }
+}
+
+void StopSimulationThread(SimulationThread *simulation) {
+    atomic_store(&simulation->quit, true);
+    SetSimulationPaused(simulation, false);
+    pthread_join(simulation->thread, NULL);
+    pthread_cond_destroy(&simulation->resume);
+    pthread_mutex_destroy(&simulation->pauseLock);
+    UnloadTripleBuffer(&simulation->snapshots);
+}
+
+// A paused simulation thread blocks on a condition variable, so it costs nothing until resumed
+void SetSimulationPaused(SimulationThread *simulation, bool paused) {
+    pthread_mutex_lock(&simulation->pauseLock);
+    atomic_store(&simulation->paused, paused);
+    pthread_cond_signal(&simulation->resume);
+    pthread_mutex_unlock(&simulation->pauseLock);
+}
+
+const RenderSnapshot *AcquireSnapshot(SimulationThread *simulation) {
+    return AcquireTripleBuffer(&simulation->snapshots, NULL);
+}
@@ -0,0 +1,40 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include "game.h"
+#include "input.h"
+#include "triplebuffer.h"
+
+// Latest input from the render thread: held buttons are overwritten, edges accumulate until taken
+typedef struct InputMailbox {
+    atomic_uint held;
+    atomic_uint pressed;
+    atomic_uint sequence;
+    atomic_ullong spawnPosition;
+} InputMailbox;
+
+typedef struct SimulationThread {
+    pthread_t thread;
+    Game *game;
+    TripleBuffer snapshots;
+    InputMailbox input;
+    InputThread *events; // NULL when the keyboard is polled per frame
+    atomic_bool quit;
+    atomic_bool paused;
+    pthread_mutex_t pauseLock;
+    pthread_cond_t resume;
+} SimulationThread;
+
+void InitInputMailbox(InputMailbox *mailbox);
+void PostInput(InputMailbox *mailbox, GameInput input);
+GameInput TakeInput(InputMailbox *mailbox);
+void DiscardInput(InputMailbox *mailbox, InputThread *events);
+void StartSimulationThread(SimulationThread *simulation, Game *game, InputThread *events);
+void StopSimulationThread(SimulationThread *simulation);
+void SetSimulationPaused(SimulationThread *simulation, bool paused);
+const RenderSnapshot *AcquireSnapshot(SimulationThread *simulation);
+
+#endif
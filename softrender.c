@@ -0,0 +1,181 @@
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include "softrender.h"
+
+// Classic 5x7 font, one byte per column with the top row in the lowest bit
+static const unsigned char font[SOFT_FONT_COUNT][5] = {
+    { 0x00, 0x00, 0x00, 0x00, 0x00 }, { 0x00, 0x00, 0x5F, 0x00, 0x00 }, { 0x00, 0x07, 0x00, 0x07, 0x00 }, { 0x14, 0x7F, 0x14, 0x7F, 0x14 },
+    { 0x24, 0x2A, 0x7F, 0x2A, 0x12 }, { 0x23, 0x13, 0x08, 0x64, 0x62 }, { 0x36, 0x49, 0x55, 0x22, 0x50 }, { 0x00, 0x05, 0x03, 0x00, 0x00 },
+    { 0x00, 0x1C, 0x22, 0x41, 0x00 }, { 0x00, 0x41, 0x22, 0x1C, 0x00 }, { 0x14, 0x08, 0x3E, 0x08, 0x14 }, { 0x08, 0x08, 0x3E, 0x08, 0x08 },
+    { 0x00, 0x50, 0x30, 0x00, 0x00 }, { 0x08, 0x08, 0x08, 0x08, 0x08 }, { 0x00, 0x60, 0x60, 0x00, 0x00 }, { 0x20, 0x10, 0x08, 0x04, 0x02 },
+    { 0x3E, 0x51, 0x49, 0x45, 0x3E }, { 0x00, 0x42, 0x7F, 0x40, 0x00 }, { 0x42, 0x61, 0x51, 0x49, 0x46 }, { 0x21, 0x41, 0x45, 0x4B, 0x31 },
+    { 0x18, 0x14, 0x12, 0x7F, 0x10 }, { 0x27, 0x45, 0x45, 0x45, 0x39 }, { 0x3C, 0x4A, 0x49, 0x49, 0x30 }, { 0x01, 0x71, 0x09, 0x05, 0x03 },
+    { 0x36, 0x49, 0x49, 0x49, 0x36 }, { 0x06, 0x49, 0x49, 0x29, 0x1E }, { 0x00, 0x36, 0x36, 0x00, 0x00 }, { 0x00, 0x56, 0x36, 0x00, 0x00 },
+    { 0x08, 0x14, 0x22, 0x41, 0x00 }, { 0x14, 0x14, 0x14, 0x14, 0x14 }, { 0x00, 0x41, 0x22, 0x14, 0x08 }, { 0x02, 0x01, 0x51, 0x09, 0x06 },
+    { 0x32, 0x49, 0x79, 0x41, 0x3E }, { 0x7E, 0x11, 0x11, 0x11, 0x7E }, { 0x7F, 0x49, 0x49, 0x49, 0x36 }, { 0x3E, 0x41, 0x41, 0x41, 0x22 },
+    { 0x7F, 0x41, 0x41, 0x22, 0x1C }, { 0x7F, 0x49, 0x49, 0x49, 0x41 }, { 0x7F, 0x09, 0x09, 0x09, 0x01 }, { 0x3E, 0x41, 0x49, 0x49, 0x7A },
+    { 0x7F, 0x08, 0x08, 0x08, 0x7F }, { 0x00, 0x41, 0x7F, 0x41, 0x00 }, { 0x20, 0x40, 0x41, 0x3F, 0x01 }, { 0x7F, 0x08, 0x14, 0x22, 0x41 },
+    { 0x7F, 0x40, 0x40, 0x40, 0x40 }, { 0x7F, 0x02, 0x0C, 0x02, 0x7F }, { 0x7F, 0x04, 0x08, 0x10, 0x7F }, { 0x3E, 0x41, 0x41, 0x41, 0x3E },
+    { 0x7F, 0x09, 0x09, 0x09, 0x06 }, { 0x3E, 0x41, 0x51, 0x21, 0x5E }, { 0x7F, 0x09, 0x19, 0x29, 0x46 }, { 0x46, 0x49, 0x49, 0x49, 0x31 },
+    { 0x01, 0x01, 0x7F, 0x01, 0x01 }, { 0x3F, 0x40, 0x40, 0x40, 0x3F }, { 0x1F, 0x20, 0x40, 0x20, 0x1F }, { 0x3F, 0x40, 0x38, 0x40, 0x3F },
+    { 0x63, 0x14, 0x08, 0x14, 0x63 }, { 0x07, 0x08, 0x70, 0x08, 0x07 }, { 0x61, 0x51, 0x49, 0x45, 0x43 }, { 0x00, 0x7F, 0x41, 0x41, 0x00 },
+    { 0x02, 0x04, 0x08, 0x10, 0x20 }, { 0x00, 0x41, 0x41, 0x7F, 0x00 }, { 0x04, 0x02, 0x01, 0x02, 0x04 }, { 0x40, 0x40, 0x40, 0x40, 0x40 },
+    { 0x00, 0x01, 0x02, 0x04, 0x00 }, { 0x20, 0x54, 0x54, 0x54, 0x78 }, { 0x7F, 0x48, 0x44, 0x44, 0x38 }, { 0x38, 0x44, 0x44, 0x44, 0x20 },
+    { 0x38, 0x44, 0x44, 0x48, 0x7F }, { 0x38, 0x54, 0x54, 0x54, 0x18 }, { 0x08, 0x7E, 0x09, 0x01, 0x02 }, { 0x0C, 0x52, 0x52, 0x52, 0x3E },
+    { 0x7F, 0x08, 0x04, 0x04, 0x78 }, { 0x00, 0x44, 0x7D, 0x40, 0x00 }, { 0x20, 0x40, 0x44, 0x3D, 0x00 }, { 0x7F, 0x10, 0x28, 0x44, 0x00 },
+    { 0x00, 0x41, 0x7F, 0x40, 0x00 }, { 0x7C, 0x04, 0x18, 0x04, 0x78 }, { 0x7C, 0x08, 0x04, 0x04, 0x78 }, { 0x38, 0x44, 0x44, 0x44, 0x38 },
+    { 0x7C, 0x14, 0x14, 0x14, 0x08 }, { 0x08, 0x14, 0x14, 0x18, 0x7C }, { 0x7C, 0x08, 0x04, 0x04, 0x08 }, { 0x48, 0x54, 0x54, 0x54, 0x20 },
+    { 0x04, 0x3F, 0x44, 0x40, 0x20 }, { 0x3C, 0x40, 0x40, 0x20, 0x7C }, { 0x1C, 0x20, 0x40, 0x20, 0x1C }, { 0x3C, 0x40, 0x30, 0x40, 0x3C },
+    { 0x44, 0x28, 0x10, 0x28, 0x44 }, { 0x0C, 0x50, 0x50, 0x50, 0x3C }, { 0x44, 0x64, 0x54, 0x4C, 0x44 }, { 0x00, 0x08, 0x36, 0x41, 0x00 },
+    { 0x00, 0x00, 0x7F, 0x00, 0x00 }, { 0x00, 0x41, 0x36, 0x08, 0x00 }, { 0x10, 0x08, 0x08, 0x10, 0x08 },
+};
+
+Image LoadSoftCanvas(int width, int height) {
+    return GenImageColor(width, height, BLANK);
+}
+
+static uint32_t PackColor(Color color) {
+    uint32_t packed;
+    memcpy(&packed, &color, sizeof(packed));
+
+    return packed;
+}
+
+static Color BlendColor(Color dst, Color src) {
+    int a = src.a;
+    int inv = 255 - a;
+
+    return (Color){
+        (src.r * a + dst.r * inv) / 255,
+        (src.g * a + dst.g * inv) / 255,
+        (src.b * a + dst.b * inv) / 255,
+        a + dst.a * inv / 255,
+    };
+}
+
+// Every primitive reduces to clipped horizontal spans; opaque spans are a plain 32-bit fill
+static void FillSpan(Image *canvas, int y, int x0, int x1, Color color) {
+    if (y < 0 || y >= canvas->height) {
+        return;
+    }
+
+    if (x0 < 0) {
+        x0 = 0;
+    }
+
+    if (x1 > canvas->width) {
+        x1 = canvas->width;
+    }
+
+    if (x0 >= x1 || color.a == 0) {
+        return;
+    }
+
+    if (color.a == 255) {
+        uint32_t *row = (uint32_t *)canvas->data + (size_t)y * canvas->width;
+        uint32_t packed = PackColor(color);
+
+        for (int x = x0; x < x1; x++) {
+            row[x] = packed;
+        }
+    } else {
+        Color *row = (Color *)canvas->data + (size_t)y * canvas->width;
+
+        for (int x = x0; x < x1; x++) {
+            row[x] = BlendColor(row[x], color);
+        }
+    }
+}
+
+void SoftClear(Image *canvas, Color color) {
+    uint32_t *pixels = canvas->data;
+    uint32_t packed = PackColor(color);
+    size_t count = (size_t)canvas->width * canvas->height;
+
+    for (size_t i = 0; i < count; i++) {
+        pixels[i] = packed;
+    }
+}
+
+void SoftFillRect(Image *canvas, int x, int y, int width, int height, Color color) {
+    for (int row = y; row < y + height; row++) {
+        FillSpan(canvas, row, x, x + width, color);
+    }
+}
+
+void SoftRectLines(Image *canvas, int x, int y, int width, int height, Color color) {
+    FillSpan(canvas, y, x, x + width, color);
+    FillSpan(canvas, y + height - 1, x, x + width, color);
+
+    for (int row = y + 1; row < y + height - 1; row++) {
+        FillSpan(canvas, row, x, x + 1, color);
+        FillSpan(canvas, row, x + width - 1, x + width, color);
+    }
+}
+
+// Covers every pixel whose centre lies inside the circle
+void SoftFillCircle(Image *canvas, Vector2 center, float radius, Color color) {
+    int top = (int)ceilf(center.y - radius - 0.5f);
+    int bottom = (int)floorf(center.y + radius - 0.5f);
+
+    for (int row = top; row <= bottom; row++) {
+        float dy = row + 0.5f - center.y;
+        float squared = radius * radius - dy * dy;
+
+        if (squared < 0) {
+            continue;
+        }
+
+        float half = sqrtf(squared);
+        FillSpan(canvas, row, (int)ceilf(center.x - half - 0.5f), (int)floorf(center.x + half - 0.5f) + 1, color);
+    }
+}
+
+static int GetFontScale(int fontSize) {
+    int scale = fontSize / SOFT_FONT_BASE_SIZE;
+
+    return scale < 1 ? 1 : scale;
+}
+
+void SoftDrawText(Image *canvas, const char *text, int x, int y, int fontSize, Color color) {
+    int scale = GetFontScale(fontSize);
+
+    for (const char *c = text; *c != '\0'; c++, x += 6 * scale) {
+        int glyph = (unsigned char)*c - SOFT_FONT_FIRST;
+
+        if (glyph < 0 || glyph >= SOFT_FONT_COUNT) {
+            continue;
+        }
+
+        for (int column = 0; column < 5; column++) {
+            unsigned char bits = font[glyph][column];
+
+            for (int row = 0; bits != 0; row++, bits >>= 1) {
+                if (bits & 1) {
+                    SoftFillRect(canvas, x + column * scale, y + (row + 1) * scale, scale, scale, color);
+                }
+            }
+        }
+    }
+}
+
+// FNV-1a over 64-bit words: stable across runs, cheap enough to hash every frame
+unsigned long long HashImage(Image image) {
+    size_t size = GetPixelDataSize(image.width, image.height, image.format);
+    const unsigned char *bytes = image.data;
+    uint64_t hash = 0xCBF29CE484222325ull;
+    size_t i = 0;
+
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        memcpy(&word, bytes + i, sizeof(word));
+        hash = (hash ^ word) * 0x100000001B3ull;
+    }
+
+    for (; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 0x100000001B3ull;
+    }
+
+    return hash;
+}
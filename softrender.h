@@ -0,0 +1,19 @@
+#ifndef SOFTRENDER_H
+#define SOFTRENDER_H
+
+#include "raylib.h"
+
+#define SOFT_FONT_FIRST 32
+#define SOFT_FONT_COUNT 95
+#define SOFT_FONT_BASE_SIZE 10 // line height the 5x7 glyphs are designed for, like raylib's default font
+
+// CPU rasterizer drawing straight into an R8G8B8A8 Image; needs no window or GPU
+Image LoadSoftCanvas(int width, int height);
+void SoftClear(Image *canvas, Color color);
+void SoftFillRect(Image *canvas, int x, int y, int width, int height, Color color);
+void SoftRectLines(Image *canvas, int x, int y, int width, int height, Color color);
+void SoftFillCircle(Image *canvas, Vector2 center, float radius, Color color);
+void SoftDrawText(Image *canvas, const char *text, int x, int y, int fontSize, Color color);
+unsigned long long HashImage(Image image);
+
+#endif
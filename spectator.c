@@ -0,0 +1,177 @@
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "raylib.h"
+#include "profiler.h"
+#include "spectator.h"
+
+bool StartSpectatorFeed(SpectatorFeed *feed, const char *name) {
+    memset(feed, 0, sizeof(SpectatorFeed));
+    snprintf(feed->name, sizeof(feed->name), "%s", name);
+
+    // A feed left behind by a crashed game is replaced; its viewers see it stop and reopen
+    shm_unlink(feed->name);
+    int fd = shm_open(feed->name, O_CREAT | O_EXCL | O_RDWR, 0644);
+
+    if (fd < 0 || ftruncate(fd, sizeof(SpectatorRing)) != 0) {
+        TraceLog(LOG_WARNING, "SPECTATOR: [%s] Failed to create feed", feed->name);
+
+        if (fd >= 0) {
+            close(fd);
+            shm_unlink(feed->name);
+        }
+
+        return false;
+    }
+
+    void *mapping = mmap(NULL, sizeof(SpectatorRing), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+    close(fd);
+
+    if (mapping == MAP_FAILED) {
+        TraceLog(LOG_WARNING, "SPECTATOR: [%s] Failed to map feed", feed->name);
+        shm_unlink(feed->name);
+        return false;
+    }
+
+    feed->ring = mapping;
+    feed->ring->version = SPECTATOR_VERSION;
+    feed->ring->snapshotSize = sizeof(RenderSnapshot);
+    atomic_store_explicit(&feed->ring->live, true, memory_order_relaxed);
+    atomic_store_explicit(&feed->ring->magic, SPECTATOR_MAGIC, memory_order_release);
+
+    TraceLog(LOG_INFO, "SPECTATOR: [%s] Feed started, %d KB", feed->name, (int)(sizeof(SpectatorRing) / 1024));
+
+    return true;
+}
+
+void StopSpectatorFeed(SpectatorFeed *feed) {
+    if (feed->ring == NULL) {
+        return;
+    }
+
+    atomic_store_explicit(&feed->ring->live, false, memory_order_release);
+    munmap(feed->ring, sizeof(SpectatorRing));
+    shm_unlink(feed->name);
+    feed->ring = NULL;
+}
+
+// Seqlock write straight into the ring: the snapshot is built in place, so the tick pays for one
+// BuildRenderSnapshot and no copy, and never waits on a viewer
+void PublishSpectatorTick(SpectatorFeed *feed, const Game *game) {
+    unsigned long long published = atomic_load_explicit(&feed->ring->published, memory_order_relaxed);
+    SpectatorSlot *slot = &feed->ring->slots[published % SPECTATOR_SLOTS];
+    unsigned int sequence = atomic_load_explicit(&slot->sequence, memory_order_relaxed);
+
+    atomic_store_explicit(&slot->sequence, sequence + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    BuildRenderSnapshot(game, &slot->snapshot);
+    slot->snapshot.publishTime = GetMonotonicTime();
+
+    atomic_store_explicit(&slot->sequence, sequence + 2, memory_order_release);
+    atomic_store_explicit(&feed->ring->published, published + 1, memory_order_release);
+}
+
+bool OpenSpectatorFeed(SpectatorViewer *viewer, const char *name) {
+    struct stat info;
+
+    memset(viewer, 0, sizeof(SpectatorViewer));
+    snprintf(viewer->name, sizeof(viewer->name), "%s", name);
+    viewer->slot = -1;
+
+    int fd = shm_open(viewer->name, O_RDONLY, 0);
+
+    if (fd < 0 || fstat(fd, &info) != 0 || info.st_size != sizeof(SpectatorRing)) {
+        if (fd >= 0) {
+            close(fd);
+        }
+
+        return false;
+    }
+
+    void *mapping = mmap(NULL, sizeof(SpectatorRing), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+
+    const SpectatorRing *ring = mapping;
+
+    if (atomic_load_explicit(&ring->magic, memory_order_acquire) != SPECTATOR_MAGIC || ring->version != SPECTATOR_VERSION
+        || ring->snapshotSize != sizeof(RenderSnapshot)) {
+        munmap(mapping, sizeof(SpectatorRing));
+        return false;
+    }
+
+    viewer->ring = ring;
+    viewer->lastPublished = atomic_load_explicit(&ring->published, memory_order_acquire);
+    TraceLog(LOG_INFO, "SPECTATOR: [%s] Watching feed", viewer->name);
+
+    return true;
+}
+
+void CloseSpectatorFeed(SpectatorViewer *viewer) {
+    if (viewer->ring != NULL) {
+        munmap((void *)viewer->ring, sizeof(SpectatorRing));
+    }
+
+    viewer->ring = NULL;
+}
+
+// The newest complete tick, read in place. It stays valid until EndSpectatorRead says whether the writer
+// came round to its slot meanwhile; NULL when there is no feed or nothing published yet
+const RenderSnapshot *BeginSpectatorRead(SpectatorViewer *viewer) {
+    if (viewer->ring != NULL && !atomic_load_explicit(&viewer->ring->live, memory_order_acquire)) {
+        TraceLog(LOG_INFO, "SPECTATOR: [%s] Feed stopped", viewer->name);
+        CloseSpectatorFeed(viewer);
+    }
+
+    if (viewer->ring == NULL && !OpenSpectatorFeed(viewer, viewer->name)) {
+        return NULL;
+    }
+
+    for (;;) {
+        unsigned long long published = atomic_load_explicit(&viewer->ring->published, memory_order_acquire);
+
+        if (published == 0) {
+            return NULL;
+        }
+
+        const SpectatorSlot *slot = &viewer->ring->slots[(published - 1) % SPECTATOR_SLOTS];
+        unsigned int sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+
+        // Odd only if the writer lapped the ring since loading published; the next newest is then complete
+        if (sequence & 1) {
+            continue;
+        }
+
+        if (published > viewer->lastPublished + 1) {
+            viewer->skipped += published - viewer->lastPublished - 1;
+        }
+
+        viewer->lastPublished = published;
+        viewer->slot = (published - 1) % SPECTATOR_SLOTS;
+        viewer->sequence = sequence;
+
+        return &slot->snapshot;
+    }
+}
+
+bool EndSpectatorRead(SpectatorViewer *viewer) {
+    if (viewer->ring == NULL || viewer->slot < 0) {
+        return false;
+    }
+
+    atomic_thread_fence(memory_order_acquire);
+    bool intact = atomic_load_explicit(&viewer->ring->slots[viewer->slot].sequence, memory_order_relaxed) == viewer->sequence;
+
+    viewer->reads++;
+    viewer->torn += !intact;
+    viewer->slot = -1;
+
+    return intact;
+}
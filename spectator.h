@@ -0,0 +1,55 @@
+#ifndef SPECTATOR_H
+#define SPECTATOR_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include "game.h"
+
+#define SPECTATOR_DEFAULT_NAME "/space-invaders"
+#define SPECTATOR_SLOTS 16 // ticks a viewer has to finish reading a slot before the writer laps it
+#define SPECTATOR_MAGIC 0x53504543
+#define SPECTATOR_VERSION 1
+#define SPECTATOR_LINE 64
+
+// One tick of render state; sequence is odd while the writer is inside it
+typedef struct SpectatorSlot {
+    _Alignas(SPECTATOR_LINE) atomic_uint sequence;
+    _Alignas(SPECTATOR_LINE) RenderSnapshot snapshot;
+} SpectatorSlot;
+
+// The shared memory object. Viewers map it read-only, so nothing they do can reach the game
+typedef struct SpectatorRing {
+    atomic_uint magic; // stored last by the publisher, so a half-initialised ring is never read
+    unsigned int version;
+    unsigned int snapshotSize; // viewers built from other sources must agree on the layout
+    atomic_bool live; // cleared when the publisher stops; viewers then reopen by name
+    _Alignas(SPECTATOR_LINE) atomic_ullong published; // ticks written; the newest is in slot (published - 1) % SPECTATOR_SLOTS
+    SpectatorSlot slots[SPECTATOR_SLOTS];
+} SpectatorRing;
+
+// Publisher side, owned by the game
+typedef struct SpectatorFeed {
+    SpectatorRing *ring;
+    char name[64];
+} SpectatorFeed;
+
+typedef struct SpectatorViewer {
+    const SpectatorRing *ring;
+    char name[64];
+    unsigned int sequence; // of the slot being read
+    int slot;
+    unsigned long long lastPublished;
+    unsigned long long reads;
+    unsigned long long torn; // reads the writer lapped before they finished
+    unsigned long long skipped; // ticks published that no read saw
+} SpectatorViewer;
+
+bool StartSpectatorFeed(SpectatorFeed *feed, const char *name);
+void StopSpectatorFeed(SpectatorFeed *feed);
+void PublishSpectatorTick(SpectatorFeed *feed, const Game *game);
+bool OpenSpectatorFeed(SpectatorViewer *viewer, const char *name);
+void CloseSpectatorFeed(SpectatorViewer *viewer);
+const RenderSnapshot *BeginSpectatorRead(SpectatorViewer *viewer);
+bool EndSpectatorRead(SpectatorViewer *viewer);
+
+#endif
@@ -0,0 +1,230 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "raylib.h"
+#include "raymath.h"
+#include "rlgl.h"
+#include "starfield.h"
+#include "profiler.h"
+
+#define STAR_GL_UNSIGNED_INT 0x1405 // GL_UNSIGNED_INT; rlgl only names the types raylib itself uses
+
+typedef uint32_t StarLanes __attribute__((vector_size(STARFIELD_LANES * sizeof(uint32_t))));
+
+// Far layers are dense, dim and slow; near ones sparse, bright and fast
+typedef struct StarLayer {
+    float share;
+    float speed; // pixels per second
+    unsigned char brightness;
+    unsigned char size;
+} StarLayer;
+
+// Positions are 0.32 fixed point fractions of the screen, so scrolling wraps by unsigned overflow
+typedef struct Starfield {
+    uint32_t *x;
+    uint32_t *y;
+    Color *look; // brightness in rgb, size in pixels in alpha
+    int layerStart[STARFIELD_LAYERS + 1];
+    int count;
+    int width;
+    int height;
+} Starfield;
+
+static const StarLayer layers[STARFIELD_LAYERS] = {
+    { 0.6f, 8, 90, 1 },
+    { 0.3f, 24, 160, 1 },
+    { 0.1f, 60, 255, 2 },
+};
+
+static const char *vertexSource =
+    "#version 330\n"
+    "in vec2 vertexPosition;\n"
+    "in float starX;\n"
+    "in float starY;\n"
+    "in vec4 starLook;\n"
+    "uniform mat4 mvp;\n"
+    "uniform vec2 screenSize;\n"
+    "out vec4 fragColor;\n"
+    "void main() {\n"
+    "    vec2 corner = floor(vec2(starX, starY) * screenSize) + vertexPosition * starLook.a;\n"
+    "    fragColor = vec4(starLook.rgb / 255.0, 1.0);\n"
+    "    gl_Position = mvp * vec4(corner, 0.0, 1.0);\n"
+    "}\n";
+
+static const char *fragmentSource =
+    "#version 330\n"
+    "in vec4 fragColor;\n"
+    "out vec4 finalColor;\n"
+    "void main() {\n"
+    "    finalColor = fragColor;\n"
+    "}\n";
+
+static Starfield field;
+static unsigned int seed = 0x2545F491;
+
+static Shader shader;
+static unsigned int vao;
+static unsigned int quadBuffer;
+static unsigned int xBuffer;
+static unsigned int yBuffer;
+static unsigned int lookBuffer;
+static int screenSizeLoc;
+static bool rendererReady = false;
+
+static uint32_t RandomBits(void) {
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+
+    return seed;
+}
+
+// Adds one layer's step to every star in it; the lanes wrap on their own when they pass the bottom
+static void ScrollLayer(int start, int end, uint32_t step) {
+    StarLanes *y = (StarLanes *)(field.y + start);
+    int blocks = (end - start) / STARFIELD_LANES;
+
+    for (int i = 0; i < blocks; i++) {
+        y[i] += step;
+    }
+}
+
+// Scatters the stars once; layers are contiguous so each scrolls with a single constant
+bool InitStarfield(int count, int width, int height) {
+    memset(&field, 0, sizeof(field));
+    field.width = width;
+    field.height = height;
+
+    for (int i = 0; i < STARFIELD_LAYERS; i++) {
+        int stars = count * layers[i].share;
+        stars = (stars + STARFIELD_LANES - 1) / STARFIELD_LANES * STARFIELD_LANES;
+        field.layerStart[i] = field.count;
+        field.count += stars;
+    }
+
+    field.layerStart[STARFIELD_LAYERS] = field.count;
+
+    size_t size = (field.count > 0 ? field.count : STARFIELD_LANES) * sizeof(uint32_t);
+    field.x = aligned_alloc(sizeof(StarLanes), size);
+    field.y = aligned_alloc(sizeof(StarLanes), size);
+    field.look = aligned_alloc(sizeof(StarLanes), size);
+
+    if (field.x == NULL || field.y == NULL || field.look == NULL) {
+        TraceLog(LOG_WARNING, "STARFIELD: Failed to allocate %d stars", field.count);
+        UnloadStarfield();
+        return false;
+    }
+
+    for (int l = 0; l < STARFIELD_LAYERS; l++) {
+        for (int i = field.layerStart[l]; i < field.layerStart[l + 1]; i++) {
+            unsigned char brightness = layers[l].brightness;
+            field.x[i] = RandomBits();
+            field.y[i] = RandomBits();
+            field.look[i] = (Color){ brightness, brightness, brightness, layers[l].size };
+        }
+    }
+
+    return true;
+}
+
+// Positions and looks go up once; afterwards only y is streamed
+bool InitStarfieldRenderer(void) {
+    shader = LoadShaderFromMemory(vertexSource, fragmentSource);
+
+    if (!IsShaderReady(shader) || shader.id == rlGetShaderIdDefault()) {
+        TraceLog(LOG_WARNING, "STARFIELD: Shader unavailable, drawing a plain background");
+        return false;
+    }
+
+    const float quad[] = { 0, 0, 0, 1, 1, 1, 0, 0, 1, 1, 1, 0 };
+    int xLoc = GetShaderLocationAttrib(shader, "starX");
+    int yLoc = GetShaderLocationAttrib(shader, "starY");
+    int lookLoc = GetShaderLocationAttrib(shader, "starLook");
+
+    vao = rlLoadVertexArray();
+    rlEnableVertexArray(vao);
+
+    quadBuffer = rlLoadVertexBuffer(quad, sizeof(quad), false);
+    rlSetVertexAttribute(shader.locs[SHADER_LOC_VERTEX_POSITION], 2, RL_FLOAT, false, 0, 0);
+    rlEnableVertexAttribute(shader.locs[SHADER_LOC_VERTEX_POSITION]);
+
+    xBuffer = rlLoadVertexBuffer(field.x, field.count * sizeof(uint32_t), false);
+    rlSetVertexAttribute(xLoc, 1, STAR_GL_UNSIGNED_INT, true, 0, 0);
+    rlEnableVertexAttribute(xLoc);
+    rlSetVertexAttributeDivisor(xLoc, 1);
+
+    yBuffer = rlLoadVertexBuffer(field.y, field.count * sizeof(uint32_t), true);
+    rlSetVertexAttribute(yLoc, 1, STAR_GL_UNSIGNED_INT, true, 0, 0);
+    rlEnableVertexAttribute(yLoc);
+    rlSetVertexAttributeDivisor(yLoc, 1);
+
+    lookBuffer = rlLoadVertexBuffer(field.look, field.count * sizeof(Color), false);
+    rlSetVertexAttribute(lookLoc, 4, RL_UNSIGNED_BYTE, false, 0, 0);
+    rlEnableVertexAttribute(lookLoc);
+    rlSetVertexAttributeDivisor(lookLoc, 1);
+
+    rlDisableVertexArray();
+
+    screenSizeLoc = GetShaderLocation(shader, "screenSize");
+    Vector2 screenSize = { field.width, field.height };
+    SetShaderValue(shader, screenSizeLoc, &screenSize, SHADER_UNIFORM_VEC2);
+    rendererReady = true;
+
+    return true;
+}
+
+void UnloadStarfield(void) {
+    if (rendererReady) {
+        rlUnloadVertexBuffer(lookBuffer);
+        rlUnloadVertexBuffer(yBuffer);
+        rlUnloadVertexBuffer(xBuffer);
+        rlUnloadVertexBuffer(quadBuffer);
+        rlUnloadVertexArray(vao);
+        UnloadShader(shader);
+        rendererReady = false;
+    }
+
+    free(field.x);
+    free(field.y);
+    free(field.look);
+    memset(&field, 0, sizeof(field));
+}
+
+void UpdateStarfield(float frameTime) {
+    if (field.y == NULL) {
+        return;
+    }
+
+    double start = GetMonotonicTime();
+
+    for (int l = 0; l < STARFIELD_LAYERS; l++) {
+        // Pixels per second as a fraction of the screen height in 0.32 fixed point
+        uint32_t step = layers[l].speed * frameTime / field.height * 4294967296.0;
+        ScrollLayer(field.layerStart[l], field.layerStart[l + 1], step);
+    }
+
+    ProfilerRecord("starfield update", "%.3f ms", (GetMonotonicTime() - start) * 1000);
+}
+
+// One instanced draw for every star; call right after the background layer
+void DrawStarfield(void) {
+    if (!rendererReady || field.count == 0) {
+        return;
+    }
+
+    double start = GetMonotonicTime();
+
+    // Flush raylib's batch first so the background it holds lands under the stars
+    rlDrawRenderBatchActive();
+    rlUpdateVertexBuffer(yBuffer, field.y, field.count * sizeof(uint32_t), 0);
+
+    rlEnableShader(shader.id);
+    rlSetUniformMatrix(shader.locs[SHADER_LOC_MATRIX_MVP], MatrixMultiply(rlGetMatrixModelview(), rlGetMatrixProjection()));
+    rlEnableVertexArray(vao);
+    rlDrawVertexArrayInstanced(0, 6, field.count);
+    rlDisableVertexArray();
+    rlDisableShader();
+
+    ProfilerSetCounter("stars", "%.0f", field.count);
+    ProfilerRecord("starfield draw", "%.3f ms", (GetMonotonicTime() - start) * 1000);
+}
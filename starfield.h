@@ -0,0 +1,16 @@
+#ifndef STARFIELD_H
+#define STARFIELD_H
+
+#include <stdbool.h>
+
+#define STARFIELD_DEFAULT_STARS 100000
+#define STARFIELD_LAYERS 3
+#define STARFIELD_LANES 8 // stars scrolled per SIMD step; every layer is padded to a multiple of this
+
+bool InitStarfield(int count, int width, int height);
+bool InitStarfieldRenderer(void);
+void UnloadStarfield(void);
+void UpdateStarfield(float frameTime);
+void DrawStarfield(void);
+
+#endif
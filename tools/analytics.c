@@ -0,0 +1,418 @@
+#include <dirent.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "raylib.h"
+#include "game.h"
+#include "profiler.h"
+#include "replay.h"
+
+#define HEATMAP_CELL 8 // screen pixels per cell
+#define HEATMAP_COLS (SCREEN_WIDTH / HEATMAP_CELL)
+#define HEATMAP_ROWS (SCREEN_HEIGHT / HEATMAP_CELL)
+#define HEATMAP_SCALE 4 // image pixels per cell
+#define ANALYTICS_MAX_THREADS 64
+
+typedef enum HeatmapKind {
+    HEATMAP_PLAYERS, // ticks a player spent over the cell
+    HEATMAP_KILLS,   // enemies shot there
+    HEATMAP_SHOTS,   // where projectiles were fired from
+    HEATMAP_HITS,    // where projectiles struck
+    HEATMAP_COUNT,
+} HeatmapKind;
+
+static const char *heatmapNames[HEATMAP_COUNT] = { "players", "kills", "shots", "hits" };
+
+typedef struct SessionStats {
+    unsigned long long ticks;
+    unsigned long long shots;
+    unsigned long long hits;
+    unsigned long long kills;
+    unsigned int players; // most players in the game at once
+    bool loaded;
+    bool diverged; // the simulation left the recorded hashes, so what follows is not what was played
+} SessionStats;
+
+// One per worker, so the hot loop never shares a cache line; merged once every worker is done
+typedef struct Histograms {
+    unsigned int cells[HEATMAP_COUNT][HEATMAP_ROWS][HEATMAP_COLS];
+    unsigned long long ticks;
+} Histograms;
+
+typedef struct Analytics {
+    char **paths;
+    int pathCount;
+    atomic_int next; // next recording to claim
+    SessionStats *sessions;
+    Histograms *histograms;
+} Analytics;
+
+static void AddCell(Histograms *histograms, HeatmapKind kind, ScalarRectangle body) {
+    int col = (int)((SCALAR_TO_FLOAT(body.x) + SCALAR_TO_FLOAT(body.width) / 2) / HEATMAP_CELL);
+    int row = (int)((SCALAR_TO_FLOAT(body.y) + SCALAR_TO_FLOAT(body.height) / 2) / HEATMAP_CELL);
+
+    if (col >= 0 && col < HEATMAP_COLS && row >= 0 && row < HEATMAP_ROWS) {
+        histograms->cells[kind][row][col]++;
+    }
+}
+
+// Projectiles alive after the previous tick; a shot can hit on the tick it is fired, so new ones are found by entity
+typedef struct ShotTracker {
+    Entity projectiles[MAX_PLAYERS];
+    int count;
+} ShotTracker;
+
+// Entity states change on the tick that sets their start time, so hits and kills are read off the columns after it
+static void CountTick(const Game *game, Histograms *histograms, SessionStats *session, ShotTracker *tracker) {
+    const Archetype *players = &game->world.archetypes[ARCHETYPE_PLAYER];
+    const Archetype *projectiles = &game->world.archetypes[ARCHETYPE_PROJECTILE];
+    const Archetype *enemies = &game->world.archetypes[ARCHETYPE_ENEMY];
+    ScalarRectangle *playerBodies = COLUMN(players, ScalarRectangle, COMPONENT_BODY);
+    ScalarRectangle *projectileBodies = COLUMN(projectiles, ScalarRectangle, COMPONENT_BODY);
+    EntityState *projectileStates = COLUMN(projectiles, EntityState, COMPONENT_STATE);
+    ScalarRectangle *enemyBodies = COLUMN(enemies, ScalarRectangle, COMPONENT_BODY);
+    EntityState *enemyStates = COLUMN(enemies, EntityState, COMPONENT_STATE);
+
+    for (int i = 0; i < players->count; i++) {
+        AddCell(histograms, HEATMAP_PLAYERS, playerBodies[i]);
+    }
+
+    session->players = players->count > (int)session->players ? players->count : session->players;
+
+    for (int i = 0; i < projectiles->count; i++) {
+        bool seen = false;
+
+        for (int j = 0; j < tracker->count && !seen; j++) {
+            seen = tracker->projectiles[j] == projectiles->entities[i];
+        }
+
+        if (!seen) {
+            AddCell(histograms, HEATMAP_SHOTS, projectileBodies[i]);
+            session->shots++;
+        }
+
+        if (projectileStates[i].value == PROJECTILE_STATE_EXPLODING && projectileStates[i].startTime == game->time) {
+            AddCell(histograms, HEATMAP_HITS, projectileBodies[i]);
+            session->hits++;
+        }
+    }
+
+    tracker->count = projectiles->count < MAX_PLAYERS ? projectiles->count : MAX_PLAYERS;
+    memcpy(tracker->projectiles, projectiles->entities, tracker->count * sizeof(Entity));
+
+    for (int i = 0; i < enemies->count; i++) {
+        if (enemyStates[i].value == ENEMY_STATE_DYING && enemyStates[i].startTime == game->time) {
+            AddCell(histograms, HEATMAP_KILLS, enemyBodies[i]);
+            session->kills++;
+        }
+    }
+}
+
+// Plays one recording from its first keyframe to its end through UpdateGame, as --replay does
+static void AnalyzeReplay(const char *path, Game *game, Histograms *histograms, SessionStats *session) {
+    ReplayReader replay;
+
+    InitGame(game);
+    game->profiled = false;
+
+    if (!OpenReplay(&replay, path) || !SeekReplay(&replay, game, replay.index[0].tick)) {
+        CloseReplay(&replay);
+        UnloadGame(game);
+        return;
+    }
+
+    GameInput input;
+    ShotTracker tracker = { .count = 0 };
+    const Archetype *projectiles = &game->world.archetypes[ARCHETYPE_PROJECTILE];
+
+    // Projectiles already in flight at the keyframe were fired before the recording
+    tracker.count = projectiles->count < MAX_PLAYERS ? projectiles->count : MAX_PLAYERS;
+    memcpy(tracker.projectiles, projectiles->entities, tracker.count * sizeof(Entity));
+    session->loaded = true;
+
+    while (NextReplayInput(&replay, &input)) {
+        session->diverged |= !CheckReplayHash(&replay, game);
+
+        UpdateGame(game, input);
+        CountTick(game, histograms, session, &tracker);
+        session->ticks++;
+    }
+
+    histograms->ticks += session->ticks;
+    CloseReplay(&replay);
+    UnloadGame(game);
+}
+
+static void *AnalyticsWorker(void *argument) {
+    Analytics *analytics = ((void **)argument)[0];
+    Histograms *histograms = ((void **)argument)[1];
+    Game game;
+
+    for (;;) {
+        int index = atomic_fetch_add_explicit(&analytics->next, 1, memory_order_relaxed);
+
+        if (index >= analytics->pathCount) {
+            break;
+        }
+
+        AnalyzeReplay(analytics->paths[index], &game, histograms, &analytics->sessions[index]);
+    }
+
+    return NULL;
+}
+
+static bool AddPath(Analytics *analytics, const char *path, int *capacity) {
+    if (analytics->pathCount == *capacity) {
+        *capacity = *capacity ? *capacity * 2 : 256;
+        char **paths = realloc(analytics->paths, *capacity * sizeof(char *));
+
+        if (paths == NULL) {
+            return false;
+        }
+
+        analytics->paths = paths;
+    }
+
+    analytics->paths[analytics->pathCount] = strdup(path);
+
+    return analytics->paths[analytics->pathCount++] != NULL;
+}
+
+// Arguments are recordings or directories of them; directories contribute their *.replay files
+static bool CollectPaths(Analytics *analytics, int count, char **arguments) {
+    int capacity = 0;
+
+    for (int i = 0; i < count; i++) {
+        DIR *directory = opendir(arguments[i]);
+
+        if (directory == NULL) {
+            if (!AddPath(analytics, arguments[i], &capacity)) {
+                return false;
+            }
+
+            continue;
+        }
+
+        struct dirent *entry;
+        char path[4096];
+
+        while ((entry = readdir(directory)) != NULL) {
+            size_t length = strlen(entry->d_name);
+
+            if (length > 7 && strcmp(entry->d_name + length - 7, ".replay") == 0) {
+                snprintf(path, sizeof(path), "%s/%s", arguments[i], entry->d_name);
+
+                if (!AddPath(analytics, path, &capacity)) {
+                    closedir(directory);
+                    return false;
+                }
+            }
+        }
+
+        closedir(directory);
+    }
+
+    return true;
+}
+
+// Log scaled, black through red and yellow to white, so a few hot cells do not wash out the rest
+static Color HeatColor(unsigned int count, unsigned int peak) {
+    if (count == 0) {
+        return BLACK;
+    }
+
+    float heat = logf(1 + count) / logf(1 + peak);
+    float r = heat * 3 < 1 ? heat * 3 : 1;
+    float g = heat * 3 - 1 < 0 ? 0 : heat * 3 - 1 < 1 ? heat * 3 - 1 : 1;
+    float b = heat * 3 - 2 < 0 ? 0 : heat * 3 - 2;
+
+    return (Color){ (unsigned char)(r * 255), (unsigned char)(g * 255), (unsigned char)(b * 255), 255 };
+}
+
+static bool ExportHeatmap(const Histograms *totals, HeatmapKind kind, const char *directory) {
+    Image image = GenImageColor(HEATMAP_COLS * HEATMAP_SCALE, HEATMAP_ROWS * HEATMAP_SCALE, BLACK);
+    unsigned int peak = 0;
+    char path[4096];
+
+    for (int row = 0; row < HEATMAP_ROWS; row++) {
+        for (int col = 0; col < HEATMAP_COLS; col++) {
+            peak = totals->cells[kind][row][col] > peak ? totals->cells[kind][row][col] : peak;
+        }
+    }
+
+    for (int row = 0; row < HEATMAP_ROWS; row++) {
+        for (int col = 0; col < HEATMAP_COLS; col++) {
+            Color color = HeatColor(totals->cells[kind][row][col], peak);
+            ImageDrawRectangle(&image, col * HEATMAP_SCALE, row * HEATMAP_SCALE, HEATMAP_SCALE, HEATMAP_SCALE, color);
+        }
+    }
+
+    snprintf(path, sizeof(path), "%s/%s.png", directory, heatmapNames[kind]);
+    bool ok = ExportImage(image, path);
+    UnloadImage(image);
+
+    return ok;
+}
+
+static bool ExportCsv(const Analytics *analytics, const Histograms *totals, const char *directory) {
+    char path[4096];
+
+    snprintf(path, sizeof(path), "%s/sessions.csv", directory);
+    FILE *sessions = fopen(path, "w");
+    snprintf(path, sizeof(path), "%s/cells.csv", directory);
+    FILE *cells = fopen(path, "w");
+
+    if (sessions == NULL || cells == NULL) {
+        if (sessions != NULL) {
+            fclose(sessions);
+        }
+
+        if (cells != NULL) {
+            fclose(cells);
+        }
+
+        return false;
+    }
+
+    fprintf(sessions, "replay,loaded,diverged,ticks,seconds,players,shots,hits,kills,accuracy\n");
+
+    for (int i = 0; i < analytics->pathCount; i++) {
+        const SessionStats *session = &analytics->sessions[i];
+
+        fprintf(sessions, "%s,%d,%d,%llu,%.2f,%u,%llu,%llu,%llu,%.4f\n", analytics->paths[i], session->loaded, session->diverged,
+            session->ticks, (double)session->ticks / TICK_RATE, session->players, session->shots, session->hits, session->kills,
+            session->shots > 0 ? (double)session->hits / session->shots : 0.0);
+    }
+
+    // Sparse: only cells something happened in
+    fprintf(cells, "x,y,players,kills,shots,hits\n");
+
+    for (int row = 0; row < HEATMAP_ROWS; row++) {
+        for (int col = 0; col < HEATMAP_COLS; col++) {
+            const unsigned int *c[HEATMAP_COUNT];
+            bool empty = true;
+
+            for (int kind = 0; kind < HEATMAP_COUNT; kind++) {
+                c[kind] = &totals->cells[kind][row][col];
+                empty = empty && *c[kind] == 0;
+            }
+
+            if (!empty) {
+                fprintf(cells, "%d,%d,%u,%u,%u,%u\n", col * HEATMAP_CELL, row * HEATMAP_CELL, *c[HEATMAP_PLAYERS], *c[HEATMAP_KILLS],
+                    *c[HEATMAP_SHOTS], *c[HEATMAP_HITS]);
+            }
+        }
+    }
+
+    bool ok = !ferror(sessions) && !ferror(cells);
+
+    return (fclose(sessions) == 0) & (fclose(cells) == 0) && ok;
+}
+
+int main(int argc, char **argv) {
+    static Analytics analytics;
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    int threadCount = cores > 0 ? (int)cores : 1;
+    const char *output = ".";
+    int first = 1;
+
+    for (; first < argc && argv[first][0] == '-'; first++) {
+        if (strcmp(argv[first], "--threads") == 0 && first + 1 < argc) {
+            threadCount = atoi(argv[++first]);
+        } else if (strcmp(argv[first], "--output") == 0 && first + 1 < argc) {
+            output = argv[++first];
+        } else {
+            break;
+        }
+    }
+
+    if (first == argc || threadCount < 1) {
+        fprintf(stderr, "usage: analytics [--threads N] [--output DIR] recordings-or-directories...\n");
+        return 1;
+    }
+
+    threadCount = threadCount < ANALYTICS_MAX_THREADS ? threadCount : ANALYTICS_MAX_THREADS;
+    SetTraceLogLevel(LOG_ERROR);
+
+    if (!CollectPaths(&analytics, argc - first, argv + first) || analytics.pathCount == 0) {
+        fprintf(stderr, "analytics: no recordings found\n");
+        return 1;
+    }
+
+    analytics.sessions = calloc(analytics.pathCount, sizeof(SessionStats));
+    analytics.histograms = calloc(threadCount, sizeof(Histograms));
+
+    if (analytics.sessions == NULL || analytics.histograms == NULL) {
+        fprintf(stderr, "analytics: out of memory\n");
+        return 1;
+    }
+
+    pthread_t threads[ANALYTICS_MAX_THREADS];
+    void *arguments[ANALYTICS_MAX_THREADS][2];
+    double start = GetMonotonicTime();
+    int started = 0;
+
+    // The calling thread is the first worker
+    for (int i = 1; i < threadCount; i++) {
+        arguments[i][0] = &analytics;
+        arguments[i][1] = &analytics.histograms[i];
+
+        if (pthread_create(&threads[i], NULL, AnalyticsWorker, arguments[i]) != 0) {
+            break;
+        }
+
+        started++;
+    }
+
+    arguments[0][0] = &analytics;
+    arguments[0][1] = &analytics.histograms[0];
+    AnalyticsWorker(arguments[0]);
+
+    for (int i = 1; i <= started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    double elapsed = GetMonotonicTime() - start;
+    Histograms *totals = &analytics.histograms[0];
+
+    for (int i = 1; i <= started; i++) {
+        for (int kind = 0; kind < HEATMAP_COUNT; kind++) {
+            for (int row = 0; row < HEATMAP_ROWS; row++) {
+                for (int col = 0; col < HEATMAP_COLS; col++) {
+                    totals->cells[kind][row][col] += analytics.histograms[i].cells[kind][row][col];
+                }
+            }
+        }
+
+        totals->ticks += analytics.histograms[i].ticks;
+    }
+
+    int loaded = 0;
+    int diverged = 0;
+
+    for (int i = 0; i < analytics.pathCount; i++) {
+        loaded += analytics.sessions[i].loaded;
+        diverged += analytics.sessions[i].diverged;
+    }
+
+    bool ok = ExportCsv(&analytics, totals, output);
+
+    for (int kind = 0; kind < HEATMAP_COUNT && ok; kind++) {
+        ok = ExportHeatmap(totals, kind, output);
+    }
+
+    double minutes = (double)totals->ticks / TICK_RATE / 60;
+    printf("analytics: %d of %d recordings, %d diverged, %.1f simulated minutes in %.3f s on %d threads, %.1f minutes/s\n",
+        loaded, analytics.pathCount, diverged, minutes, elapsed, started + 1, minutes / elapsed);
+
+    if (!ok) {
+        fprintf(stderr, "analytics: cannot write the results to %s\n", output);
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,59 @@
+#include <stdio.h>
+#include <string.h>
+#include "eventlog.h"
+#include "pacing.h"
+#include "profiler.h"
+
+#define FOLLOW_INTERVAL 0.1
+
+static void PrintEvent(const GameEvent *event) {
+    printf("%10u %-13s %4d %5u %10u %8.1f %8.1f %d\n", event->tick, GetGameEventName(event->type), event->seat, event->slot,
+        event->entity, event->x, event->y, event->value);
+}
+
+int main(int argc, char **argv) {
+    bool follow = argc == 3 && strcmp(argv[1], "--follow") == 0;
+    EventLogReader reader;
+    GameEvent event;
+    unsigned long long counts[GAME_EVENT_TYPE_COUNT] = { 0 };
+    unsigned long long total = 0;
+
+    if (argc != 2 && !follow) {
+        fprintf(stderr, "usage: eventlog [--follow] events.log\n");
+        return 1;
+    }
+
+    if (!OpenEventLog(&reader, argv[argc - 1])) {
+        fprintf(stderr, "eventlog: cannot read %s or it is not an event log\n", argv[argc - 1]);
+        return 1;
+    }
+
+    printf("%10s %-13s %4s %5s %10s %8s %8s %s\n", "tick", "event", "seat", "slot", "entity", "x", "y", "value");
+
+    // Following never ends on its own; the game keeps appending across sessions
+    for (;;) {
+        while (ReadGameEvent(&reader, &event)) {
+            PrintEvent(&event);
+            counts[event.type < GAME_EVENT_TYPE_COUNT ? event.type : 0]++;
+            total++;
+        }
+
+        if (!follow) {
+            break;
+        }
+
+        fflush(stdout);
+        SleepUntil(GetMonotonicTime() + FOLLOW_INTERVAL);
+    }
+
+    printf("eventlog: %llu events at %u ticks/s", total, reader.header.tickRate);
+
+    for (int type = 1; type < GAME_EVENT_TYPE_COUNT; type++) {
+        printf(", %llu %s", counts[type], GetGameEventName(type));
+    }
+
+    printf("\n");
+    CloseEventLog(&reader);
+
+    return 0;
+}
@@ -0,0 +1,229 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "raylib.h"
+#include "assets.h"
+
+#define ATLAS_WIDTH 512
+#define ATLAS_PADDING 1
+
+#define MAX_ENTRIES (ASSET_MAX_SOURCES * 2 + 2)
+
+static FILE *output;
+static BundleEntry toc[MAX_ENTRIES];
+static int entryCount = 0;
+
+static void PadTo(unsigned int alignment) {
+    static const unsigned char zeros[ASSET_BUNDLE_ALIGNMENT];
+    long position = ftell(output);
+
+    fwrite(zeros, 1, (alignment - position % alignment) % alignment, output);
+}
+
+// Every entry starts on a page boundary so the game can upload it straight from the mapping
+static void WriteEntry(const char *name, BundleEntryType type, const void *data, unsigned int size, int p0, int p1, int p2, int p3) {
+    BundleEntry *entry = &toc[entryCount++];
+
+    PadTo(ASSET_BUNDLE_ALIGNMENT);
+    snprintf(entry->name, ASSET_NAME_LENGTH, "%s", name);
+    entry->type = type;
+    entry->offset = ftell(output);
+    entry->size = size;
+    entry->params[0] = p0;
+    entry->params[1] = p1;
+    entry->params[2] = p2;
+    entry->params[3] = p3;
+    fwrite(data, 1, size, output);
+}
+
+static int CompareHeight(const void *a, const void *b) {
+    const Image *left = *(Image *const *)a;
+    const Image *right = *(Image *const *)b;
+
+    return right->height - left->height;
+}
+
+// Shelf packing, tallest first; the atlas height is rounded up to a power of two
+static bool PackSprites(const AssetSource *sources, int count) {
+    static Image images[ASSET_MAX_SOURCES];
+    static Image *order[ASSET_MAX_SOURCES];
+    static BundleSprite sprites[ASSET_MAX_SOURCES];
+    int spriteCount = 0;
+
+    for (int i = 0; i < count; i++) {
+        if (sources[i].kind != ASSET_SPRITE) {
+            continue;
+        }
+
+        Image *image = &images[spriteCount];
+        *image = LoadImage(sources[i].path);
+
+        if (image->data == NULL || image->width + ATLAS_PADDING > ATLAS_WIDTH) {
+            fprintf(stderr, "packbundle: %s: cannot be loaded or is wider than the atlas\n", sources[i].path);
+            return false;
+        }
+
+        ImageFormat(image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+        snprintf(sprites[spriteCount].name, ASSET_NAME_LENGTH, "%s", sources[i].name);
+        order[spriteCount] = image;
+        spriteCount++;
+    }
+
+    if (spriteCount == 0) {
+        return true;
+    }
+
+    qsort(order, spriteCount, sizeof(Image *), CompareHeight);
+
+    int x = 0;
+    int y = 0;
+    int shelfHeight = 0;
+
+    for (int i = 0; i < spriteCount; i++) {
+        Image *image = order[i];
+        BundleSprite *sprite = &sprites[image - images];
+
+        if (x + image->width + ATLAS_PADDING > ATLAS_WIDTH) {
+            x = 0;
+            y += shelfHeight;
+            shelfHeight = 0;
+        }
+
+        sprite->source = (Rectangle){ x + ATLAS_PADDING, y + ATLAS_PADDING, image->width, image->height };
+        x += image->width + ATLAS_PADDING;
+
+        if (image->height + ATLAS_PADDING > shelfHeight) {
+            shelfHeight = image->height + ATLAS_PADDING;
+        }
+    }
+
+    int height = 1;
+    while (height < y + shelfHeight + ATLAS_PADDING) {
+        height *= 2;
+    }
+
+    Image atlas = GenImageColor(ATLAS_WIDTH, height, BLANK);
+
+    // Plain row copies; ImageDraw would blend edges against the transparent background
+    for (int i = 0; i < spriteCount; i++) {
+        BundleSprite *sprite = &sprites[i];
+        Image *image = &images[i];
+
+        for (int row = 0; row < image->height; row++) {
+            Color *to = (Color *)atlas.data + (int)(sprite->source.y + row) * ATLAS_WIDTH + (int)sprite->source.x;
+            memcpy(to, (Color *)image->data + row * image->width, image->width * sizeof(Color));
+        }
+
+        sprite->u0 = sprite->source.x / ATLAS_WIDTH;
+        sprite->v0 = sprite->source.y / height;
+        sprite->u1 = (sprite->source.x + sprite->source.width) / ATLAS_WIDTH;
+        sprite->v1 = (sprite->source.y + sprite->source.height) / height;
+        UnloadImage(*image);
+    }
+
+    WriteEntry(ASSET_ATLAS_NAME, BUNDLE_IMAGE, atlas.data, GetPixelDataSize(atlas.width, atlas.height, atlas.format), atlas.width, atlas.height, atlas.format, 0);
+    WriteEntry(ASSET_ATLAS_NAME, BUNDLE_SPRITES, sprites, spriteCount * sizeof(BundleSprite), spriteCount, 0, 0, 0);
+    printf("packbundle: %d sprites in a %dx%d atlas\n", spriteCount, atlas.width, atlas.height);
+    UnloadImage(atlas);
+
+    return true;
+}
+
+static bool PackSound(const AssetSource *source) {
+    Wave wave = LoadWave(source->path);
+
+    if (wave.data == NULL) {
+        fprintf(stderr, "packbundle: %s: cannot be decoded\n", source->path);
+        return false;
+    }
+
+    WriteEntry(source->name, BUNDLE_WAVE, wave.data, wave.frameCount * wave.channels * (wave.sampleSize / 8), wave.frameCount, wave.sampleRate, wave.sampleSize, wave.channels);
+    UnloadWave(wave);
+
+    return true;
+}
+
+// Rasterizes the glyphs offline; the game only uploads the atlas
+static bool PackFont(const AssetSource *source) {
+    static BundleGlyph glyphs[ASSET_FONT_GLYPHS];
+    static unsigned char table[ASSET_FONT_GLYPHS * (sizeof(BundleGlyph) + sizeof(Rectangle))];
+    int dataSize = 0;
+    unsigned char *data = LoadFileData(source->path, &dataSize);
+    GlyphInfo *info = data != NULL ? LoadFontData(data, dataSize, source->fontSize, NULL, ASSET_FONT_GLYPHS, FONT_DEFAULT) : NULL;
+
+    if (info == NULL) {
+        fprintf(stderr, "packbundle: %s: cannot be rasterized\n", source->path);
+        UnloadFileData(data);
+        return false;
+    }
+
+    Rectangle *recs = NULL;
+    Image atlas = GenImageFontAtlas(info, &recs, ASSET_FONT_GLYPHS, source->fontSize, ASSET_FONT_PADDING, 0);
+
+    for (int i = 0; i < ASSET_FONT_GLYPHS; i++) {
+        glyphs[i] = (BundleGlyph){ info[i].value, info[i].offsetX, info[i].offsetY, info[i].advanceX };
+    }
+
+    memcpy(table, glyphs, sizeof(glyphs));
+    memcpy(table + sizeof(glyphs), recs, ASSET_FONT_GLYPHS * sizeof(Rectangle));
+
+    WriteEntry(source->name, BUNDLE_IMAGE, atlas.data, GetPixelDataSize(atlas.width, atlas.height, atlas.format), atlas.width, atlas.height, atlas.format, 0);
+    WriteEntry(source->name, BUNDLE_GLYPHS, table, sizeof(table), ASSET_FONT_GLYPHS, source->fontSize, ASSET_FONT_PADDING, 0);
+
+    UnloadImage(atlas);
+    MemFree(recs);
+    UnloadFontData(info, ASSET_FONT_GLYPHS);
+    UnloadFileData(data);
+
+    return true;
+}
+
+// Packs everything in the manifest into one bundle: header, page-aligned entries, then the table of contents
+int main(int argc, char **argv) {
+    static AssetSource sources[ASSET_MAX_SOURCES];
+
+    if (argc != 3) {
+        fprintf(stderr, "usage: packbundle manifest.txt output.bundle\n");
+        return 1;
+    }
+
+    SetTraceLogLevel(LOG_WARNING);
+
+    int count = ReadAssetManifest(argv[1], sources, ASSET_MAX_SOURCES);
+    output = fopen(argv[2], "wb");
+
+    if (count < 0 || output == NULL) {
+        fprintf(stderr, "packbundle: cannot read %s or write %s\n", argv[1], argv[2]);
+        return 1;
+    }
+
+    BundleHeader header = { ASSET_BUNDLE_MAGIC, ASSET_BUNDLE_VERSION, 0, 0 };
+    fwrite(&header, sizeof(header), 1, output);
+
+    bool ok = PackSprites(sources, count);
+
+    for (int i = 0; i < count && ok; i++) {
+        if (sources[i].kind == ASSET_SOUND) {
+            ok = PackSound(&sources[i]);
+        } else if (sources[i].kind == ASSET_FONT) {
+            ok = PackFont(&sources[i]);
+        }
+    }
+
+    PadTo(16);
+    header.entryCount = entryCount;
+    header.tocOffset = ftell(output);
+    fwrite(toc, sizeof(BundleEntry), entryCount, output);
+    fseek(output, 0, SEEK_SET);
+    fwrite(&header, sizeof(header), 1, output);
+    fseek(output, 0, SEEK_END);
+    printf("packbundle: %d entries, %ld bytes\n", entryCount, ftell(output));
+    fclose(output);
+
+    if (!ok) {
+        remove(argv[2]);
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,375 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "raylib.h"
+#include "game.h"
+#include "profiler.h"
+
+#define SWEEP_MAX_VALUES 64 // per parameter
+#define SWEEP_MAX_THREADS 64
+#define SWEEP_DEFAULT_SECONDS 120
+#define AUTOPILOT_DEAD_ZONE 4.0f // pixels off target the autopilot stops steering at
+
+typedef enum SweepParameter {
+    SWEEP_MAX_H_SPEED,
+    SWEEP_MAX_V_SPEED,
+    SWEEP_MAX_FORCE,
+    SWEEP_AWARENESS,
+    SWEEP_PARAMETER_COUNT,
+} SweepParameter;
+
+static const char *parameterFlags[SWEEP_PARAMETER_COUNT] = { "--max-h-speed", "--max-v-speed", "--max-force", "--awareness" };
+static const char *parameterColumns[SWEEP_PARAMETER_COUNT] = { "max_h_speed", "max_v_speed", "max_force", "awareness" };
+
+typedef struct SweepAxis {
+    float values[SWEEP_MAX_VALUES];
+    int count;
+} SweepAxis;
+
+typedef struct SweepResult {
+    Tuning tuning;
+    unsigned int seed;
+    unsigned long long ticks;
+    unsigned long long clearTick; // 0 while the wave stands
+    int shots;
+    int kills;
+    int livesLost;
+    double nsPerTick;
+} SweepResult;
+
+typedef struct Sweep {
+    SweepAxis axes[SWEEP_PARAMETER_COUNT];
+    int seeds;
+    unsigned long long maxTicks;
+    int runCount; // every combination of the axes, times seeds
+    atomic_int next;
+    SweepResult *results;
+} Sweep;
+
+// xorshift32; the simulation itself has no randomness, so seeds only vary the spawn and the autopilot's aim
+static unsigned int NextRandom(unsigned int *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+
+    return *state;
+}
+
+// "a,b,c" or "first:last:step"
+static bool ParseAxis(SweepAxis *axis, const char *text) {
+    float first, last, step;
+    axis->count = 0;
+
+    if (sscanf(text, "%f:%f:%f", &first, &last, &step) == 3) {
+        if (step <= 0) {
+            return false;
+        }
+
+        for (float value = first; value <= last + step * 0.001f && axis->count < SWEEP_MAX_VALUES; value += step) {
+            axis->values[axis->count++] = value;
+        }
+
+        return axis->count > 0;
+    }
+
+    while (*text != '\0' && axis->count < SWEEP_MAX_VALUES) {
+        char *end;
+        axis->values[axis->count++] = strtof(text, &end);
+
+        if (end == text || (*end != ',' && *end != '\0')) {
+            return false;
+        }
+
+        text = *end == ',' ? end + 1 : end;
+    }
+
+    return axis->count > 0;
+}
+
+// Steers under the lowest live enemy and fires once lined up. The seed picks a fixed aim error per target
+static GameInput GetAutopilotInput(const Game *game, unsigned int *random, Entity *target, float *aimOffset) {
+    const Archetype *enemies = &game->world.archetypes[ARCHETYPE_ENEMY];
+    ScalarRectangle *bodies = COLUMN(enemies, ScalarRectangle, COMPONENT_BODY);
+    EntityState *states = COLUMN(enemies, EntityState, COMPONENT_STATE);
+    const ScalarRectangle *player = GetComponent((World *)&game->world, game->player, COMPONENT_BODY);
+    GameInput input = { 0 };
+    int lowest = -1;
+
+    input.sequence = game->tick;
+
+    if (player == NULL) {
+        return input;
+    }
+
+    for (int i = 0; i < enemies->count; i++) {
+        if (states[i].value == ENEMY_STATE_ACTIVE && (lowest < 0 || bodies[i].y > bodies[lowest].y)) {
+            lowest = i;
+        }
+    }
+
+    if (lowest < 0) {
+        return input;
+    }
+
+    if (enemies->entities[lowest] != *target) {
+        *target = enemies->entities[lowest];
+        *aimOffset = (NextRandom(random) % 1000 / 1000.0f - 0.5f) * ENEMY_SIZE * 0.5f;
+    }
+
+    float aim = SCALAR_TO_FLOAT(bodies[lowest].x + bodies[lowest].width / 2) + *aimOffset;
+    float dx = aim - SCALAR_TO_FLOAT(player->x + player->width / 2);
+
+    if (dx < -AUTOPILOT_DEAD_ZONE) {
+        input.buttons |= INPUT_LEFT;
+    } else if (dx > AUTOPILOT_DEAD_ZONE) {
+        input.buttons |= INPUT_RIGHT;
+    }
+
+    if (dx > -ENEMY_SIZE / 2 && dx < ENEMY_SIZE / 2) {
+        input.buttons |= INPUT_FIRE;
+    }
+
+    return input;
+}
+
+// One combination and seed, from a fresh game until the wave is cleared or the tick budget runs out
+static void RunSweep(const Sweep *sweep, SweepResult *result, Game *game) {
+    unsigned int random = result->seed * 2654435761u + 1;
+    Entity target = ENTITY_NONE;
+    float aimOffset = 0;
+    double simulationTime = 0;
+
+    InitGame(game);
+    game->profiled = false;
+    game->tuning.maxHSpeed = result->tuning.maxHSpeed;
+    game->tuning.maxVSpeed = result->tuning.maxVSpeed;
+    game->tuning.maxForce = result->tuning.maxForce;
+    game->tuning.flockAwarenessDistance = result->tuning.flockAwarenessDistance;
+    game->hud.tuning = game->tuning;
+    RehashGame(game);
+
+    // The first tick respawns the flock at a seeded spot along the top
+    GameInput input = { 0 };
+    input.buttons = INPUT_SPAWN_FLOCK;
+    input.spawnPosition.x = SCALAR_TO_FLOAT(game->boundaries.x) + NextRandom(&random) % (int)(SCALAR_TO_FLOAT(game->boundaries.width) / 2);
+    input.spawnPosition.y = SCALAR_TO_FLOAT(game->boundaries.y);
+
+    Entity lastProjectile = ENTITY_NONE;
+
+    while (result->ticks < sweep->maxTicks) {
+        double tickStart = GetMonotonicTime();
+        UpdateGame(game, input);
+        simulationTime += GetMonotonicTime() - tickStart;
+        result->ticks++;
+
+        Pilot *pilot = GetComponent(&game->world, game->player, COMPONENT_PILOT);
+
+        if (pilot != NULL) {
+            result->shots += pilot->projectile != ENTITY_NONE && pilot->projectile != lastProjectile;
+            lastProjectile = pilot->projectile;
+            result->kills = pilot->score / 10;
+            result->livesLost = PLAYER_MAX_LIVES - pilot->lives;
+        }
+
+        if (game->world.archetypes[ARCHETYPE_ENEMY].count == 0) {
+            result->clearTick = game->tick;
+            break;
+        }
+
+        input = GetAutopilotInput(game, &random, &target, &aimOffset);
+    }
+
+    result->nsPerTick = result->ticks > 0 ? simulationTime / result->ticks * 1e9 : 0;
+    UnloadGame(game);
+}
+
+static void *SweepWorker(void *argument) {
+    Sweep *sweep = argument;
+    Game game;
+
+    for (;;) {
+        int index = atomic_fetch_add_explicit(&sweep->next, 1, memory_order_relaxed);
+
+        if (index >= sweep->runCount) {
+            break;
+        }
+
+        RunSweep(sweep, &sweep->results[index], &game);
+    }
+
+    return NULL;
+}
+
+// Runs are numbered seed fastest, then awareness, force, vertical and horizontal speed
+static void ListRuns(Sweep *sweep) {
+    int index = 0;
+
+    for (int h = 0; h < sweep->axes[SWEEP_MAX_H_SPEED].count; h++) {
+        for (int v = 0; v < sweep->axes[SWEEP_MAX_V_SPEED].count; v++) {
+            for (int f = 0; f < sweep->axes[SWEEP_MAX_FORCE].count; f++) {
+                for (int a = 0; a < sweep->axes[SWEEP_AWARENESS].count; a++) {
+                    for (int s = 0; s < sweep->seeds; s++) {
+                        SweepResult *result = &sweep->results[index++];
+
+                        result->tuning.maxHSpeed = sweep->axes[SWEEP_MAX_H_SPEED].values[h];
+                        result->tuning.maxVSpeed = sweep->axes[SWEEP_MAX_V_SPEED].values[v];
+                        result->tuning.maxForce = sweep->axes[SWEEP_MAX_FORCE].values[f];
+                        result->tuning.flockAwarenessDistance = sweep->axes[SWEEP_AWARENESS].values[a];
+                        result->seed = s + 1;
+                    }
+                }
+            }
+        }
+    }
+}
+
+static bool ExportSweep(const Sweep *sweep, const char *path) {
+    FILE *file = fopen(path, "w");
+
+    if (file == NULL) {
+        return false;
+    }
+
+    for (int p = 0; p < SWEEP_PARAMETER_COUNT; p++) {
+        fprintf(file, "%s,", parameterColumns[p]);
+    }
+
+    fprintf(file, "seed,cleared,clear_ticks,clear_seconds,ticks,shots,kills,accuracy,lives_lost,sim_ns_per_tick\n");
+
+    for (int i = 0; i < sweep->runCount; i++) {
+        const SweepResult *result = &sweep->results[i];
+
+        fprintf(file, "%g,%g,%g,%g,%u,%d,", result->tuning.maxHSpeed, result->tuning.maxVSpeed, result->tuning.maxForce,
+            result->tuning.flockAwarenessDistance, result->seed, result->clearTick > 0);
+
+        if (result->clearTick > 0) {
+            fprintf(file, "%llu,%.3f,", result->clearTick, (double)result->clearTick / TICK_RATE);
+        } else {
+            fprintf(file, ",,");
+        }
+
+        fprintf(file, "%llu,%d,%d,%.4f,%d,%.0f\n", result->ticks, result->shots, result->kills,
+            result->shots > 0 ? (double)result->kills / result->shots : 0.0, result->livesLost, result->nsPerTick);
+    }
+
+    bool ok = !ferror(file);
+
+    return fclose(file) == 0 && ok;
+}
+
+int main(int argc, char **argv) {
+    static Sweep sweep;
+    Game defaults;
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    int threadCount = cores > 0 ? (int)cores : 1;
+    int seconds = SWEEP_DEFAULT_SECONDS;
+    const char *output = "sweep.csv";
+    bool ok = true;
+
+    SetTraceLogLevel(LOG_ERROR);
+
+    // Parameters left out of the grid keep the value the game starts with
+    InitGame(&defaults);
+    float starting[SWEEP_PARAMETER_COUNT] = { defaults.tuning.maxHSpeed, defaults.tuning.maxVSpeed, defaults.tuning.maxForce,
+        defaults.tuning.flockAwarenessDistance };
+    UnloadGame(&defaults);
+
+    for (int p = 0; p < SWEEP_PARAMETER_COUNT; p++) {
+        sweep.axes[p].values[0] = starting[p];
+        sweep.axes[p].count = 1;
+    }
+
+    sweep.seeds = 1;
+
+    for (int i = 1; i < argc && ok; i++) {
+        bool matched = false;
+
+        for (int p = 0; p < SWEEP_PARAMETER_COUNT && !matched; p++) {
+            if (strcmp(argv[i], parameterFlags[p]) == 0 && i + 1 < argc) {
+                ok = ParseAxis(&sweep.axes[p], argv[++i]);
+                matched = true;
+            }
+        }
+
+        if (matched) {
+            continue;
+        }
+
+        if (strcmp(argv[i], "--seeds") == 0 && i + 1 < argc) {
+            sweep.seeds = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            seconds = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threadCount = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            output = argv[++i];
+        } else {
+            ok = false;
+        }
+    }
+
+    if (!ok || sweep.seeds < 1 || seconds < 1 || threadCount < 1) {
+        fprintf(stderr, "usage: sweep [--max-h-speed V] [--max-v-speed V] [--max-force V] [--awareness V] [--seeds K]\n"
+            "             [--seconds S] [--threads N] [--output sweep.csv]\n"
+            "values are a,b,c or first:last:step; parameters left out keep their starting value\n");
+        return 1;
+    }
+
+    threadCount = threadCount < SWEEP_MAX_THREADS ? threadCount : SWEEP_MAX_THREADS;
+    sweep.maxTicks = (unsigned long long)seconds * TICK_RATE;
+    sweep.runCount = sweep.seeds;
+
+    for (int p = 0; p < SWEEP_PARAMETER_COUNT; p++) {
+        sweep.runCount *= sweep.axes[p].count;
+    }
+
+    sweep.results = calloc(sweep.runCount, sizeof(SweepResult));
+
+    if (sweep.results == NULL) {
+        fprintf(stderr, "sweep: out of memory\n");
+        return 1;
+    }
+
+    ListRuns(&sweep);
+
+    pthread_t threads[SWEEP_MAX_THREADS];
+    double start = GetMonotonicTime();
+    int started = 0;
+
+    // The calling thread is the first worker
+    for (int i = 1; i < threadCount; i++) {
+        if (pthread_create(&threads[i], NULL, SweepWorker, &sweep) != 0) {
+            break;
+        }
+
+        started++;
+    }
+
+    SweepWorker(&sweep);
+
+    for (int i = 1; i <= started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    double elapsed = GetMonotonicTime() - start;
+    unsigned long long ticks = 0;
+    int cleared = 0;
+
+    for (int i = 0; i < sweep.runCount; i++) {
+        ticks += sweep.results[i].ticks;
+        cleared += sweep.results[i].clearTick > 0;
+    }
+
+    printf("sweep: %d runs, %d cleared the wave, %llu ticks in %.3f s on %d threads, %.0f ticks/s\n", sweep.runCount, cleared, ticks,
+        elapsed, started + 1, ticks / elapsed);
+
+    if (!ExportSweep(&sweep, output)) {
+        fprintf(stderr, "sweep: cannot write %s\n", output);
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,51 @@
+#include <stdlib.h>
+#include "raylib.h"
+#include "triplebuffer.h"
+
+void InitTripleBuffer(TripleBuffer *buffer, size_t size) {
+    for (int i = 0; i < 3; i++) {
+        buffer->slots[i] = calloc(1, size);
+
+        if (buffer->slots[i] == NULL) {
+            TraceLog(LOG_FATAL, "TRIPLEBUFFER: Failed to allocate %zu bytes", size);
+        }
+    }
+
+    buffer->front = 0;
+    buffer->back = 1;
+    atomic_init(&buffer->middle, 2);
+}
+
+void UnloadTripleBuffer(TripleBuffer *buffer) {
+    for (int i = 0; i < 3; i++) {
+        free(buffer->slots[i]);
+        buffer->slots[i] = NULL;
+    }
+}
+
+void *GetTripleBufferWrite(TripleBuffer *buffer) {
+    return buffer->slots[buffer->back];
+}
+
+// Hands the written slot to the reader and takes back whichever slot sat in the middle
+void PublishTripleBuffer(TripleBuffer *buffer) {
+    unsigned int previous = atomic_exchange_explicit(&buffer->middle, buffer->back | TRIPLE_BUFFER_FRESH, memory_order_acq_rel);
+    buffer->back = previous & 3;
+}
+
+// Returns the newest published slot; it stays valid until the next call
+void *AcquireTripleBuffer(TripleBuffer *buffer, bool *fresh) {
+    bool swapped = false;
+
+    if (atomic_load_explicit(&buffer->middle, memory_order_acquire) & TRIPLE_BUFFER_FRESH) {
+        unsigned int previous = atomic_exchange_explicit(&buffer->middle, buffer->front, memory_order_acq_rel);
+        buffer->front = previous & 3;
+        swapped = true;
+    }
+
+    if (fresh != NULL) {
+        *fresh = swapped;
+    }
+
+    return buffer->slots[buffer->front];
+}
@@ -0,0 +1,24 @@
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define TRIPLE_BUFFER_FRESH 4u
+
+// Single writer, single reader; neither side ever waits for the other
+typedef struct TripleBuffer {
+    void *slots[3];
+    atomic_uint middle; // slot index, plus TRIPLE_BUFFER_FRESH when unread
+    unsigned int back;  // owned by the writer
+    unsigned int front; // owned by the reader
+} TripleBuffer;
+
+void InitTripleBuffer(TripleBuffer *buffer, size_t size);
+void UnloadTripleBuffer(TripleBuffer *buffer);
+void *GetTripleBufferWrite(TripleBuffer *buffer);
+void PublishTripleBuffer(TripleBuffer *buffer);
+void *AcquireTripleBuffer(TripleBuffer *buffer, bool *fresh);
+
+#endif